@@ -0,0 +1,217 @@
+#include "channel_db.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CHANNEL_DB_TEMP_SUFFIX  ".tmp"
+
+static uint32_t databaseCrc(const ChannelDbHeader* header, const ChannelDbService* services);
+static bool writeAll(int32_t fileDesc, const void* data, size_t length);
+
+ChannelDbError channelDbOpen(const char* path, ChannelDb* db)
+{
+    struct stat fileStat;
+    int32_t fileDesc;
+    const ChannelDbHeader* header;
+
+    if (path == NULL || db == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CHANNEL_DB_ERROR;
+    }
+    memset(db, 0x0, sizeof(ChannelDb));
+
+    fileDesc = open(path, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        return CHANNEL_DB_NOT_FOUND;
+    }
+
+    if (fstat(fileDesc, &fileStat) || fileStat.st_size < (off_t)sizeof(ChannelDbHeader))
+    {
+        close(fileDesc);
+        return CHANNEL_DB_CORRUPTED;
+    }
+
+    db->mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDesc, 0);
+    close(fileDesc);
+    if (db->mapping == MAP_FAILED)
+    {
+        db->mapping = NULL;
+        printf("\n%s : ERROR mmap fail\n", __FUNCTION__);
+        return CHANNEL_DB_ERROR;
+    }
+    db->size = fileStat.st_size;
+
+    header = (const ChannelDbHeader*)db->mapping;
+    if (header->magic != CHANNEL_DB_MAGIC || header->version != CHANNEL_DB_VERSION ||
+        header->serviceSize != sizeof(ChannelDbService))
+    {
+        channelDbClose(db);
+        return CHANNEL_DB_NOT_FOUND;
+    }
+
+    if (db->size != sizeof(ChannelDbHeader) + header->serviceCount * sizeof(ChannelDbService) ||
+        header->serviceCount > TABLES_MAX_NUMBER_OF_PIDS_IN_PAT)
+    {
+        channelDbClose(db);
+        return CHANNEL_DB_CORRUPTED;
+    }
+
+    db->header = header;
+    db->services = (const ChannelDbService*)(header + 1);
+
+    if (databaseCrc(db->header, db->services) != header->crc)
+    {
+        channelDbClose(db);
+        return CHANNEL_DB_CORRUPTED;
+    }
+
+    return CHANNEL_DB_NO_ERROR;
+}
+
+void channelDbClose(ChannelDb* db)
+{
+    if (db != NULL && db->mapping != NULL)
+    {
+        munmap(db->mapping, db->size);
+        memset(db, 0x0, sizeof(ChannelDb));
+    }
+}
+
+ChannelDbError channelDbSave(const char* path, ChannelDbHeader* header, const ChannelDbService* services)
+{
+    char tempPath[256];
+    int32_t fileDesc;
+    bool written;
+
+    if (path == NULL || header == NULL || (services == NULL && header->serviceCount != 0) ||
+        header->serviceCount > TABLES_MAX_NUMBER_OF_PIDS_IN_PAT)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CHANNEL_DB_ERROR;
+    }
+
+    header->magic = CHANNEL_DB_MAGIC;
+    header->version = CHANNEL_DB_VERSION;
+    header->serviceSize = sizeof(ChannelDbService);
+    header->reserved = 0;
+    header->crc = databaseCrc(header, services);
+
+    snprintf(tempPath, sizeof(tempPath), "%s%s", path, CHANNEL_DB_TEMP_SUFFIX);
+    fileDesc = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDesc == -1)
+    {
+        printf("\n%s : ERROR Cannot create %s\n", __FUNCTION__, tempPath);
+        return CHANNEL_DB_ERROR;
+    }
+
+    /* data has to reach storage before rename makes it visible */
+    written = writeAll(fileDesc, header, sizeof(ChannelDbHeader)) &&
+              writeAll(fileDesc, services, header->serviceCount * sizeof(ChannelDbService)) &&
+              fsync(fileDesc) == 0;
+    close(fileDesc);
+
+    if (!written || rename(tempPath, path))
+    {
+        printf("\n%s : ERROR Cannot write %s\n", __FUNCTION__, path);
+        unlink(tempPath);
+        return CHANNEL_DB_ERROR;
+    }
+
+    return CHANNEL_DB_NO_ERROR;
+}
+
+void channelDbServiceFromTables(ChannelDbService* service, const PatServiceInfo* patServiceInfo, const PmtTable* pmtTable)
+{
+    uint8_t i;
+
+    memset(service, 0x0, sizeof(ChannelDbService));
+    service->programNumber = patServiceInfo->programNumber;
+    service->pmtPid = patServiceInfo->pid;
+
+    if (pmtTable == NULL)
+    {
+        return;
+    }
+
+    service->pmtValid = 1;
+    service->pcrPid = pmtTable->pmtHeader.pcrPid;
+    service->streamCount = pmtTable->elementaryInfoCount;
+    for (i = 0; i < pmtTable->elementaryInfoCount; i++)
+    {
+        service->streams[i].streamType = pmtTable->pmtElementaryInfoArray[i].streamType;
+        service->streams[i].elementaryPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
+        if (pmtEsIsTeletext(pmtTable, i))
+        {
+            service->streams[i].flags |= CHANNEL_DB_STREAM_TELETEXT;
+        }
+    }
+}
+
+bool channelDbServiceToTables(const ChannelDbService* service, PatServiceInfo* patServiceInfo, PmtTable* pmtTable)
+{
+    uint16_t esDescriptorsLength = 0;
+    uint8_t i;
+
+    patServiceInfo->programNumber = service->programNumber;
+    patServiceInfo->pid = service->pmtPid;
+
+    memset(pmtTable, 0x0, sizeof(PmtTable));
+    if (!service->pmtValid || service->streamCount > TABLES_MAX_NUMBER_OF_ELEMENTARY_PID)
+    {
+        return false;
+    }
+
+    pmtTable->pmtHeader.tableId = 0x02;
+    pmtTable->pmtHeader.programNumber = service->programNumber;
+    pmtTable->pmtHeader.pcrPid = service->pcrPid;
+    pmtTable->elementaryInfoCount = service->streamCount;
+    for (i = 0; i < service->streamCount; i++)
+    {
+        pmtTable->pmtElementaryInfoArray[i].streamType = service->streams[i].streamType;
+        pmtTable->pmtElementaryInfoArray[i].elementaryPid = service->streams[i].elementaryPid;
+        /* teletext_descriptor without pages is enough to detect teletext */
+        if (service->streams[i].flags & CHANNEL_DB_STREAM_TELETEXT)
+        {
+            pmtTable->pmtElementaryInfoArray[i].esDescriptorsOffset = esDescriptorsLength;
+            pmtTable->pmtElementaryInfoArray[i].esInfoLength = 2;
+            pmtTable->esDescriptors[esDescriptorsLength++] = DESCRIPTOR_TELETEXT;
+            pmtTable->esDescriptors[esDescriptorsLength++] = 0;
+        }
+    }
+
+    return true;
+}
+
+uint32_t databaseCrc(const ChannelDbHeader* header, const ChannelDbService* services)
+{
+    uint32_t crc;
+
+    crc = crc32Mpeg2Slice8(CRC32_MPEG2_INIT, (const uint8_t*)header, offsetof(ChannelDbHeader, crc));
+
+    return crc32Mpeg2Slice8(crc, (const uint8_t*)services, header->serviceCount * sizeof(ChannelDbService));
+}
+
+bool writeAll(int32_t fileDesc, const void* data, size_t length)
+{
+    const uint8_t* position = (const uint8_t*)data;
+    ssize_t written;
+
+    while (length > 0)
+    {
+        written = write(fileDesc, position, length);
+        if (written <= 0)
+        {
+            return false;
+        }
+        position += written;
+        length -= written;
+    }
+
+    return true;
+}
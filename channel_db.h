@@ -0,0 +1,135 @@
+#ifndef __CHANNEL_DB_H__
+#define __CHANNEL_DB_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "tables.h"
+
+#define CHANNEL_DB_FILE_NAME    "channels.db"       /* Database file, written into directory of config file */
+#define CHANNEL_DB_MAGIC        0x42444843          /* "CHDB" in file byte order */
+#define CHANNEL_DB_VERSION      2                   /* Incremented on every layout change */
+#define CHANNEL_DB_STREAM_TELETEXT  0x01            /* Stream flag, private PES with teletext_descriptor */
+
+/*
+ * File layout, native byte order:
+ *
+ *   ChannelDbHeader
+ *   ChannelDbService[serviceCount]
+ *
+ * The file is replaced atomically (temporary file and rename), a reader never
+ * sees a partially written database. CRC_32 covers header fields before it and
+ * all service records.
+ */
+
+/**
+ * @brief Enumeration of possible channel database error codes
+ */
+typedef enum _ChannelDbError
+{
+    CHANNEL_DB_NO_ERROR = 0,
+    CHANNEL_DB_ERROR,
+    CHANNEL_DB_NOT_FOUND,                           /* No database, or it was written by other version */
+    CHANNEL_DB_CORRUPTED                            /* Size or CRC_32 mismatch */
+}ChannelDbError;
+
+/**
+ * @brief Structure that defines one elementary stream of service
+ */
+typedef struct _ChannelDbStream
+{
+    uint8_t streamType;
+    uint8_t flags;                                  /* CHANNEL_DB_STREAM_ flags */
+    uint16_t elementaryPid;
+}ChannelDbStream;
+
+/**
+ * @brief Structure that defines one service record
+ */
+typedef struct _ChannelDbService
+{
+    uint16_t programNumber;
+    uint16_t pmtPid;                                /* PMT pid, or NIT pid for program 0 */
+    uint16_t pcrPid;
+    uint8_t pmtValid;                               /* Streams below come from received PMT */
+    uint8_t streamCount;
+    ChannelDbStream streams[TABLES_MAX_NUMBER_OF_ELEMENTARY_PID];
+}ChannelDbService;
+
+/**
+ * @brief Structure that defines database header
+ */
+typedef struct _ChannelDbHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t serviceSize;                           /* sizeof(ChannelDbService) of writer */
+    uint32_t frequency;                             /* Tuner frequency in Hz the services belong to */
+    uint16_t transportStreamId;
+    uint8_t serviceCount;
+    uint8_t reserved;
+    int16_t lastChannel;
+    int16_t volumeLevel;
+    uint32_t crc;
+}ChannelDbHeader;
+
+/**
+ * @brief Structure that defines memory mapped database
+ */
+typedef struct _ChannelDb
+{
+    void* mapping;
+    size_t size;
+    const ChannelDbHeader* header;
+    const ChannelDbService* services;               /* serviceCount records, read only */
+}ChannelDb;
+
+/**
+ * @brief Maps database file and validates it
+ *
+ * @param [in] path - database file path
+ * @param [out] db - mapped database, valid until channelDbClose
+ * @return channel database error code
+ */
+ChannelDbError channelDbOpen(const char* path, ChannelDb* db);
+
+/**
+ * @brief Unmaps database file
+ *
+ * @param [in] db - mapped database
+ */
+void channelDbClose(ChannelDb* db);
+
+/**
+ * @brief Writes database, previous file is replaced only when new one is complete
+ *
+ * magic, version, serviceSize and crc of header are filled in.
+ *
+ * @param [in] path - database file path
+ * @param [in] header - database header
+ * @param [in] services - header->serviceCount service records
+ * @return channel database error code
+ */
+ChannelDbError channelDbSave(const char* path, ChannelDbHeader* header, const ChannelDbService* services);
+
+/**
+ * @brief Fills service record from PAT entry and PMT
+ *
+ * @param [out] service - service record
+ * @param [in] patServiceInfo - service entry of PAT
+ * @param [in] pmtTable - PMT of service, NULL if PMT is not known
+ */
+void channelDbServiceFromTables(ChannelDbService* service, const PatServiceInfo* patServiceInfo, const PmtTable* pmtTable);
+
+/**
+ * @brief Fills PAT entry and PMT from service record
+ *
+ * @param [in] service - service record
+ * @param [out] patServiceInfo - service entry of PAT
+ * @param [out] pmtTable - PMT of service, only elementary streams, pcr pid and teletext_descriptor of teletext streams are set
+ * @return true if record holds PMT
+ */
+bool channelDbServiceToTables(const ChannelDbService* service, PatServiceInfo* patServiceInfo, PmtTable* pmtTable);
+
+#endif /* __CHANNEL_DB_H__ */
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include "stream_controller.h"
 #include "config_parser.h"
+#include "section_ring.h"
 
 static FILE* configOpen(char* configFile);
 static ConfigErrorCode parseAttribute(char* tag, char* value, InitConfig* config);
@@ -54,6 +55,7 @@ ConfigErrorCode parseConfigFile(char* configFile, InitConfig* config)
 	printf("\nTV module :%d", config->configModule);
 	printf("\nAudio type :%d", config->configAudioType);
 	printf("\nVideo type :%d", config->configVideoType);
+	printf("\nSection ring size :%d", config->configSectionRingSize);
 
 	fclose(fp);
 
@@ -86,6 +88,19 @@ ConfigErrorCode parseAttribute(char* tag, char* value, InitConfig* config)
 	{
 		config->configProgramNumber = getAttributeValue(value);
 	}		
+
+	if (!strcmp(tag,"SECTION_RING_SIZE"))
+	{
+		int32_t ringSize = getAttributeValue(value);
+
+		/* out of range size falls back to default ring */
+		if (ringSize < 0 || ringSize > SECTION_RING_MAX_SLOTS)
+		{
+			printf("\n%s : ERROR section ring size %d out of range 0-%d, default is used\n", __FUNCTION__, ringSize, SECTION_RING_MAX_SLOTS);
+			ringSize = 0;
+		}
+		config->configSectionRingSize = ringSize;
+	}
 	
 	if (!strcmp(tag,"TV_MODULE"))
 	{
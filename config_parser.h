@@ -4,7 +4,7 @@
 #include <stdio.h>
 
 #define CONFIG_LINE_LEN 50
-#define CONFIG_VAL_LEN 8
+#define CONFIG_VAL_LEN 12
 
 /**
  * @brief Enumeration of possible config parser error codes
@@ -0,0 +1,241 @@
+#include "crc32.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC32_HAVE_CLMUL
+#include <immintrin.h>
+#endif
+
+#define CRC32_CLMUL_MIN_LENGTH  64              /* Shorter data is not worth folding */
+
+typedef uint32_t(*Crc32Kernel)(const uint8_t* data, uint32_t length);
+
+static uint32_t crcTable[8][256];
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static Crc32Kernel kernel = NULL;
+static const char* kernelName = "none";
+
+static void buildTables();
+static uint32_t slice8Kernel(const uint8_t* data, uint32_t length);
+static uint32_t xPowerModP(uint32_t power);
+
+static inline uint32_t load32BigEndian(const uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+#ifdef CRC32_HAVE_CLMUL
+static uint64_t foldConstants[4];               /* x^128, x^192, x^512, x^576 mod P */
+static uint32_t clmulKernel(const uint8_t* data, uint32_t length);
+#endif
+
+void crc32Init()
+{
+    pthread_once(&initOnce, buildTables);
+}
+
+uint32_t crc32Mpeg2(const uint8_t* data, uint32_t length)
+{
+    crc32Init();
+    return kernel(data, length);
+}
+
+uint32_t crc32Mpeg2Slice8(uint32_t crc, const uint8_t* data, uint32_t length)
+{
+    uint32_t high;
+    uint32_t low;
+
+    crc32Init();
+
+    /* eight bytes per step, each byte has its own table */
+    while (length >= 8)
+    {
+        high = crc ^ load32BigEndian(data);
+        low = load32BigEndian(data + 4);
+        crc = crcTable[7][high >> 24] ^ crcTable[6][(high >> 16) & 0xFF] ^
+              crcTable[5][(high >> 8) & 0xFF] ^ crcTable[4][high & 0xFF] ^
+              crcTable[3][low >> 24] ^ crcTable[2][(low >> 16) & 0xFF] ^
+              crcTable[1][(low >> 8) & 0xFF] ^ crcTable[0][low & 0xFF];
+        data += 8;
+        length -= 8;
+    }
+
+    while (length--)
+    {
+        crc = (crc << 8) ^ crcTable[0][(crc >> 24) ^ *data++];
+    }
+
+    return crc;
+}
+
+uint32_t crc32Mpeg2Clmul(const uint8_t* data, uint32_t length)
+{
+    crc32Init();
+#ifdef CRC32_HAVE_CLMUL
+    if (kernel == clmulKernel)
+    {
+        return clmulKernel(data, length);
+    }
+#endif
+    return slice8Kernel(data, length);
+}
+
+const char* crc32KernelName()
+{
+    crc32Init();
+    return kernelName;
+}
+
+bool crc32SectionValid(const uint8_t* sectionBuffer)
+{
+    uint16_t sectionLength;
+
+    if (sectionBuffer == NULL)
+    {
+        return false;
+    }
+
+    /* sections without syntax indicator have no CRC_32 */
+    if (!(sectionBuffer[1] & 0x80))
+    {
+        return true;
+    }
+
+    sectionLength = ((sectionBuffer[1] & 0x0F) << 8) | sectionBuffer[2];
+    if (sectionLength < 4)
+    {
+        return false;
+    }
+
+    return crc32Mpeg2(sectionBuffer, sectionLength + 3) == 0;
+}
+
+void buildTables()
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t crc;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i << 24;
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ CRC32_MPEG2_POLYNOMIAL : crc << 1;
+        }
+        crcTable[0][i] = crc;
+    }
+
+    /* table k gives CRC of byte followed by k zero bytes */
+    for (i = 0; i < 256; i++)
+    {
+        for (j = 1; j < 8; j++)
+        {
+            crcTable[j][i] = (crcTable[j - 1][i] << 8) ^ crcTable[0][crcTable[j - 1][i] >> 24];
+        }
+    }
+
+    kernel = slice8Kernel;
+    kernelName = "slicing-by-8";
+
+#ifdef CRC32_HAVE_CLMUL
+    foldConstants[0] = xPowerModP(128);
+    foldConstants[1] = xPowerModP(192);
+    foldConstants[2] = xPowerModP(512);
+    foldConstants[3] = xPowerModP(576);
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3"))
+    {
+        kernel = clmulKernel;
+        kernelName = "pclmul";
+    }
+#endif
+}
+
+uint32_t slice8Kernel(const uint8_t* data, uint32_t length)
+{
+    return crc32Mpeg2Slice8(CRC32_MPEG2_INIT, data, length);
+}
+
+/* Returns x^power mod P, power has to be at least 32 */
+uint32_t xPowerModP(uint32_t power)
+{
+    uint32_t remainder = CRC32_MPEG2_POLYNOMIAL;    /* x^32 mod P */
+
+    for (power -= 32; power > 0; power--)
+    {
+        remainder = (remainder & 0x80000000) ? (remainder << 1) ^ CRC32_MPEG2_POLYNOMIAL : remainder << 1;
+    }
+
+    return remainder;
+}
+
+#ifdef CRC32_HAVE_CLMUL
+/*
+ * 128 bit blocks are loaded byte reversed so that first message bit is the
+ * highest polynomial coefficient. Block A followed by n bits is congruent to
+ * A_high * (x^(n+64) mod P) + A_low * (x^n mod P), which is at most 96 bits
+ * wide, so four independent accumulators are folded 512 bits forward, then
+ * folded into one, and the last 128 bits go through the table kernel.
+ */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i fold(__m128i accumulator, __m128i constants)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(accumulator, constants, 0x00),
+                         _mm_clmulepi64_si128(accumulator, constants, 0x11));
+}
+
+__attribute__((target("pclmul,ssse3")))
+uint32_t clmulKernel(const uint8_t* data, uint32_t length)
+{
+    const __m128i byteSwap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i fold128 = _mm_set_epi64x((long long)foldConstants[1], (long long)foldConstants[0]);
+    const __m128i fold512 = _mm_set_epi64x((long long)foldConstants[3], (long long)foldConstants[2]);
+    __m128i x0, x1, x2, x3;
+    uint8_t last[16];
+    uint32_t crc;
+
+    if (length < CRC32_CLMUL_MIN_LENGTH)
+    {
+        return crc32Mpeg2Slice8(CRC32_MPEG2_INIT, data, length);
+    }
+
+    x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), byteSwap);
+    x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), byteSwap);
+    x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), byteSwap);
+    x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), byteSwap);
+
+    /* initial value is the same as inverted first 32 message bits */
+    x0 = _mm_xor_si128(x0, _mm_set_epi32((int)CRC32_MPEG2_INIT, 0, 0, 0));
+    data += 64;
+    length -= 64;
+
+    while (length >= 64)
+    {
+        x0 = _mm_xor_si128(fold(x0, fold512), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), byteSwap));
+        x1 = _mm_xor_si128(fold(x1, fold512), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), byteSwap));
+        x2 = _mm_xor_si128(fold(x2, fold512), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), byteSwap));
+        x3 = _mm_xor_si128(fold(x3, fold512), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), byteSwap));
+        data += 64;
+        length -= 64;
+    }
+
+    x0 = _mm_xor_si128(fold(x0, fold128), x1);
+    x0 = _mm_xor_si128(fold(x0, fold128), x2);
+    x0 = _mm_xor_si128(fold(x0, fold128), x3);
+
+    while (length >= 16)
+    {
+        x0 = _mm_xor_si128(fold(x0, fold128), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), byteSwap));
+        data += 16;
+        length -= 16;
+    }
+
+    _mm_storeu_si128((__m128i*)last, _mm_shuffle_epi8(x0, byteSwap));
+    crc = crc32Mpeg2Slice8(0, last, sizeof(last));
+
+    return crc32Mpeg2Slice8(crc, data, length);
+}
+#endif
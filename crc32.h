@@ -0,0 +1,65 @@
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CRC32_MPEG2_POLYNOMIAL  0x04C11DB7      /* CRC32/MPEG-2 generator polynomial */
+#define CRC32_MPEG2_INIT        0xFFFFFFFF      /* CRC32/MPEG-2 initial value */
+
+/**
+ * @brief Builds lookup tables and selects fastest kernel for this CPU
+ *
+ * Called implicitly by crc32Mpeg2, can be called upfront to keep it off the section path.
+ */
+void crc32Init();
+
+/**
+ * @brief Calculates CRC32/MPEG-2 using fastest available kernel
+ *
+ * @param [in] data - data buffer
+ * @param [in] length - number of bytes
+ * @return CRC32/MPEG-2 of data
+ */
+uint32_t crc32Mpeg2(const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Calculates CRC32/MPEG-2 with table driven slicing-by-8 kernel
+ *
+ * @param [in] crc - initial CRC, CRC32_MPEG2_INIT or CRC of previous data
+ * @param [in] data - data buffer
+ * @param [in] length - number of bytes
+ * @return CRC32/MPEG-2 of data
+ */
+uint32_t crc32Mpeg2Slice8(uint32_t crc, const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Calculates CRC32/MPEG-2 with carry-less multiply folding kernel
+ *
+ * Falls back to slicing-by-8 when CPU has no carry-less multiply instruction.
+ *
+ * @param [in] data - data buffer
+ * @param [in] length - number of bytes
+ * @return CRC32/MPEG-2 of data
+ */
+uint32_t crc32Mpeg2Clmul(const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Returns name of kernel selected by crc32Init
+ *
+ * @return kernel name
+ */
+const char* crc32KernelName();
+
+/**
+ * @brief Checks CRC_32 of PSI/SI section with section_syntax_indicator set
+ *
+ * CRC over whole section including CRC_32 field is zero for a valid section.
+ *
+ * @param [in] sectionBuffer - section starting with table_id
+ * @return true if section CRC is valid
+ */
+bool crc32SectionValid(const uint8_t* sectionBuffer);
+
+#endif /* __CRC32_H__ */
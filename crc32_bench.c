@@ -0,0 +1,98 @@
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * CRC32/MPEG-2 microbenchmark, prints throughput of every kernel for
+ * typical PSI section sizes and for a large buffer.
+ *
+ * usage: crc32_bench [megabytes per run]
+ */
+
+#define BENCH_DEFAULT_MB    256
+#define BENCH_MAX_LENGTH    (1024 * 1024)
+
+typedef uint32_t(*BenchKernel)(const uint8_t* data, uint32_t length);
+
+static volatile uint32_t benchSink;     /* Keeps results alive */
+
+static uint32_t slice8(const uint8_t* data, uint32_t length);
+static double benchKernel(BenchKernel kernel, const uint8_t* data, uint32_t length, uint64_t totalBytes, uint32_t* crc);
+
+int main(int argc, char* argv[])
+{
+    static const uint32_t lengths[] = {188, 1024, 4096, BENCH_MAX_LENGTH};
+    uint64_t totalBytes = (uint64_t)(argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_MB) * 1024 * 1024;
+    uint8_t* data;
+    uint32_t crcSlice8;
+    uint32_t crcClmul;
+    double gbSlice8;
+    double gbClmul;
+    uint32_t i;
+
+    data = (uint8_t*)malloc(BENCH_MAX_LENGTH);
+    if (data == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return 1;
+    }
+    srand(1);
+    for (i = 0; i < BENCH_MAX_LENGTH; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+
+    /* check value of CRC32/MPEG-2 */
+    if (crc32Mpeg2((const uint8_t*)"123456789", 9) != 0x0376E6E7)
+    {
+        printf("\nERROR CRC32/MPEG-2 check value mismatch\n");
+        return 1;
+    }
+
+    printf("selected kernel: %s\n", crc32KernelName());
+    printf("length     | slicing-by-8 GB/s | clmul GB/s\n");
+
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        gbSlice8 = benchKernel(slice8, data, lengths[i], totalBytes, &crcSlice8);
+        gbClmul = benchKernel(crc32Mpeg2Clmul, data, lengths[i], totalBytes, &crcClmul);
+        if (crcSlice8 != crcClmul)
+        {
+            printf("\nERROR kernels disagree for length %u\n", lengths[i]);
+            return 1;
+        }
+        printf("%-10u | %17.2f | %10.2f\n", lengths[i], gbSlice8, gbClmul);
+    }
+
+    free(data);
+
+    return 0;
+}
+
+uint32_t slice8(const uint8_t* data, uint32_t length)
+{
+    return crc32Mpeg2Slice8(CRC32_MPEG2_INIT, data, length);
+}
+
+/* Returns GB/s of kernel over totalBytes processed in chunks of length */
+double benchKernel(BenchKernel kernel, const uint8_t* data, uint32_t length, uint64_t totalBytes, uint32_t* crc)
+{
+    struct timespec startTime;
+    struct timespec endTime;
+    uint64_t processed = 0;
+    double seconds;
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    while (processed < totalBytes)
+    {
+        benchSink ^= kernel(data, length);
+        processed += length;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+    *crc = kernel(data, length);
+    seconds = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+
+    return processed / seconds / 1e9;
+}
@@ -0,0 +1,930 @@
+#include "directfb.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <png.h>
+
+/*
+ * Settings are read from environment when DirectFB is created:
+ *  DFB_SIM_WIDTH, DFB_SIM_HEIGHT - primary surface size (default 1280x720)
+ *  DFB_SIM_FONT                  - font file used for every CreateFont, font
+ *                                  path used on the target does not exist on host
+ *  DFB_SIM_DUMP_DIR              - every flip of primary surface is written
+ *                                  to this directory as frame_NNNNN.ppm
+ */
+
+#define SIM_DEFAULT_WIDTH       1280
+#define SIM_DEFAULT_HEIGHT      720
+#define SIM_DEFAULT_FONT_HEIGHT 24
+#define SIM_GLYPH_CACHE_SIZE    256         /* Code points below this are rendered once per font */
+#define SIM_PATH_LEN            256
+
+/**
+ * @brief Structure that defines one rendered glyph
+ */
+typedef struct _SimGlyph
+{
+    uint8_t* bitmap;                        /* 8 bit coverage */
+    int32_t width;
+    int32_t rows;
+    int32_t left;                           /* Offset from pen position to bitmap */
+    int32_t top;                            /* Offset from baseline up to bitmap top */
+    int32_t advance;
+    bool loaded;
+}SimGlyph;
+
+/**
+ * @brief Structure that defines font, interface has to be first member
+ */
+typedef struct _SimFont
+{
+    IDirectFBFont iface;
+    FT_Face face;
+    int32_t ascender;
+    int32_t height;
+    SimGlyph glyphs[SIM_GLYPH_CACHE_SIZE];
+    SimGlyph scratch;                       /* Last glyph outside of cache */
+}SimFont;
+
+/**
+ * @brief Structure that defines surface, interface has to be first member
+ */
+typedef struct _SimSurface
+{
+    IDirectFBSurface iface;
+    uint32_t* back;                         /* Buffer that is drawn to */
+    uint32_t* front;                        /* Displayed buffer of primary, same as back otherwise */
+    int32_t width;
+    int32_t height;
+    DFBRegion clip;
+    uint32_t color;
+    DFBSurfaceBlittingFlags blittingFlags;
+    SimFont* font;
+    bool primary;
+}SimSurface;
+
+/**
+ * @brief Structure that defines image provider, interface has to be first member
+ */
+typedef struct _SimImageProvider
+{
+    IDirectFBImageProvider iface;
+    uint32_t* pixels;
+    int32_t width;
+    int32_t height;
+}SimImageProvider;
+
+static IDirectFB dfbInterface;
+static FT_Library freetype = NULL;
+static int32_t screenWidth = SIM_DEFAULT_WIDTH;
+static int32_t screenHeight = SIM_DEFAULT_HEIGHT;
+static const char* fontFile = NULL;
+static const char* dumpDir = NULL;
+static uint32_t frameCount = 0;
+
+static DFBResult dfbRelease(IDirectFB* thiz);
+static DFBResult dfbSetCooperativeLevel(IDirectFB* thiz, DFBCooperativeLevel level);
+static DFBResult dfbCreateSurface(IDirectFB* thiz, const DFBSurfaceDescription* desc, IDirectFBSurface** ret_interface);
+static DFBResult dfbCreateFont(IDirectFB* thiz, const char* filename, const DFBFontDescription* desc, IDirectFBFont** ret_interface);
+static DFBResult dfbCreateImageProvider(IDirectFB* thiz, const char* filename, IDirectFBImageProvider** ret_interface);
+
+static DFBResult surfaceRelease(IDirectFBSurface* thiz);
+static DFBResult surfaceGetSize(IDirectFBSurface* thiz, int* ret_width, int* ret_height);
+static DFBResult surfaceSetClip(IDirectFBSurface* thiz, const DFBRegion* clip);
+static DFBResult surfaceSetColor(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+static DFBResult surfaceClear(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+static DFBResult surfaceFillRectangle(IDirectFBSurface* thiz, int x, int y, int w, int h);
+static DFBResult surfaceSetBlittingFlags(IDirectFBSurface* thiz, DFBSurfaceBlittingFlags flags);
+static DFBResult surfaceBlit(IDirectFBSurface* thiz, IDirectFBSurface* source, const DFBRectangle* source_rect, int x, int y);
+static DFBResult surfaceSetFont(IDirectFBSurface* thiz, IDirectFBFont* font);
+static DFBResult surfaceDrawString(IDirectFBSurface* thiz, const char* text, int bytes, int x, int y, DFBSurfaceTextFlags flags);
+static DFBResult surfaceFlip(IDirectFBSurface* thiz, const DFBRegion* region, DFBSurfaceFlipFlags flags);
+
+static DFBResult fontRelease(IDirectFBFont* thiz);
+static DFBResult fontGetAscender(IDirectFBFont* thiz, int* ret_ascender);
+static DFBResult fontGetHeight(IDirectFBFont* thiz, int* ret_height);
+static DFBResult fontGetStringWidth(IDirectFBFont* thiz, const char* text, int bytes, int* ret_width);
+
+static DFBResult providerRelease(IDirectFBImageProvider* thiz);
+static DFBResult providerGetSurfaceDescription(IDirectFBImageProvider* thiz, DFBSurfaceDescription* ret_desc);
+static DFBResult providerRenderTo(IDirectFBImageProvider* thiz, IDirectFBSurface* destination, const DFBRectangle* destination_rect);
+
+static void fillRect(SimSurface* surface, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+static bool clipRect(const DFBRegion* clip, int32_t* x, int32_t* y, int32_t* w, int32_t* h);
+static inline uint32_t blendPixel(uint32_t source, uint32_t alpha, uint32_t destination);
+static const SimGlyph* getGlyph(SimFont* font, uint32_t codePoint);
+static void freeGlyph(SimGlyph* glyph);
+static uint32_t nextCodePoint(const uint8_t** text, const uint8_t* end);
+static int32_t stringWidth(SimFont* font, const char* text, int32_t bytes);
+static void dumpFrame(SimSurface* surface);
+
+
+DFBResult DirectFBInit(int* argc, char** argv[])
+{
+    return DFB_OK;
+}
+
+DFBResult DirectFBCreate(IDirectFB** ret_interface)
+{
+    const char* value;
+
+    if (ret_interface == NULL)
+    {
+        return DFB_INVARG;
+    }
+
+    if ((value = getenv("DFB_SIM_WIDTH")) != NULL && atoi(value) > 0)
+    {
+        screenWidth = atoi(value);
+    }
+    if ((value = getenv("DFB_SIM_HEIGHT")) != NULL && atoi(value) > 0)
+    {
+        screenHeight = atoi(value);
+    }
+    fontFile = getenv("DFB_SIM_FONT");
+    dumpDir = getenv("DFB_SIM_DUMP_DIR");
+
+    if (freetype == NULL && FT_Init_FreeType(&freetype))
+    {
+        printf("\n%s : ERROR FT_Init_FreeType fail\n", __FUNCTION__);
+        return DFB_FAILURE;
+    }
+
+    dfbInterface.Release = dfbRelease;
+    dfbInterface.SetCooperativeLevel = dfbSetCooperativeLevel;
+    dfbInterface.CreateSurface = dfbCreateSurface;
+    dfbInterface.CreateFont = dfbCreateFont;
+    dfbInterface.CreateImageProvider = dfbCreateImageProvider;
+    *ret_interface = &dfbInterface;
+
+    return DFB_OK;
+}
+
+const char* DirectFBErrorString(DFBResult result)
+{
+    switch (result)
+    {
+        case DFB_OK:
+            return "Everything ok";
+        case DFB_INVARG:
+            return "Invalid argument";
+        case DFB_NOSYSTEMMEMORY:
+            return "Out of memory";
+        case DFB_FILENOTFOUND:
+            return "File not found";
+        case DFB_UNSUPPORTED:
+            return "Unsupported";
+        default:
+            return "General failure";
+    }
+}
+
+DFBResult DirectFBErrorFatal(const char* msg, DFBResult result)
+{
+    fprintf(stderr, "(!!!)  *** %s: %s\n", msg, DirectFBErrorString(result));
+    exit(result);
+}
+
+DFBResult dfbRelease(IDirectFB* thiz)
+{
+    if (freetype != NULL)
+    {
+        FT_Done_FreeType(freetype);
+        freetype = NULL;
+    }
+
+    return DFB_OK;
+}
+
+DFBResult dfbSetCooperativeLevel(IDirectFB* thiz, DFBCooperativeLevel level)
+{
+    return DFB_OK;
+}
+
+DFBResult dfbCreateSurface(IDirectFB* thiz, const DFBSurfaceDescription* desc, IDirectFBSurface** ret_interface)
+{
+    SimSurface* surface;
+    DFBSurfaceCapabilities caps = (desc->flags & DSDESC_CAPS) ? desc->caps : DSCAPS_NONE;
+    size_t bufferSize;
+
+    if (desc->flags & DSDESC_PIXELFORMAT && desc->pixelformat != DSPF_ARGB)
+    {
+        return DFB_UNSUPPORTED;
+    }
+
+    surface = (SimSurface*)calloc(1, sizeof(SimSurface));
+    if (surface == NULL)
+    {
+        return DFB_NOSYSTEMMEMORY;
+    }
+
+    surface->primary = (caps & DSCAPS_PRIMARY) != 0;
+    surface->width = (desc->flags & DSDESC_WIDTH) ? desc->width : (surface->primary ? screenWidth : 0);
+    surface->height = (desc->flags & DSDESC_HEIGHT) ? desc->height : (surface->primary ? screenHeight : 0);
+    if (surface->width <= 0 || surface->height <= 0)
+    {
+        free(surface);
+        return DFB_INVARG;
+    }
+
+    /* new surfaces are transparent black */
+    bufferSize = (size_t)surface->width * surface->height * sizeof(uint32_t);
+    surface->back = (uint32_t*)calloc(1, bufferSize);
+    surface->front = (caps & DSCAPS_FLIPPING) ? (uint32_t*)calloc(1, bufferSize) : surface->back;
+    if (surface->back == NULL || surface->front == NULL)
+    {
+        free(surface->back);
+        if (surface->front != surface->back)
+        {
+            free(surface->front);
+        }
+        free(surface);
+        return DFB_NOSYSTEMMEMORY;
+    }
+
+    surface->clip.x2 = surface->width - 1;
+    surface->clip.y2 = surface->height - 1;
+
+    surface->iface.Release = surfaceRelease;
+    surface->iface.GetSize = surfaceGetSize;
+    surface->iface.SetClip = surfaceSetClip;
+    surface->iface.SetColor = surfaceSetColor;
+    surface->iface.Clear = surfaceClear;
+    surface->iface.FillRectangle = surfaceFillRectangle;
+    surface->iface.SetBlittingFlags = surfaceSetBlittingFlags;
+    surface->iface.Blit = surfaceBlit;
+    surface->iface.SetFont = surfaceSetFont;
+    surface->iface.DrawString = surfaceDrawString;
+    surface->iface.Flip = surfaceFlip;
+    *ret_interface = &surface->iface;
+
+    return DFB_OK;
+}
+
+DFBResult dfbCreateFont(IDirectFB* thiz, const char* filename, const DFBFontDescription* desc, IDirectFBFont** ret_interface)
+{
+    SimFont* font;
+    int32_t height = (desc != NULL && (desc->flags & DFDESC_HEIGHT)) ? desc->height : SIM_DEFAULT_FONT_HEIGHT;
+
+    font = (SimFont*)calloc(1, sizeof(SimFont));
+    if (font == NULL)
+    {
+        return DFB_NOSYSTEMMEMORY;
+    }
+
+    if (FT_New_Face(freetype, fontFile != NULL ? fontFile : filename, 0, &font->face))
+    {
+        printf("\n%s : ERROR Cannot load font %s, set DFB_SIM_FONT\n", __FUNCTION__, fontFile != NULL ? fontFile : filename);
+        free(font);
+        return DFB_FILENOTFOUND;
+    }
+    FT_Set_Pixel_Sizes(font->face, 0, height);
+    font->ascender = font->face->size->metrics.ascender >> 6;
+    font->height = font->face->size->metrics.height >> 6;
+
+    font->iface.Release = fontRelease;
+    font->iface.GetAscender = fontGetAscender;
+    font->iface.GetHeight = fontGetHeight;
+    font->iface.GetStringWidth = fontGetStringWidth;
+    *ret_interface = &font->iface;
+
+    return DFB_OK;
+}
+
+DFBResult dfbCreateImageProvider(IDirectFB* thiz, const char* filename, IDirectFBImageProvider** ret_interface)
+{
+    SimImageProvider* provider;
+    png_image image;
+
+    provider = (SimImageProvider*)calloc(1, sizeof(SimImageProvider));
+    if (provider == NULL)
+    {
+        return DFB_NOSYSTEMMEMORY;
+    }
+
+    /* image is decoded once, BGRA bytes are ARGB words on little endian host */
+    memset(&image, 0x0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, filename))
+    {
+        printf("\n%s : ERROR Cannot read %s\n", __FUNCTION__, filename);
+        free(provider);
+        return DFB_FILENOTFOUND;
+    }
+    image.format = PNG_FORMAT_BGRA;
+    provider->width = image.width;
+    provider->height = image.height;
+    provider->pixels = (uint32_t*)malloc(PNG_IMAGE_SIZE(image));
+    if (provider->pixels == NULL || !png_image_finish_read(&image, NULL, provider->pixels, 0, NULL))
+    {
+        printf("\n%s : ERROR Cannot decode %s\n", __FUNCTION__, filename);
+        png_image_free(&image);
+        free(provider->pixels);
+        free(provider);
+        return DFB_FAILURE;
+    }
+
+    provider->iface.Release = providerRelease;
+    provider->iface.GetSurfaceDescription = providerGetSurfaceDescription;
+    provider->iface.RenderTo = providerRenderTo;
+    *ret_interface = &provider->iface;
+
+    return DFB_OK;
+}
+
+DFBResult surfaceRelease(IDirectFBSurface* thiz)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    if (surface->front != surface->back)
+    {
+        free(surface->front);
+    }
+    free(surface->back);
+    free(surface);
+
+    return DFB_OK;
+}
+
+DFBResult surfaceGetSize(IDirectFBSurface* thiz, int* ret_width, int* ret_height)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    *ret_width = surface->width;
+    *ret_height = surface->height;
+
+    return DFB_OK;
+}
+
+DFBResult surfaceSetClip(IDirectFBSurface* thiz, const DFBRegion* clip)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    surface->clip.x1 = 0;
+    surface->clip.y1 = 0;
+    surface->clip.x2 = surface->width - 1;
+    surface->clip.y2 = surface->height - 1;
+    if (clip != NULL)
+    {
+        surface->clip.x1 = clip->x1 > 0 ? clip->x1 : 0;
+        surface->clip.y1 = clip->y1 > 0 ? clip->y1 : 0;
+        surface->clip.x2 = clip->x2 < surface->clip.x2 ? clip->x2 : surface->clip.x2;
+        surface->clip.y2 = clip->y2 < surface->clip.y2 ? clip->y2 : surface->clip.y2;
+    }
+
+    return DFB_OK;
+}
+
+DFBResult surfaceSetColor(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    surface->color = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+
+    return DFB_OK;
+}
+
+DFBResult surfaceClear(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    fillRect(surface, 0, 0, surface->width, surface->height,
+             ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b);
+
+    return DFB_OK;
+}
+
+DFBResult surfaceFillRectangle(IDirectFBSurface* thiz, int x, int y, int w, int h)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+
+    fillRect(surface, x, y, w, h, surface->color);
+
+    return DFB_OK;
+}
+
+DFBResult surfaceSetBlittingFlags(IDirectFBSurface* thiz, DFBSurfaceBlittingFlags flags)
+{
+    ((SimSurface*)thiz)->blittingFlags = flags;
+
+    return DFB_OK;
+}
+
+DFBResult surfaceBlit(IDirectFBSurface* thiz, IDirectFBSurface* source, const DFBRectangle* source_rect, int x, int y)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+    SimSurface* sourceSurface = (SimSurface*)source;
+    DFBRegion sourceClip = {0, 0, sourceSurface->width - 1, sourceSurface->height - 1};
+    int32_t sx = 0;
+    int32_t sy = 0;
+    int32_t w = sourceSurface->width;
+    int32_t h = sourceSurface->height;
+    int32_t dx;
+    int32_t dy;
+    const uint32_t* sourceRow;
+    uint32_t* row;
+    int32_t i;
+    int32_t j;
+
+    if (source_rect != NULL)
+    {
+        sx = source_rect->x;
+        sy = source_rect->y;
+        w = source_rect->w;
+        h = source_rect->h;
+        if (!clipRect(&sourceClip, &sx, &sy, &w, &h))
+        {
+            return DFB_OK;
+        }
+        x += sx - source_rect->x;
+        y += sy - source_rect->y;
+    }
+
+    /* clipping destination moves source origin by the same amount */
+    dx = x;
+    dy = y;
+    if (!clipRect(&surface->clip, &dx, &dy, &w, &h))
+    {
+        return DFB_OK;
+    }
+    sx += dx - x;
+    sy += dy - y;
+
+    for (j = 0; j < h; j++)
+    {
+        sourceRow = sourceSurface->back + (size_t)(sy + j) * sourceSurface->width + sx;
+        row = surface->back + (size_t)(dy + j) * surface->width + dx;
+        if (!(surface->blittingFlags & DSBLIT_BLEND_ALPHACHANNEL))
+        {
+            memmove(row, sourceRow, w * sizeof(uint32_t));
+            continue;
+        }
+        for (i = 0; i < w; i++)
+        {
+            row[i] = blendPixel(sourceRow[i], sourceRow[i] >> 24, row[i]);
+        }
+    }
+
+    return DFB_OK;
+}
+
+DFBResult surfaceSetFont(IDirectFBSurface* thiz, IDirectFBFont* font)
+{
+    ((SimSurface*)thiz)->font = (SimFont*)font;
+
+    return DFB_OK;
+}
+
+DFBResult surfaceDrawString(IDirectFBSurface* thiz, const char* text, int bytes, int x, int y, DFBSurfaceTextFlags flags)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+    SimFont* font = surface->font;
+    const uint8_t* position = (const uint8_t*)text;
+    const uint8_t* end;
+    const SimGlyph* glyph;
+    uint32_t colorAlpha = surface->color >> 24;
+    uint32_t coverage;
+    uint32_t* row;
+    int32_t gx;
+    int32_t gy;
+    int32_t i;
+    int32_t j;
+
+    if (font == NULL)
+    {
+        return DFB_FAILURE;
+    }
+    if (bytes < 0)
+    {
+        bytes = strlen(text);
+    }
+    end = position + bytes;
+
+    if (flags & DSTF_CENTER)
+    {
+        x -= stringWidth(font, text, bytes) / 2;
+    }
+    else if (flags & DSTF_RIGHT)
+    {
+        x -= stringWidth(font, text, bytes);
+    }
+    if (flags & DSTF_TOP)
+    {
+        y += font->ascender;
+    }
+    else if (flags & DSTF_BOTTOM)
+    {
+        y -= font->height - font->ascender;
+    }
+
+    /* glyph coverage is used as alpha of drawing color */
+    while (position < end)
+    {
+        glyph = getGlyph(font, nextCodePoint(&position, end));
+        if (glyph == NULL)
+        {
+            continue;
+        }
+        for (j = 0; j < glyph->rows; j++)
+        {
+            gy = y - glyph->top + j;
+            if (gy < surface->clip.y1 || gy > surface->clip.y2)
+            {
+                continue;
+            }
+            row = surface->back + (size_t)gy * surface->width;
+            for (i = 0; i < glyph->width; i++)
+            {
+                gx = x + glyph->left + i;
+                coverage = glyph->bitmap[j * glyph->width + i];
+                if (coverage == 0 || gx < surface->clip.x1 || gx > surface->clip.x2)
+                {
+                    continue;
+                }
+                row[gx] = blendPixel(surface->color, coverage * colorAlpha / 255, row[gx]);
+            }
+        }
+        x += glyph->advance;
+    }
+
+    return DFB_OK;
+}
+
+DFBResult surfaceFlip(IDirectFBSurface* thiz, const DFBRegion* region, DFBSurfaceFlipFlags flags)
+{
+    SimSurface* surface = (SimSurface*)thiz;
+    uint32_t* buffer;
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    DFBRegion bounds = {0, 0, surface->width - 1, surface->height - 1};
+
+    if (surface->front != surface->back)
+    {
+        if (region == NULL)
+        {
+            buffer = surface->front;
+            surface->front = surface->back;
+            surface->back = buffer;
+        }
+        else
+        {
+            x = region->x1;
+            y = region->y1;
+            w = region->x2 - region->x1 + 1;
+            h = region->y2 - region->y1 + 1;
+            if (clipRect(&bounds, &x, &y, &w, &h))
+            {
+                for (; h > 0; h--, y++)
+                {
+                    memcpy(surface->front + (size_t)y * surface->width + x,
+                           surface->back + (size_t)y * surface->width + x, w * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+
+    if (surface->primary && dumpDir != NULL)
+    {
+        dumpFrame(surface);
+    }
+
+    return DFB_OK;
+}
+
+DFBResult fontRelease(IDirectFBFont* thiz)
+{
+    SimFont* font = (SimFont*)thiz;
+    uint32_t i;
+
+    for (i = 0; i < SIM_GLYPH_CACHE_SIZE; i++)
+    {
+        freeGlyph(&font->glyphs[i]);
+    }
+    freeGlyph(&font->scratch);
+    FT_Done_Face(font->face);
+    free(font);
+
+    return DFB_OK;
+}
+
+DFBResult fontGetAscender(IDirectFBFont* thiz, int* ret_ascender)
+{
+    *ret_ascender = ((SimFont*)thiz)->ascender;
+
+    return DFB_OK;
+}
+
+DFBResult fontGetHeight(IDirectFBFont* thiz, int* ret_height)
+{
+    *ret_height = ((SimFont*)thiz)->height;
+
+    return DFB_OK;
+}
+
+DFBResult fontGetStringWidth(IDirectFBFont* thiz, const char* text, int bytes, int* ret_width)
+{
+    *ret_width = stringWidth((SimFont*)thiz, text, bytes < 0 ? (int32_t)strlen(text) : bytes);
+
+    return DFB_OK;
+}
+
+DFBResult providerRelease(IDirectFBImageProvider* thiz)
+{
+    SimImageProvider* provider = (SimImageProvider*)thiz;
+
+    free(provider->pixels);
+    free(provider);
+
+    return DFB_OK;
+}
+
+DFBResult providerGetSurfaceDescription(IDirectFBImageProvider* thiz, DFBSurfaceDescription* ret_desc)
+{
+    SimImageProvider* provider = (SimImageProvider*)thiz;
+
+    memset(ret_desc, 0x0, sizeof(DFBSurfaceDescription));
+    ret_desc->flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+    ret_desc->width = provider->width;
+    ret_desc->height = provider->height;
+    ret_desc->pixelformat = DSPF_ARGB;
+
+    return DFB_OK;
+}
+
+/* Copies image into destination rectangle, image is scaled with nearest neighbour if sizes differ */
+DFBResult providerRenderTo(IDirectFBImageProvider* thiz, IDirectFBSurface* destination, const DFBRectangle* destination_rect)
+{
+    SimImageProvider* provider = (SimImageProvider*)thiz;
+    SimSurface* surface = (SimSurface*)destination;
+    DFBRectangle rect = {0, 0, surface->width, surface->height};
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t i;
+    int32_t j;
+
+    if (destination_rect != NULL)
+    {
+        rect = *destination_rect;
+    }
+    if (rect.w <= 0 || rect.h <= 0)
+    {
+        return DFB_INVARG;
+    }
+
+    x = rect.x;
+    y = rect.y;
+    w = rect.w;
+    h = rect.h;
+    if (!clipRect(&surface->clip, &x, &y, &w, &h))
+    {
+        return DFB_OK;
+    }
+
+    for (j = y; j < y + h; j++)
+    {
+        for (i = x; i < x + w; i++)
+        {
+            surface->back[(size_t)j * surface->width + i] =
+                provider->pixels[(size_t)((j - rect.y) * provider->height / rect.h) * provider->width +
+                                 (i - rect.x) * provider->width / rect.w];
+        }
+    }
+
+    return DFB_OK;
+}
+
+/* Writes color into rectangle clipped to surface clip, drawing does not blend */
+void fillRect(SimSurface* surface, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    uint32_t* row;
+    int32_t i;
+
+    if (!clipRect(&surface->clip, &x, &y, &w, &h))
+    {
+        return;
+    }
+
+    for (; h > 0; h--, y++)
+    {
+        row = surface->back + (size_t)y * surface->width + x;
+        for (i = 0; i < w; i++)
+        {
+            row[i] = color;
+        }
+    }
+}
+
+/* Intersects rectangle with region, returns false if nothing is left */
+bool clipRect(const DFBRegion* clip, int32_t* x, int32_t* y, int32_t* w, int32_t* h)
+{
+    int32_t x2 = *x + *w - 1;
+    int32_t y2 = *y + *h - 1;
+
+    if (*x < clip->x1)
+    {
+        *x = clip->x1;
+    }
+    if (*y < clip->y1)
+    {
+        *y = clip->y1;
+    }
+    if (x2 > clip->x2)
+    {
+        x2 = clip->x2;
+    }
+    if (y2 > clip->y2)
+    {
+        y2 = clip->y2;
+    }
+    *w = x2 - *x + 1;
+    *h = y2 - *y + 1;
+
+    return *w > 0 && *h > 0;
+}
+
+/* Source over destination, colors are not premultiplied */
+inline uint32_t blendPixel(uint32_t source, uint32_t alpha, uint32_t destination)
+{
+    uint32_t inverse = 255 - alpha;
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+    uint32_t a;
+
+    if (alpha == 255)
+    {
+        return source | 0xFF000000;
+    }
+    if (alpha == 0)
+    {
+        return destination;
+    }
+
+    r = (((source >> 16) & 0xFF) * alpha + ((destination >> 16) & 0xFF) * inverse) / 255;
+    g = (((source >> 8) & 0xFF) * alpha + ((destination >> 8) & 0xFF) * inverse) / 255;
+    b = ((source & 0xFF) * alpha + (destination & 0xFF) * inverse) / 255;
+    a = alpha + (destination >> 24) * inverse / 255;
+
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/* Returns glyph of code point, glyphs below cache size are rendered only once */
+const SimGlyph* getGlyph(SimFont* font, uint32_t codePoint)
+{
+    SimGlyph* glyph = codePoint < SIM_GLYPH_CACHE_SIZE ? &font->glyphs[codePoint] : &font->scratch;
+    FT_GlyphSlot slot = font->face->glyph;
+    int32_t j;
+
+    if (glyph->loaded && codePoint < SIM_GLYPH_CACHE_SIZE)
+    {
+        return glyph;
+    }
+
+    freeGlyph(glyph);
+    if (FT_Load_Char(font->face, codePoint, FT_LOAD_RENDER))
+    {
+        return NULL;
+    }
+
+    glyph->width = slot->bitmap.width;
+    glyph->rows = slot->bitmap.rows;
+    glyph->left = slot->bitmap_left;
+    glyph->top = slot->bitmap_top;
+    glyph->advance = slot->advance.x >> 6;
+    if (glyph->width > 0 && glyph->rows > 0)
+    {
+        glyph->bitmap = (uint8_t*)malloc((size_t)glyph->width * glyph->rows);
+        if (glyph->bitmap == NULL)
+        {
+            return NULL;
+        }
+        for (j = 0; j < glyph->rows; j++)
+        {
+            memcpy(glyph->bitmap + j * glyph->width, slot->bitmap.buffer + j * slot->bitmap.pitch, glyph->width);
+        }
+    }
+    glyph->loaded = true;
+
+    return glyph;
+}
+
+void freeGlyph(SimGlyph* glyph)
+{
+    free(glyph->bitmap);
+    memset(glyph, 0x0, sizeof(SimGlyph));
+}
+
+/* Decodes one UTF-8 character, invalid bytes are taken as Latin-1 */
+uint32_t nextCodePoint(const uint8_t** text, const uint8_t* end)
+{
+    const uint8_t* position = *text;
+    uint32_t codePoint = *position;
+    int32_t length = 0;
+    int32_t i;
+
+    if ((codePoint & 0xE0) == 0xC0)
+    {
+        length = 1;
+        codePoint &= 0x1F;
+    }
+    else if ((codePoint & 0xF0) == 0xE0)
+    {
+        length = 2;
+        codePoint &= 0x0F;
+    }
+    else if ((codePoint & 0xF8) == 0xF0)
+    {
+        length = 3;
+        codePoint &= 0x07;
+    }
+
+    if (position + length >= end)
+    {
+        length = 0;
+    }
+    for (i = 1; i <= length; i++)
+    {
+        if ((position[i] & 0xC0) != 0x80)
+        {
+            *text = position + 1;
+            return *position;
+        }
+        codePoint = (codePoint << 6) | (position[i] & 0x3F);
+    }
+    if (length == 0)
+    {
+        codePoint = *position;
+    }
+
+    *text = position + length + 1;
+
+    return codePoint;
+}
+
+int32_t stringWidth(SimFont* font, const char* text, int32_t bytes)
+{
+    const uint8_t* position = (const uint8_t*)text;
+    const uint8_t* end = position + bytes;
+    const SimGlyph* glyph;
+    int32_t width = 0;
+
+    while (position < end)
+    {
+        glyph = getGlyph(font, nextCodePoint(&position, end));
+        if (glyph != NULL)
+        {
+            width += glyph->advance;
+        }
+    }
+
+    return width;
+}
+
+/* Writes front buffer as PPM, OSD is composed over black */
+void dumpFrame(SimSurface* surface)
+{
+    char path[SIM_PATH_LEN];
+    uint8_t* line;
+    uint32_t pixel;
+    uint32_t alpha;
+    FILE* file;
+    int32_t x;
+    int32_t y;
+
+    snprintf(path, sizeof(path), "%s/frame_%05u.ppm", dumpDir, frameCount++);
+    file = fopen(path, "wb");
+    line = (uint8_t*)malloc((size_t)surface->width * 3);
+    if (file == NULL || line == NULL)
+    {
+        printf("\n%s : ERROR Cannot write %s\n", __FUNCTION__, path);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        free(line);
+        return;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", surface->width, surface->height);
+    for (y = 0; y < surface->height; y++)
+    {
+        for (x = 0; x < surface->width; x++)
+        {
+            pixel = surface->front[(size_t)y * surface->width + x];
+            alpha = pixel >> 24;
+            line[x * 3] = ((pixel >> 16) & 0xFF) * alpha / 255;
+            line[x * 3 + 1] = ((pixel >> 8) & 0xFF) * alpha / 255;
+            line[x * 3 + 2] = (pixel & 0xFF) * alpha / 255;
+        }
+        fwrite(line, 1, (size_t)surface->width * 3, file);
+    }
+
+    fclose(file);
+    free(line);
+}
@@ -0,0 +1,199 @@
+#ifndef __DIRECTFB_H__
+#define __DIRECTFB_H__
+
+/*
+ * System memory stand-in for the DirectFB API used by the graphic controller.
+ *
+ * Only the interfaces, methods and flags used by the project are provided,
+ * with the same names and call syntax as DirectFB. Surfaces are ARGB buffers
+ * in system memory, text is rendered with FreeType and images are decoded
+ * with libpng. See dfb_sim.c for the DFB_SIM_* environment settings.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Enumeration of DirectFB result codes
+ */
+typedef enum
+{
+    DFB_OK = 0,
+    DFB_FAILURE,
+    DFB_INVARG,
+    DFB_NOSYSTEMMEMORY,
+    DFB_FILENOTFOUND,
+    DFB_UNSUPPORTED
+}DFBResult;
+
+typedef enum
+{
+    DFSCL_NORMAL = 0,
+    DFSCL_FULLSCREEN,
+    DFSCL_EXCLUSIVE
+}DFBCooperativeLevel;
+
+typedef enum
+{
+    DSDESC_NONE = 0x00000000,
+    DSDESC_CAPS = 0x00000001,
+    DSDESC_WIDTH = 0x00000002,
+    DSDESC_HEIGHT = 0x00000004,
+    DSDESC_PIXELFORMAT = 0x00000008
+}DFBSurfaceDescriptionFlags;
+
+typedef enum
+{
+    DSCAPS_NONE = 0x00000000,
+    DSCAPS_PRIMARY = 0x00000001,
+    DSCAPS_SYSTEMONLY = 0x00000002,
+    DSCAPS_VIDEOONLY = 0x00000004,
+    DSCAPS_DOUBLE = 0x00000010,
+    DSCAPS_FLIPPING = DSCAPS_DOUBLE
+}DFBSurfaceCapabilities;
+
+typedef enum
+{
+    DSPF_UNKNOWN = 0,
+    DSPF_ARGB                                   /* 32 bit, 0xAARRGGBB in native byte order */
+}DFBSurfacePixelFormat;
+
+typedef enum
+{
+    DSFLIP_NONE = 0x00000000,
+    DSFLIP_WAIT = 0x00000001,
+    DSFLIP_BLIT = 0x00000002,
+    DSFLIP_ONSYNC = 0x00000004,
+    DSFLIP_WAITFORSYNC = DSFLIP_WAIT | DSFLIP_ONSYNC
+}DFBSurfaceFlipFlags;
+
+typedef enum
+{
+    DSTF_LEFT = 0x00000000,
+    DSTF_CENTER = 0x00000001,
+    DSTF_RIGHT = 0x00000002,
+    DSTF_TOP = 0x00000004,
+    DSTF_BOTTOM = 0x00000008,
+    DSTF_TOPLEFT = DSTF_TOP | DSTF_LEFT
+}DFBSurfaceTextFlags;
+
+typedef enum
+{
+    DSBLIT_NOFX = 0x00000000,
+    DSBLIT_BLEND_ALPHACHANNEL = 0x00000001
+}DFBSurfaceBlittingFlags;
+
+typedef enum
+{
+    DFDESC_HEIGHT = 0x00000002
+}DFBFontDescriptionFlags;
+
+/**
+ * @brief Structure that defines surface to be created
+ */
+typedef struct
+{
+    DFBSurfaceDescriptionFlags flags;
+    DFBSurfaceCapabilities caps;
+    int width;
+    int height;
+    DFBSurfacePixelFormat pixelformat;
+}DFBSurfaceDescription;
+
+/**
+ * @brief Structure that defines font to be created
+ */
+typedef struct
+{
+    DFBFontDescriptionFlags flags;
+    int height;                                 /* Pixel height */
+}DFBFontDescription;
+
+/**
+ * @brief Structure that defines rectangle by position and size
+ */
+typedef struct
+{
+    int x;
+    int y;
+    int w;
+    int h;
+}DFBRectangle;
+
+/**
+ * @brief Structure that defines region by inclusive corners
+ */
+typedef struct
+{
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+}DFBRegion;
+
+typedef struct _IDirectFB IDirectFB;
+typedef struct _IDirectFBSurface IDirectFBSurface;
+typedef struct _IDirectFBFont IDirectFBFont;
+typedef struct _IDirectFBImageProvider IDirectFBImageProvider;
+
+/**
+ * @brief Main interface
+ */
+struct _IDirectFB
+{
+    DFBResult (*Release)(IDirectFB* thiz);
+    DFBResult (*SetCooperativeLevel)(IDirectFB* thiz, DFBCooperativeLevel level);
+    DFBResult (*CreateSurface)(IDirectFB* thiz, const DFBSurfaceDescription* desc, IDirectFBSurface** ret_interface);
+    DFBResult (*CreateFont)(IDirectFB* thiz, const char* filename, const DFBFontDescription* desc, IDirectFBFont** ret_interface);
+    DFBResult (*CreateImageProvider)(IDirectFB* thiz, const char* filename, IDirectFBImageProvider** ret_interface);
+};
+
+/**
+ * @brief Surface interface
+ *
+ * Drawing writes the color without blending, blitting blends only with
+ * DSBLIT_BLEND_ALPHACHANNEL. Flip of primary surface without region swaps
+ * buffers, with region it copies the region from back to front buffer.
+ */
+struct _IDirectFBSurface
+{
+    DFBResult (*Release)(IDirectFBSurface* thiz);
+    DFBResult (*GetSize)(IDirectFBSurface* thiz, int* ret_width, int* ret_height);
+    DFBResult (*SetClip)(IDirectFBSurface* thiz, const DFBRegion* clip);
+    DFBResult (*SetColor)(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+    DFBResult (*Clear)(IDirectFBSurface* thiz, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+    DFBResult (*FillRectangle)(IDirectFBSurface* thiz, int x, int y, int w, int h);
+    DFBResult (*SetBlittingFlags)(IDirectFBSurface* thiz, DFBSurfaceBlittingFlags flags);
+    DFBResult (*Blit)(IDirectFBSurface* thiz, IDirectFBSurface* source, const DFBRectangle* source_rect, int x, int y);
+    DFBResult (*SetFont)(IDirectFBSurface* thiz, IDirectFBFont* font);
+    DFBResult (*DrawString)(IDirectFBSurface* thiz, const char* text, int bytes, int x, int y, DFBSurfaceTextFlags flags);
+    DFBResult (*Flip)(IDirectFBSurface* thiz, const DFBRegion* region, DFBSurfaceFlipFlags flags);
+};
+
+/**
+ * @brief Font interface
+ */
+struct _IDirectFBFont
+{
+    DFBResult (*Release)(IDirectFBFont* thiz);
+    DFBResult (*GetAscender)(IDirectFBFont* thiz, int* ret_ascender);
+    DFBResult (*GetHeight)(IDirectFBFont* thiz, int* ret_height);
+    DFBResult (*GetStringWidth)(IDirectFBFont* thiz, const char* text, int bytes, int* ret_width);
+};
+
+/**
+ * @brief Image provider interface
+ */
+struct _IDirectFBImageProvider
+{
+    DFBResult (*Release)(IDirectFBImageProvider* thiz);
+    DFBResult (*GetSurfaceDescription)(IDirectFBImageProvider* thiz, DFBSurfaceDescription* ret_desc);
+    DFBResult (*RenderTo)(IDirectFBImageProvider* thiz, IDirectFBSurface* destination, const DFBRectangle* destination_rect);
+};
+
+DFBResult DirectFBInit(int* argc, char** argv[]);
+DFBResult DirectFBCreate(IDirectFB** ret_interface);
+const char* DirectFBErrorString(DFBResult result);
+DFBResult DirectFBErrorFatal(const char* msg, DFBResult result);
+
+#endif /* __DIRECTFB_H__ */
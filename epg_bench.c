@@ -0,0 +1,357 @@
+#include "epg_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * EPG store microbenchmark. Fills stores of many services with sections of
+ * events in shuffled order, then times now/next and grid range queries
+ * against a linear scan of an array of events and times sub-table updates.
+ * Names and texts mimic a broadcast schedule: series titles and synopses
+ * repeat, films and episodes have their own texts, some events carry an
+ * extended description.
+ *
+ * usage: epg_bench [services] [events per service] [queries]
+ */
+
+#define BENCH_DEFAULT_SERVICES  100
+#define BENCH_DEFAULT_EVENTS    1000
+#define BENCH_DEFAULT_QUERIES   1000000
+#define BENCH_SECTION_EVENTS    8           /* Events of one schedule section */
+#define BENCH_TABLE_EVENTS      256         /* Events of one sub-table */
+#define BENCH_GRID_SECONDS      (3 * 3600)  /* Grid window */
+#define BENCH_GRID_MAX          64
+#define BENCH_START_TIME        1700000000
+#define BENCH_SERIES            48          /* Distinct series titles of a service */
+#define BENCH_EXTENDED_LEN      640
+
+static volatile uint32_t benchSink;         /* Keeps results alive */
+
+static void generateEvents(EpgEvent* events, uint32_t count, uint32_t serviceIndex);
+static uint32_t generateTexts(uint32_t serviceIndex, uint16_t eventId, char* text, char* extendedText);
+static bool insertShuffled(EpgStore* store, const EpgEvent* events, uint32_t count, uint32_t serviceIndex);
+static uint8_t linearNowNext(const EpgEvent* events, uint32_t count, uint32_t time, uint32_t* now, uint32_t* next);
+static uint32_t linearGrid(const EpgEvent* events, uint32_t count, uint32_t from, uint32_t to, EpgEvent* grid, uint32_t maxCount);
+static double elapsedSeconds(const struct timespec* startTime);
+
+int main(int argc, char* argv[])
+{
+    uint32_t serviceCount = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_SERVICES;
+    uint32_t eventCount = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_EVENTS;
+    uint32_t queryCount = argc > 3 ? atoi(argv[3]) : BENCH_DEFAULT_QUERIES;
+    EpgEvent* events;
+    EpgStore* stores;
+    EpgEvent grid[BENCH_GRID_MAX];
+    EpgEvent event;
+    struct timespec startTime;
+    uint32_t* queryServices;
+    uint32_t* queryTimes;
+    uint32_t span;
+    uint32_t now;
+    uint32_t next;
+    uint32_t linearNow;
+    uint32_t linearNext;
+    uint32_t memory = 0;
+    uint64_t textBytes = 0;
+    char text[EPG_NAME_LEN];
+    char extendedText[BENCH_EXTENDED_LEN];
+    uint32_t tableCount;
+    uint8_t found;
+    double seconds;
+    double storeNs;
+    double linearNs;
+    uint32_t i;
+    uint32_t j;
+
+    if (serviceCount == 0 || eventCount == 0 || queryCount == 0)
+    {
+        printf("usage: epg_bench [services] [events per service] [queries]\n");
+        return 1;
+    }
+
+    events = (EpgEvent*)malloc((size_t)serviceCount * eventCount * sizeof(EpgEvent));
+    stores = (EpgStore*)malloc(serviceCount * sizeof(EpgStore));
+    queryServices = (uint32_t*)malloc(queryCount * sizeof(uint32_t));
+    queryTimes = (uint32_t*)malloc(queryCount * sizeof(uint32_t));
+    if (events == NULL || stores == NULL || queryServices == NULL || queryTimes == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return 1;
+    }
+
+    srand(1);
+    for (i = 0; i < serviceCount; i++)
+    {
+        generateEvents(&events[i * eventCount], eventCount, i);
+        epgStoreInit(&stores[i]);
+        for (j = 0; j < eventCount; j++)
+        {
+            textBytes += strlen(events[i * eventCount + j].name) + 1 + generateTexts(i, events[i * eventCount + j].eventId, text, extendedText);
+        }
+    }
+
+    /* fill */
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < serviceCount; i++)
+    {
+        if (!insertShuffled(&stores[i], &events[i * eventCount], eventCount, i))
+        {
+            return 1;
+        }
+    }
+    seconds = elapsedSeconds(&startTime);
+    /* collector trims every sub-table once it is complete */
+    for (i = 0; i < serviceCount; i++)
+    {
+        for (j = 0; j < EPG_STORE_TABLES; j++)
+        {
+            epgStoreTrimTable(&stores[i], 0x50 + j);
+        }
+        memory += epgStoreMemory(&stores[i]);
+    }
+    printf("events: %u services x %u\n", serviceCount, eventCount);
+    printf("insert %u-event sections, texts generated inline: %.1f ns/event\n", BENCH_SECTION_EVENTS, seconds * 1e9 / (serviceCount * eventCount));
+    /* without interning every event keeps its own copy of every text */
+    printf("memory per 10k events: store %.0f KB, without interning %.0f KB, 256 byte name and text arrays %.0f KB\n",
+           (double)memory / (serviceCount * eventCount) * 10000 / 1024,
+           (double)(textBytes + (uint64_t)serviceCount * eventCount * (sizeof(EpgEvent) - EPG_NAME_LEN + 2 * sizeof(uint32_t))) / (serviceCount * eventCount) * 10000 / 1024,
+           (double)(sizeof(EpgEvent) + EPG_NAME_LEN) * 10000 / 1024);
+
+    /* query times cover whole schedule of the first service and a bit outside */
+    span = events[eventCount - 1].startTime + events[eventCount - 1].duration - BENCH_START_TIME;
+    for (i = 0; i < queryCount; i++)
+    {
+        queryServices[i] = rand() % serviceCount;
+        queryTimes[i] = BENCH_START_TIME - 3600 + (uint32_t)(((uint64_t)rand() * rand()) % (span + 7200));
+    }
+
+    /* both must find the same events */
+    for (i = 0; i < queryCount && i < 10000; i++)
+    {
+        found = epgStoreFindNowNext(&stores[queryServices[i]], queryTimes[i], &now, &next);
+        if (found != linearNowNext(&events[queryServices[i] * eventCount], eventCount, queryTimes[i], &linearNow, &linearNext) ||
+            ((found & EPG_FOUND_NOW) && stores[queryServices[i]].eventIds[stores[queryServices[i]].slots[now]] != events[queryServices[i] * eventCount + linearNow].eventId) ||
+            ((found & EPG_FOUND_NEXT) && stores[queryServices[i]].eventIds[stores[queryServices[i]].slots[next]] != events[queryServices[i] * eventCount + linearNext].eventId))
+        {
+            printf("\nERROR now/next mismatch for service %u at %u\n", queryServices[i], queryTimes[i]);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < queryCount; i++)
+    {
+        found = epgStoreFindNowNext(&stores[queryServices[i]], queryTimes[i], &now, &next);
+        benchSink ^= found + now + next;
+    }
+    storeNs = elapsedSeconds(&startTime) * 1e9 / queryCount;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < queryCount; i++)
+    {
+        found = linearNowNext(&events[queryServices[i] * eventCount], eventCount, queryTimes[i], &now, &next);
+        benchSink ^= found + now + next;
+    }
+    linearNs = elapsedSeconds(&startTime) * 1e9 / queryCount;
+    printf("query      | store ns | linear ns\n");
+    printf("now/next   | %8.1f | %9.1f\n", storeNs, linearNs);
+
+    /* grid window, names are copied out like the OSD would */
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < queryCount; i++)
+    {
+        benchSink ^= epgStoreGetEvents(&stores[queryServices[i]], queryTimes[i], queryTimes[i] + BENCH_GRID_SECONDS, grid, BENCH_GRID_MAX);
+    }
+    storeNs = elapsedSeconds(&startTime) * 1e9 / queryCount;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < queryCount; i++)
+    {
+        benchSink ^= linearGrid(&events[queryServices[i] * eventCount], eventCount, queryTimes[i], queryTimes[i] + BENCH_GRID_SECONDS, grid, BENCH_GRID_MAX);
+    }
+    linearNs = elapsedSeconds(&startTime) * 1e9 / queryCount;
+    printf("grid %2uh   | %8.1f | %9.1f\n", BENCH_GRID_SECONDS / 3600, storeNs, linearNs);
+
+    /* version change of the second sub-table of every service */
+    tableCount = eventCount > BENCH_TABLE_EVENTS ? BENCH_TABLE_EVENTS : eventCount;
+    j = eventCount > BENCH_TABLE_EVENTS ? BENCH_TABLE_EVENTS : 0;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (i = 0; i < serviceCount; i++)
+    {
+        epgStoreRemoveTable(&stores[i], events[i * eventCount + j].tableId);
+        if (!insertShuffled(&stores[i], &events[i * eventCount + j], tableCount, i))
+        {
+            return 1;
+        }
+    }
+    seconds = elapsedSeconds(&startTime);
+    printf("sub-table update (%u events): %.1f us/service\n", tableCount, seconds * 1e6 / serviceCount);
+
+    for (i = 0; i < serviceCount; i++)
+    {
+        if (stores[i].count != eventCount)
+        {
+            printf("\nERROR service %u has %u events after update\n", i, stores[i].count);
+            return 1;
+        }
+        /* texts survive sub-table update */
+        epgStoreGetEvent(&stores[i], eventCount / 2, &event);
+        generateTexts(i, event.eventId, text, extendedText);
+        if (strcmp(epgStoreText(&stores[i], eventCount / 2, EPG_TEXT_SHORT), text) != 0 ||
+            strcmp(epgStoreText(&stores[i], eventCount / 2, EPG_TEXT_EXTENDED), extendedText) != 0)
+        {
+            printf("\nERROR texts of event %u of service %u differ\n", event.eventId, i);
+            return 1;
+        }
+        epgStoreDeinit(&stores[i]);
+    }
+
+    free(queryTimes);
+    free(queryServices);
+    free(stores);
+    free(events);
+
+    return 0;
+}
+
+/* Fills events of one service back to back, sorted by start time */
+void generateEvents(EpgEvent* events, uint32_t count, uint32_t serviceIndex)
+{
+    static const uint32_t durations[] = {300, 900, 1500, 1800, 2700, 3600, 5400, 7200};
+    uint32_t startTime = BENCH_START_TIME + (serviceIndex % 12) * 300;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        events[i].startTime = startTime;
+        events[i].duration = durations[rand() % (sizeof(durations) / sizeof(durations[0]))];
+        events[i].eventId = (uint16_t)(i + 1);
+        events[i].tableId = 0x50 + i / BENCH_TABLE_EVENTS;
+        /* every eighth event is a film */
+        if ((serviceIndex * 31 + i * 7) % 8 == 0)
+        {
+            snprintf(events[i].name, EPG_NAME_LEN, "Feature film %u of service %u", i, serviceIndex);
+        }
+        else
+        {
+            snprintf(events[i].name, EPG_NAME_LEN, "Series %u", (serviceIndex * 31 + i * 7) % BENCH_SERIES);
+        }
+        startTime += events[i].duration;
+    }
+}
+
+/* Fills short and extended text of event, returns bytes of both texts including terminating zeros */
+uint32_t generateTexts(uint32_t serviceIndex, uint16_t eventId, char* text, char* extendedText)
+{
+    uint32_t seed = serviceIndex * 31 + (eventId - 1) * 7;
+    uint32_t length;
+
+    if (seed % 8 == 0 || seed % 3 == 0)
+    {
+        length = snprintf(text, EPG_NAME_LEN, "Episode %u. Characters of service %u face a new situation in this instalment, "
+                          "followed by the consequences of the previous one.", eventId, serviceIndex);
+    }
+    else
+    {
+        length = snprintf(text, EPG_NAME_LEN, "Series %u returns with another part of the popular programme, "
+                          "presented live from the studio.", seed % BENCH_SERIES);
+    }
+
+    /* films have their own cast, series repeat theirs */
+    extendedText[0] = '\0';
+    if (seed % 8 == 0)
+    {
+        snprintf(extendedText, BENCH_EXTENDED_LEN, "Cast and crew of film %u: %0*u", eventId, 300 + seed % 200, 0);
+    }
+    else if (seed % 2 == 0)
+    {
+        snprintf(extendedText, BENCH_EXTENDED_LEN, "Cast and crew of series %u: %0*u", seed % BENCH_SERIES, 300 + seed % BENCH_SERIES, 0);
+    }
+
+    return length + 1 + strlen(extendedText) + 1;
+}
+
+/* Inserts events one section at a time, sections in random order like a carousel joined midway */
+bool insertShuffled(EpgStore* store, const EpgEvent* events, uint32_t count, uint32_t serviceIndex)
+{
+    EpgEventText texts[BENCH_SECTION_EVENTS];
+    char text[BENCH_SECTION_EVENTS][EPG_NAME_LEN];
+    char extendedText[BENCH_SECTION_EVENTS][BENCH_EXTENDED_LEN];
+    uint32_t sectionCount = (count + BENCH_SECTION_EVENTS - 1) / BENCH_SECTION_EVENTS;
+    uint32_t first = rand() % sectionCount;
+    uint32_t stride = sectionCount % 7 ? 7 : 1;     /* 7 visits every section unless it divides section count */
+    uint32_t section;
+    uint32_t length;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < sectionCount; i++)
+    {
+        section = (first + i * stride) % sectionCount;
+        length = count - section * BENCH_SECTION_EVENTS;
+        if (length > BENCH_SECTION_EVENTS)
+        {
+            length = BENCH_SECTION_EVENTS;
+        }
+        for (j = 0; j < length; j++)
+        {
+            generateTexts(serviceIndex, events[section * BENCH_SECTION_EVENTS + j].eventId, text[j], extendedText[j]);
+            texts[j].text = text[j];
+            texts[j].extendedText = extendedText[j];
+        }
+        if (epgStoreInsert(store, &events[section * BENCH_SECTION_EVENTS], texts, length) != EPG_STORE_NO_ERROR)
+        {
+            printf("\n%s : ERROR insert failed\n", __FUNCTION__);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Baseline, scans all events of service */
+uint8_t linearNowNext(const EpgEvent* events, uint32_t count, uint32_t time, uint32_t* now, uint32_t* next)
+{
+    uint8_t found = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!(found & EPG_FOUND_NOW) && events[i].startTime <= time && events[i].startTime + events[i].duration > time)
+        {
+            *now = i;
+            found |= EPG_FOUND_NOW;
+        }
+        if (events[i].startTime > time && (!(found & EPG_FOUND_NEXT) || events[i].startTime < events[*next].startTime))
+        {
+            *next = i;
+            found |= EPG_FOUND_NEXT;
+        }
+    }
+
+    return found;
+}
+
+/* Baseline, scans all events of service */
+uint32_t linearGrid(const EpgEvent* events, uint32_t count, uint32_t from, uint32_t to, EpgEvent* grid, uint32_t maxCount)
+{
+    uint32_t gridCount = 0;
+    uint32_t i;
+
+    for (i = 0; i < count && gridCount < maxCount; i++)
+    {
+        if (events[i].startTime < to && events[i].startTime + events[i].duration > from)
+        {
+            grid[gridCount++] = events[i];
+        }
+    }
+
+    return gridCount;
+}
+
+double elapsedSeconds(const struct timespec* startTime)
+{
+    struct timespec endTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+    return (endTime.tv_sec - startTime->tv_sec) + (endTime.tv_nsec - startTime->tv_nsec) / 1e9;
+}
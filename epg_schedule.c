@@ -0,0 +1,529 @@
+#include "epg_schedule.h"
+#include "section_view.h"
+#include "tables.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+
+static EpgService* findService(EpgSchedule* schedule, uint16_t originalNetworkId, uint16_t transportStreamId, uint16_t serviceId);
+static EpgService* addService(EpgSchedule* schedule, const SectionView* view);
+static void resetSubTable(EpgService* service, EpgSubTable* subTable, uint8_t tableId, uint8_t version, uint8_t lastSectionNumber);
+static bool isSubTableComplete(const EpgSubTable* subTable);
+static void updateCompletion(EpgSchedule* schedule, EpgService* service);
+static EpgService* findServiceId(EpgSchedule* schedule, uint16_t serviceId);
+static void storeEvents(EpgService* service, EpgSubTable* subTable, uint8_t sectionNumber, const EpgEvent* events, const EpgEventText* texts, uint32_t count);
+static uint16_t decodeEventTexts(const EitEventView* eventView, EpgEvent* event, EpgEventText* eventText, char* texts, uint16_t textsSize);
+static uint16_t appendText(char* texts, uint16_t length, uint16_t textsSize, const char* text);
+static uint32_t bitCount(const uint8_t* bitmap);
+
+static inline bool testBit(const uint8_t* bitmap, uint8_t bit)
+{
+    return (bitmap[bit >> 3] & (1 << (bit & 7))) != 0;
+}
+
+static inline void setBit(uint8_t* bitmap, uint8_t bit)
+{
+    bitmap[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+}
+
+static inline void clearBit(uint8_t* bitmap, uint8_t bit)
+{
+    bitmap[bit >> 3] &= (uint8_t)~(1 << (bit & 7));
+}
+
+EpgScheduleError epgScheduleInit(EpgSchedule* schedule)
+{
+    if (schedule == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return EPG_SCHEDULE_ERROR;
+    }
+
+    memset(schedule, 0x0, sizeof(EpgSchedule));
+    schedule->wantedTables = (1U << (EPG_TABLE_ACTUAL_FIRST - EPG_TABLE_ACTUAL_FIRST)) |
+                             (1U << (EPG_TABLE_OTHER_FIRST - EPG_TABLE_ACTUAL_FIRST));
+    clock_gettime(CLOCK_MONOTONIC, &schedule->startTime);
+    pthread_mutex_init(&schedule->mutex, NULL);
+
+    return EPG_SCHEDULE_NO_ERROR;
+}
+
+EpgScheduleError epgScheduleDeinit(EpgSchedule* schedule)
+{
+    uint8_t i;
+
+    if (schedule == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return EPG_SCHEDULE_ERROR;
+    }
+
+    for (i = 0; i < schedule->serviceCount; i++)
+    {
+        epgStoreDeinit(&schedule->services[i].events);
+    }
+    pthread_mutex_destroy(&schedule->mutex);
+    memset(schedule, 0x0, sizeof(EpgSchedule));
+
+    return EPG_SCHEDULE_NO_ERROR;
+}
+
+/* Only PSI worker writes the schedule, header checks before the lock read state it alone changes */
+EpgSectionResult epgScheduleAddSection(EpgSchedule* schedule, const uint8_t* sectionBuffer)
+{
+    SectionView view;
+    SectionLoopIterator iterator;
+    EitEventView eventView;
+    EpgService* service;
+    EpgSubTable* subTable;
+    EpgEvent batch[EPG_SECTION_BATCH];
+    EpgEventText batchTexts[EPG_SECTION_BATCH];
+    char texts[EPG_SECTION_TEXT_LEN];
+    uint16_t textsLength = 0;
+    uint32_t batchCount = 0;
+    uint8_t tableId;
+    uint8_t version;
+    uint8_t sectionNumber;
+    uint8_t lastSectionNumber;
+    uint8_t segmentLast;
+    uint8_t segmentFirst;
+    uint16_t bit;
+
+    if (schedule == NULL || !sectionViewInit(&view, sectionBuffer, 0) || !sectionViewSyntaxIndicator(&view) ||
+        sectionViewTableId(&view) < EPG_TABLE_ACTUAL_FIRST || sectionViewTableId(&view) > EPG_TABLE_LAST ||
+        !eitEventIteratorInit(&view, &iterator))
+    {
+        return EPG_SECTION_INVALID;
+    }
+
+    if (!sectionViewCurrentNextIndicator(&view))
+    {
+        return EPG_SECTION_SKIPPED;
+    }
+
+    tableId = sectionViewTableId(&view);
+    version = sectionViewVersionNumber(&view);
+    sectionNumber = sectionViewSectionNumber(&view);
+
+    /* repeated sections of the carousel end here */
+    service = findService(schedule, eitViewOriginalNetworkId(&view), eitViewTransportStreamId(&view), sectionViewTableIdExtension(&view));
+    if (service != NULL)
+    {
+        subTable = &service->tables[tableId & 0x0F];
+        if (subTable->version == version && testBit(subTable->received, sectionNumber))
+        {
+            schedule->duplicates++;
+            return EPG_SECTION_DUPLICATE;
+        }
+    }
+
+    if (!crc32SectionValid(sectionBuffer))
+    {
+        return EPG_SECTION_CRC_ERROR;
+    }
+
+    pthread_mutex_lock(&schedule->mutex);
+    if (service == NULL)
+    {
+        service = addService(schedule, &view);
+        if (service == NULL)
+        {
+            pthread_mutex_unlock(&schedule->mutex);
+            return EPG_SECTION_SKIPPED;
+        }
+    }
+
+    /* new version replaces all events of the sub-table */
+    lastSectionNumber = sectionViewLastSectionNumber(&view);
+    subTable = &service->tables[tableId & 0x0F];
+    if (subTable->version != version)
+    {
+        resetSubTable(service, subTable, tableId, version, lastSectionNumber);
+    }
+
+    /* section announces the other sections of its segment */
+    segmentFirst = sectionNumber & ~(EPG_SECTIONS_PER_SEGMENT - 1);
+    segmentLast = eitViewSegmentLastSectionNumber(&view);
+    if (segmentLast < sectionNumber || segmentLast > segmentFirst + EPG_SECTIONS_PER_SEGMENT - 1 || segmentLast > lastSectionNumber)
+    {
+        segmentLast = sectionNumber;
+    }
+    for (bit = segmentFirst; bit <= segmentLast; bit++)
+    {
+        setBit(subTable->expected, (uint8_t)bit);
+    }
+    setBit(subTable->expected, sectionNumber);
+    setBit(subTable->received, sectionNumber);
+
+    /* last_table_id announces sub-tables that are not filtered yet */
+    if (eitViewLastTableId(&view) > service->lastTableId && eitViewLastTableId(&view) <= service->firstTableId + EPG_TABLES_PER_SERVICE - 1)
+    {
+        service->lastTableId = eitViewLastTableId(&view);
+        schedule->wantedTables |= ((1U << (service->lastTableId - service->firstTableId + 1)) - 1) << (service->firstTableId - EPG_TABLE_ACTUAL_FIRST);
+    }
+
+    /* store index is rebuilt once per batch */
+    while (eitEventIteratorNext(&iterator, &eventView))
+    {
+        batch[batchCount].startTime = eitStartTimeToUnix(eventView.startTime);
+        batch[batchCount].duration = eitDurationToSeconds(eventView.duration);
+        batch[batchCount].eventId = eventView.eventId;
+        batch[batchCount].tableId = tableId;
+        textsLength += decodeEventTexts(&eventView, &batch[batchCount], &batchTexts[batchCount], &texts[textsLength], EPG_SECTION_TEXT_LEN - textsLength);
+        if (++batchCount == EPG_SECTION_BATCH)
+        {
+            storeEvents(service, subTable, sectionNumber, batch, batchTexts, batchCount);
+            batchCount = 0;
+            textsLength = 0;
+        }
+    }
+    if (batchCount > 0)
+    {
+        storeEvents(service, subTable, sectionNumber, batch, batchTexts, batchCount);
+    }
+
+    /* texts of complete sub-table do not grow until its next version */
+    if (!subTable->complete && isSubTableComplete(subTable))
+    {
+        subTable->complete = true;
+        epgStoreTrimTable(&service->events, tableId);
+    }
+    updateCompletion(schedule, service);
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return EPG_SECTION_STORED;
+}
+
+uint32_t epgScheduleGetWantedTables(EpgSchedule* schedule)
+{
+    uint32_t wantedTables;
+
+    pthread_mutex_lock(&schedule->mutex);
+    wantedTables = schedule->wantedTables;
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return wantedTables;
+}
+
+EpgScheduleError epgScheduleGetProgress(EpgSchedule* schedule, EpgProgress* progress)
+{
+    const EpgService* service;
+    uint8_t i;
+    uint8_t j;
+
+    if (schedule == NULL || progress == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return EPG_SCHEDULE_ERROR;
+    }
+
+    memset(progress, 0x0, sizeof(EpgProgress));
+    pthread_mutex_lock(&schedule->mutex);
+    progress->services = schedule->serviceCount;
+    for (i = 0; i < schedule->serviceCount; i++)
+    {
+        service = &schedule->services[i];
+        progress->completeServices += service->complete;
+        progress->events += service->events.count;
+        for (j = 0; j < EPG_TABLES_PER_SERVICE; j++)
+        {
+            if (service->tables[j].version != EPG_VERSION_NONE)
+            {
+                progress->sectionsExpected += bitCount(service->tables[j].expected);
+                progress->sectionsReceived += bitCount(service->tables[j].received);
+            }
+        }
+    }
+    progress->duplicates = schedule->duplicates;
+    progress->complete = schedule->complete;
+    progress->completeMs = schedule->completeMs;
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return EPG_SCHEDULE_NO_ERROR;
+}
+
+uint32_t epgScheduleGetEvents(EpgSchedule* schedule, uint16_t serviceId, uint32_t from, uint32_t to, EpgEvent* events, uint32_t maxCount)
+{
+    const EpgService* service;
+    uint32_t count = 0;
+
+    if (schedule == NULL || events == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return 0;
+    }
+
+    pthread_mutex_lock(&schedule->mutex);
+    service = findServiceId(schedule, serviceId);
+    if (service != NULL)
+    {
+        count = epgStoreGetEvents(&service->events, from, to, events, maxCount);
+    }
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return count;
+}
+
+uint8_t epgScheduleGetNowNext(EpgSchedule* schedule, uint16_t serviceId, uint32_t time, EpgEvent* now, EpgEvent* next)
+{
+    const EpgService* service;
+    uint32_t nowIndex;
+    uint32_t nextIndex;
+    uint8_t found = 0;
+
+    if (schedule == NULL || now == NULL || next == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return 0;
+    }
+
+    pthread_mutex_lock(&schedule->mutex);
+    service = findServiceId(schedule, serviceId);
+    if (service != NULL)
+    {
+        found = epgStoreFindNowNext(&service->events, time, &nowIndex, &nextIndex);
+        if (found & EPG_FOUND_NOW)
+        {
+            epgStoreGetEvent(&service->events, nowIndex, now);
+        }
+        if (found & EPG_FOUND_NEXT)
+        {
+            epgStoreGetEvent(&service->events, nextIndex, next);
+        }
+    }
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return found;
+}
+
+bool epgScheduleGetEventText(EpgSchedule* schedule, uint16_t serviceId, uint16_t eventId, EpgText type, char* text, uint32_t textSize)
+{
+    const EpgService* service;
+    uint32_t index;
+    bool found = false;
+
+    if (schedule == NULL || type >= EPG_TEXT_COUNT || text == NULL || textSize == 0)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return false;
+    }
+
+    pthread_mutex_lock(&schedule->mutex);
+    service = findServiceId(schedule, serviceId);
+    if (service != NULL && epgStoreFindEvent(&service->events, eventId, &index))
+    {
+        strncpy(text, epgStoreText(&service->events, index, type), textSize - 1);
+        text[textSize - 1] = '\0';
+        found = true;
+    }
+    pthread_mutex_unlock(&schedule->mutex);
+
+    return found;
+}
+
+EpgService* findService(EpgSchedule* schedule, uint16_t originalNetworkId, uint16_t transportStreamId, uint16_t serviceId)
+{
+    uint8_t i;
+
+    for (i = 0; i < schedule->serviceCount; i++)
+    {
+        if (schedule->services[i].serviceId == serviceId &&
+            schedule->services[i].transportStreamId == transportStreamId &&
+            schedule->services[i].originalNetworkId == originalNetworkId)
+        {
+            return &schedule->services[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Returns first service with service_id, services of other networks are rarely queried by id */
+EpgService* findServiceId(EpgSchedule* schedule, uint16_t serviceId)
+{
+    uint8_t i;
+
+    for (i = 0; i < schedule->serviceCount; i++)
+    {
+        if (schedule->services[i].serviceId == serviceId)
+        {
+            return &schedule->services[i];
+        }
+    }
+
+    return NULL;
+}
+
+EpgService* addService(EpgSchedule* schedule, const SectionView* view)
+{
+    EpgService* service;
+    uint8_t i;
+
+    if (schedule->serviceCount == EPG_MAX_SERVICES)
+    {
+        return NULL;
+    }
+
+    service = &schedule->services[schedule->serviceCount++];
+    memset(service, 0x0, sizeof(EpgService));
+    service->originalNetworkId = eitViewOriginalNetworkId(view);
+    service->transportStreamId = eitViewTransportStreamId(view);
+    service->serviceId = sectionViewTableIdExtension(view);
+    service->firstTableId = sectionViewTableId(view) < EPG_TABLE_OTHER_FIRST ? EPG_TABLE_ACTUAL_FIRST : EPG_TABLE_OTHER_FIRST;
+    service->lastTableId = service->firstTableId;
+    epgStoreInit(&service->events);
+    for (i = 0; i < EPG_TABLES_PER_SERVICE; i++)
+    {
+        service->tables[i].version = EPG_VERSION_NONE;
+    }
+
+    return service;
+}
+
+/* Starts sub-table version, first section of every segment up to last_section_number is expected */
+void resetSubTable(EpgService* service, EpgSubTable* subTable, uint8_t tableId, uint8_t version, uint8_t lastSectionNumber)
+{
+    uint16_t bit;
+
+    memset(subTable, 0x0, sizeof(EpgSubTable));
+    subTable->version = version;
+    for (bit = 0; bit <= lastSectionNumber; bit += EPG_SECTIONS_PER_SEGMENT)
+    {
+        setBit(subTable->expected, (uint8_t)bit);
+    }
+
+    epgStoreRemoveTable(&service->events, tableId);
+}
+
+bool isSubTableComplete(const EpgSubTable* subTable)
+{
+    uint8_t i;
+
+    for (i = 0; i < EPG_SECTION_BITMAP_LEN; i++)
+    {
+        if ((subTable->received[i] & subTable->expected[i]) != subTable->expected[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Service is complete with its last announced sub-table, schedule with its last service */
+void updateCompletion(EpgSchedule* schedule, EpgService* service)
+{
+    struct timespec nowTime;
+    bool wasComplete = schedule->complete;
+    uint8_t i;
+
+    service->complete = false;
+    schedule->complete = false;
+    for (i = 0; i <= service->lastTableId - service->firstTableId; i++)
+    {
+        if (service->tables[i].version == EPG_VERSION_NONE || !service->tables[i].complete)
+        {
+            return;
+        }
+    }
+    service->complete = true;
+
+    for (i = 0; i < schedule->serviceCount; i++)
+    {
+        if (!schedule->services[i].complete)
+        {
+            return;
+        }
+    }
+
+    if (!wasComplete)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &nowTime);
+        schedule->complete = true;
+        schedule->completeMs = (uint32_t)((nowTime.tv_sec - schedule->startTime.tv_sec) * 1000 +
+                                          (nowTime.tv_nsec - schedule->startTime.tv_nsec) / 1000000);
+    }
+}
+
+/* Inserts events of section, section is received again in the next cycle when store is out of memory */
+void storeEvents(EpgService* service, EpgSubTable* subTable, uint8_t sectionNumber, const EpgEvent* events, const EpgEventText* texts, uint32_t count)
+{
+    uint32_t i;
+
+    if (epgStoreInsert(&service->events, events, texts, count) == EPG_STORE_NO_ERROR)
+    {
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        printf("\n%s : ERROR Cannot allocate memory, event 0x%x of service %u dropped\n", __FUNCTION__, events[i].eventId, service->serviceId);
+    }
+    clearBit(subTable->received, sectionNumber);
+}
+
+/* Decodes name into event and texts into texts buffer, only short and extended event descriptors are decoded */
+uint16_t decodeEventTexts(const EitEventView* eventView, EpgEvent* event, EpgEventText* eventText, char* texts, uint16_t textsSize)
+{
+    SectionLoopIterator iterator;
+    DescriptorView descriptorView;
+    Descriptor descriptor;
+    uint16_t length = 0;
+
+    event->name[0] = '\0';
+    texts[0] = '\0';
+    if (parseDescriptor(eventView->descriptors, eventView->descriptorsLength, DESCRIPTOR_SHORT_EVENT, &descriptor) == TABLES_PARSE_OK)
+    {
+        strncpy(event->name, descriptor.shortEvent.eventName, EPG_NAME_LEN - 1);
+        event->name[EPG_NAME_LEN - 1] = '\0';
+        length = appendText(texts, 0, textsSize, descriptor.shortEvent.text);
+    }
+    eventText->text = texts;
+
+    /* extended text is split over descriptors in descriptor_number order */
+    length++;
+    eventText->extendedText = &texts[length];
+    texts[length] = '\0';
+    descriptorIteratorInit(&iterator, eventView->descriptors, eventView->descriptorsLength);
+    while (findDescriptor(&iterator, DESCRIPTOR_EXTENDED_EVENT, &descriptorView))
+    {
+        if (decodeDescriptor(&descriptorView, &descriptor) == TABLES_PARSE_OK)
+        {
+            length = appendText(texts, length, textsSize, descriptor.extendedEvent.text);
+        }
+    }
+
+    return length + 1;
+}
+
+/* Appends text to zero terminated string at length, text is cut to fit */
+uint16_t appendText(char* texts, uint16_t length, uint16_t textsSize, const char* text)
+{
+    uint16_t textLength = strlen(text);
+
+    if (length + 1 >= textsSize)
+    {
+        return length;
+    }
+    if (textLength > textsSize - 1 - length)
+    {
+        textLength = textsSize - 1 - length;
+    }
+    memcpy(&texts[length], text, textLength);
+    texts[length + textLength] = '\0';
+
+    return length + textLength;
+}
+
+uint32_t bitCount(const uint8_t* bitmap)
+{
+    uint32_t count = 0;
+    uint8_t i;
+
+    for (i = 0; i < EPG_SECTION_BITMAP_LEN; i++)
+    {
+        count += __builtin_popcount(bitmap[i]);
+    }
+
+    return count;
+}
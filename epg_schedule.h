@@ -0,0 +1,198 @@
+#ifndef __EPG_SCHEDULE_H__
+#define __EPG_SCHEDULE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "pthread.h"
+#include "epg_store.h"
+
+#define EPG_MAX_SERVICES            64          /* Services of actual and other transport streams */
+#define EPG_TABLE_ACTUAL_FIRST      0x50        /* EIT schedule actual TS, 0x50-0x5F */
+#define EPG_TABLE_OTHER_FIRST       0x60        /* EIT schedule other TS, 0x60-0x6F */
+#define EPG_TABLE_LAST              0x6F
+#define EPG_TABLES_PER_SERVICE      16          /* One sub-table covers 4 days */
+#define EPG_SECTIONS_PER_SEGMENT    8           /* One segment covers 3 hours */
+#define EPG_SECTION_BITMAP_LEN      32          /* Bit per section_number */
+#define EPG_VERSION_NONE            0xFF        /* Sub-table has not been received */
+#define EPG_SCHEDULE_PID            0x12
+#define EPG_SECTION_BATCH           32          /* Events of one section inserted into store at once */
+#define EPG_SECTION_TEXT_LEN        (4096 + 2 * EPG_SECTION_BATCH)  /* Texts of one batch, at most section size plus terminators */
+
+/*
+ * EIT schedule collector.
+ *
+ * Sections of tables 0x50-0x6F are stored per service and sub-table, the
+ * collector keeps a bit per received section_number and a bit per section
+ * it expects from last_section_number and segment_last_section_number.
+ * A section whose bit is already set in the same version is dropped from
+ * its header, before CRC_32 and event decoding.
+ *
+ * Events of every service are kept in an EPG store (see epg_store.h). The
+ * PSI worker is the only writer, readers take the mutex for the duration
+ * of one query.
+ */
+
+/**
+ * @brief Enumeration of possible EPG schedule error codes
+ */
+typedef enum _EpgScheduleError
+{
+    EPG_SCHEDULE_NO_ERROR = 0,
+    EPG_SCHEDULE_ERROR
+}EpgScheduleError;
+
+/**
+ * @brief Enumeration of section store results
+ */
+typedef enum _EpgSectionResult
+{
+    EPG_SECTION_STORED = 0,                     /* Events of section were stored */
+    EPG_SECTION_DUPLICATE,                      /* Section of this version was already stored */
+    EPG_SECTION_SKIPPED,                        /* Next version, or no room for new service */
+    EPG_SECTION_CRC_ERROR,                      /* CRC_32 mismatch */
+    EPG_SECTION_INVALID                         /* Not an EIT schedule section */
+}EpgSectionResult;
+
+/**
+ * @brief Structure that defines acquisition state of one sub-table
+ */
+typedef struct _EpgSubTable
+{
+    uint8_t version;                            /* EPG_VERSION_NONE until first section */
+    uint8_t received[EPG_SECTION_BITMAP_LEN];
+    uint8_t expected[EPG_SECTION_BITMAP_LEN];
+    bool complete;                              /* Every expected section was received */
+}EpgSubTable;
+
+/**
+ * @brief Structure that defines schedule of one service
+ */
+typedef struct _EpgService
+{
+    uint16_t originalNetworkId;
+    uint16_t transportStreamId;
+    uint16_t serviceId;
+    uint8_t firstTableId;                       /* 0x50 for actual, 0x60 for other TS */
+    uint8_t lastTableId;                        /* Highest table_id announced for service */
+    EpgSubTable tables[EPG_TABLES_PER_SERVICE];
+    EpgStore events;
+    bool complete;                              /* Every announced sub-table is complete */
+}EpgService;
+
+/**
+ * @brief Structure that defines acquisition progress
+ */
+typedef struct _EpgProgress
+{
+    uint32_t services;                          /* Services seen in schedule sections */
+    uint32_t completeServices;
+    uint32_t sectionsExpected;                  /* Sum over all seen sub-tables */
+    uint32_t sectionsReceived;
+    uint32_t events;
+    uint32_t duplicates;                        /* Sections dropped from header */
+    bool complete;                              /* Every seen service is complete */
+    uint32_t completeMs;                        /* Time from init to latest completion */
+}EpgProgress;
+
+/**
+ * @brief Structure that defines EPG schedule collector
+ */
+typedef struct _EpgSchedule
+{
+    EpgService services[EPG_MAX_SERVICES];
+    uint8_t serviceCount;
+    uint32_t wantedTables;                      /* Bit (table_id - 0x50) of announced tables */
+    uint32_t duplicates;
+    bool complete;
+    uint32_t completeMs;
+    struct timespec startTime;                  /* Init time (CLOCK_MONOTONIC) */
+    pthread_mutex_t mutex;
+}EpgSchedule;
+
+/**
+ * @brief Initializes EPG schedule collector
+ *
+ * @param [out] schedule - EPG schedule
+ * @return EPG schedule error code
+ */
+EpgScheduleError epgScheduleInit(EpgSchedule* schedule);
+
+/**
+ * @brief Deinitializes EPG schedule collector and frees all events
+ *
+ * @param [in] schedule - EPG schedule
+ * @return EPG schedule error code
+ */
+EpgScheduleError epgScheduleDeinit(EpgSchedule* schedule);
+
+/**
+ * @brief Stores events of one EIT schedule section
+ *
+ * CRC_32 is checked only for sections that are not dropped as duplicates.
+ *
+ * @param [in] schedule - EPG schedule
+ * @param [in] sectionBuffer - section starting with table_id
+ * @return section store result
+ */
+EpgSectionResult epgScheduleAddSection(EpgSchedule* schedule, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Returns schedule tables announced by received sections
+ *
+ * Tables 0x50 and 0x60 are always wanted, others are added from last_table_id.
+ *
+ * @param [in] schedule - EPG schedule
+ * @return bit (table_id - 0x50) for every wanted table
+ */
+uint32_t epgScheduleGetWantedTables(EpgSchedule* schedule);
+
+/**
+ * @brief Returns acquisition progress
+ *
+ * @param [in] schedule - EPG schedule
+ * @param [out] progress - acquisition progress
+ * @return EPG schedule error code
+ */
+EpgScheduleError epgScheduleGetProgress(EpgSchedule* schedule, EpgProgress* progress);
+
+/**
+ * @brief Copies events of service that overlap time range, ordered by start time
+ *
+ * @param [in] schedule - EPG schedule
+ * @param [in] serviceId - service_id
+ * @param [in] from - range start, seconds since 1970-01-01 UTC
+ * @param [in] to - range end, exclusive
+ * @param [out] events - event array
+ * @param [in] maxCount - size of event array
+ * @return number of copied events
+ */
+uint32_t epgScheduleGetEvents(EpgSchedule* schedule, uint16_t serviceId, uint32_t from, uint32_t to, EpgEvent* events, uint32_t maxCount);
+
+/**
+ * @brief Copies event of service running at time and the event after it
+ *
+ * @param [in] schedule - EPG schedule
+ * @param [in] serviceId - service_id
+ * @param [in] time - seconds since 1970-01-01 UTC
+ * @param [out] now - running event, valid if EPG_FOUND_NOW is returned
+ * @param [out] next - next event, valid if EPG_FOUND_NEXT is returned
+ * @return EPG_FOUND_NOW and EPG_FOUND_NEXT flags of found events
+ */
+uint8_t epgScheduleGetNowNext(EpgSchedule* schedule, uint16_t serviceId, uint32_t time, EpgEvent* now, EpgEvent* next);
+
+/**
+ * @brief Copies description text of event
+ *
+ * @param [in] schedule - EPG schedule
+ * @param [in] serviceId - service_id
+ * @param [in] eventId - event_id
+ * @param [in] type - EPG_TEXT_SHORT or EPG_TEXT_EXTENDED
+ * @param [out] text - text, cut to fit and always terminated
+ * @param [in] textSize - size of text buffer
+ * @return true if event is stored
+ */
+bool epgScheduleGetEventText(EpgSchedule* schedule, uint16_t serviceId, uint16_t eventId, EpgText type, char* text, uint32_t textSize);
+
+#endif /* __EPG_SCHEDULE_H__ */
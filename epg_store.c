@@ -0,0 +1,580 @@
+#include "epg_store.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Bytes of all per-event arrays of one event, max tree and event_id hash have two entries per event */
+#define EPG_STORE_EVENT_BYTES ((8 + EPG_TEXT_COUNT) * sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t))
+#define EPG_STORE_NO_SLOT     0xFFFFFFFF
+#define EPG_STORE_BATCH       32          /* Events merged into index at once */
+
+static EpgStoreError insertBatch(EpgStore* store, const EpgEvent* events, const EpgEventText* texts, uint32_t count);
+static bool reserveEvents(EpgStore* store, uint32_t capacity);
+static bool internTexts(EpgStore* store, const EpgEvent* event, const EpgEventText* text, uint32_t* offsets);
+static uint32_t* findIdSlot(const EpgStore* store, uint16_t eventId);
+static uint32_t findPosition(const EpgStore* store, uint32_t slot);
+static void mergeAdded(EpgStore* store, uint32_t* added, uint32_t addedCount, uint32_t firstChanged);
+static void renumberSlots(EpgStore* store);
+static void rebuildIdSlots(EpgStore* store);
+static void rebuildIndex(EpgStore* store, uint32_t first, uint32_t last);
+static uint32_t firstEndingAfter(const EpgStore* store, uint32_t first, uint32_t time);
+static uint32_t firstStartingAfter(const EpgStore* store, uint32_t time);
+
+EpgStoreError epgStoreInit(EpgStore* store)
+{
+    uint8_t i;
+
+    if (store == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return EPG_STORE_ERROR;
+    }
+
+    memset(store, 0x0, sizeof(EpgStore));
+    for (i = 0; i < EPG_STORE_TABLES; i++)
+    {
+        textArenaInit(&store->arenas[i]);
+    }
+
+    return EPG_STORE_NO_ERROR;
+}
+
+EpgStoreError epgStoreDeinit(EpgStore* store)
+{
+    uint8_t i;
+
+    if (store == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return EPG_STORE_ERROR;
+    }
+
+    /* all event arrays share one allocation starting with start times */
+    free(store->startTimes);
+    for (i = 0; i < EPG_STORE_TABLES; i++)
+    {
+        textArenaDeinit(&store->arenas[i]);
+    }
+    memset(store, 0x0, sizeof(EpgStore));
+
+    return EPG_STORE_NO_ERROR;
+}
+
+EpgStoreError epgStoreInsert(EpgStore* store, const EpgEvent* events, const EpgEventText* texts, uint32_t count)
+{
+    uint32_t length;
+    uint32_t i;
+
+    for (i = 0; i < count; i += length)
+    {
+        length = count - i < EPG_STORE_BATCH ? count - i : EPG_STORE_BATCH;
+        if (insertBatch(store, &events[i], texts != NULL ? &texts[i] : NULL, length) != EPG_STORE_NO_ERROR)
+        {
+            return EPG_STORE_ERROR;
+        }
+    }
+
+    return EPG_STORE_NO_ERROR;
+}
+
+void epgStoreRemoveTable(EpgStore* store, uint8_t tableId)
+{
+    uint32_t firstChanged = store->count;
+    uint32_t oldCount = store->count;
+    uint32_t kept = 0;
+    uint32_t i;
+
+    for (i = 0; i < store->count; i++)
+    {
+        if (store->tableIds[store->slots[i]] == tableId)
+        {
+            if (i < firstChanged)
+            {
+                firstChanged = i;
+            }
+            continue;
+        }
+        store->startTimes[kept] = store->startTimes[i];
+        store->slots[kept] = store->slots[i];
+        kept++;
+    }
+
+    /* freed slots are closed up, which moves the data of every kept event */
+    if (firstChanged < oldCount)
+    {
+        store->count = kept;
+        renumberSlots(store);
+        rebuildIndex(store, 0, oldCount);
+    }
+    textArenaReset(&store->arenas[tableId % EPG_STORE_TABLES]);
+}
+
+void epgStoreTrimTable(EpgStore* store, uint8_t tableId)
+{
+    textArenaTrim(&store->arenas[tableId % EPG_STORE_TABLES]);
+}
+
+uint8_t epgStoreFindNowNext(const EpgStore* store, uint32_t time, uint32_t* now, uint32_t* next)
+{
+    uint8_t found = 0;
+    uint32_t i;
+
+    /* events from next on have not started, the first one before it that has not ended runs */
+    *next = firstStartingAfter(store, time);
+    i = firstEndingAfter(store, 0, time);
+    if (i < *next)
+    {
+        *now = i;
+        found |= EPG_FOUND_NOW;
+    }
+    if (*next < store->count)
+    {
+        found |= EPG_FOUND_NEXT;
+    }
+
+    return found;
+}
+
+uint32_t epgStoreGetEvents(const EpgStore* store, uint32_t from, uint32_t to, EpgEvent* events, uint32_t maxCount)
+{
+    uint32_t count = 0;
+    uint32_t i;
+
+    /* events that ended before the range are skipped by the tree, not one by one */
+    for (i = firstEndingAfter(store, 0, from); i < store->count && store->startTimes[i] < to && count < maxCount;
+         i = firstEndingAfter(store, i + 1, from))
+    {
+        epgStoreGetEvent(store, i, &events[count++]);
+    }
+
+    return count;
+}
+
+void epgStoreGetEvent(const EpgStore* store, uint32_t index, EpgEvent* event)
+{
+    uint32_t slot = store->slots[index];
+
+    event->startTime = store->startTimes[index];
+    event->duration = store->durations[slot];
+    event->eventId = store->eventIds[slot];
+    event->tableId = store->tableIds[slot];
+    strncpy(event->name, epgStoreText(store, index, EPG_TEXT_NAME), EPG_NAME_LEN - 1);
+    event->name[EPG_NAME_LEN - 1] = '\0';
+}
+
+bool epgStoreFindEvent(const EpgStore* store, uint16_t eventId, uint32_t* index)
+{
+    uint32_t slot;
+
+    if (store->count == 0)
+    {
+        return false;
+    }
+
+    slot = *findIdSlot(store, eventId);
+    if (slot == EPG_STORE_NO_SLOT)
+    {
+        return false;
+    }
+    *index = findPosition(store, slot);
+
+    return true;
+}
+
+const char* epgStoreText(const EpgStore* store, uint32_t index, EpgText text)
+{
+    uint32_t slot = store->slots[index];
+
+    return textArenaGet(&store->arenas[store->tableIds[slot] % EPG_STORE_TABLES], store->textOffsets[text][slot]);
+}
+
+uint32_t epgStoreMemory(const EpgStore* store)
+{
+    uint32_t memory = store->capacity * EPG_STORE_EVENT_BYTES;
+    uint8_t i;
+
+    for (i = 0; i < EPG_STORE_TABLES; i++)
+    {
+        memory += textArenaMemory(&store->arenas[i]);
+    }
+
+    return memory;
+}
+
+/* Stores batch in slots and merges it into index, events before a failed one are stored */
+EpgStoreError insertBatch(EpgStore* store, const EpgEvent* events, const EpgEventText* texts, uint32_t count)
+{
+    uint32_t added[EPG_STORE_BATCH];
+    uint32_t addedCount = 0;
+    uint32_t slotCount = store->count;
+    uint32_t firstChanged = store->count;
+    uint32_t offsets[EPG_TEXT_COUNT];
+    uint32_t capacity = store->capacity ? store->capacity : EPG_STORE_INITIAL_CAPACITY;
+    uint32_t* idSlot;
+    uint32_t position;
+    uint32_t slot;
+    uint32_t i;
+    uint8_t j;
+
+    /* every event of batch may be new */
+    while (capacity < store->count + count)
+    {
+        capacity *= 2;
+    }
+    if (capacity != store->capacity && !reserveEvents(store, capacity))
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return EPG_STORE_ERROR;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (!internTexts(store, &events[i], texts != NULL ? &texts[i] : NULL, offsets))
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            mergeAdded(store, added, addedCount, firstChanged);
+            return EPG_STORE_ERROR;
+        }
+
+        /* event moved or was renamed, its slot is reused and its old index position dropped */
+        idSlot = findIdSlot(store, events[i].eventId);
+        if (*idSlot == EPG_STORE_NO_SLOT)
+        {
+            slot = slotCount++;
+            *idSlot = slot;
+            store->eventIds[slot] = events[i].eventId;
+            added[addedCount++] = slot;
+        }
+        else
+        {
+            slot = *idSlot;
+            position = findPosition(store, slot);
+            /* event repeated within batch is already waiting for the merge */
+            if (position < store->count)
+            {
+                store->slots[position] = EPG_STORE_NO_SLOT;
+                added[addedCount++] = slot;
+                if (position < firstChanged)
+                {
+                    firstChanged = position;
+                }
+            }
+        }
+
+        store->slotStartTimes[slot] = events[i].startTime;
+        store->durations[slot] = events[i].duration;
+        store->tableIds[slot] = events[i].tableId;
+        for (j = 0; j < EPG_TEXT_COUNT; j++)
+        {
+            store->textOffsets[j][slot] = offsets[j];
+        }
+    }
+
+    mergeAdded(store, added, addedCount, firstChanged);
+
+    return EPG_STORE_NO_ERROR;
+}
+
+/* Moves all event arrays into one new block of given capacity */
+bool reserveEvents(EpgStore* store, uint32_t capacity)
+{
+    uint8_t* block;
+    uint32_t* offsets;
+    EpgStore resized = *store;
+    uint8_t i;
+
+    block = (uint8_t*)malloc(capacity * EPG_STORE_EVENT_BYTES);
+    if (block == NULL)
+    {
+        return false;
+    }
+
+    /* widest arrays first keeps every array aligned */
+    resized.startTimes = (uint32_t*)block;
+    resized.slots = resized.startTimes + capacity;
+    resized.maxEnds = resized.slots + capacity;
+    resized.idSlots = resized.maxEnds + 2 * capacity;
+    resized.slotStartTimes = resized.idSlots + 2 * capacity;
+    resized.durations = resized.slotStartTimes + capacity;
+    offsets = resized.durations + capacity;
+    for (i = 0; i < EPG_TEXT_COUNT; i++)
+    {
+        resized.textOffsets[i] = offsets;
+        offsets += capacity;
+    }
+    resized.eventIds = (uint16_t*)offsets;
+    resized.tableIds = (uint8_t*)(resized.eventIds + capacity);
+    resized.capacity = capacity;
+
+    if (store->count > 0)
+    {
+        memcpy(resized.startTimes, store->startTimes, store->count * sizeof(uint32_t));
+        memcpy(resized.slots, store->slots, store->count * sizeof(uint32_t));
+        memcpy(resized.slotStartTimes, store->slotStartTimes, store->count * sizeof(uint32_t));
+        memcpy(resized.durations, store->durations, store->count * sizeof(uint32_t));
+        for (i = 0; i < EPG_TEXT_COUNT; i++)
+        {
+            memcpy(resized.textOffsets[i], store->textOffsets[i], store->count * sizeof(uint32_t));
+        }
+        memcpy(resized.eventIds, store->eventIds, store->count * sizeof(uint16_t));
+        memcpy(resized.tableIds, store->tableIds, store->count * sizeof(uint8_t));
+    }
+    free(store->startTimes);
+    *store = resized;
+
+    /* leaves moved with capacity, padding leaves must be zero */
+    memset(store->maxEnds, 0x0, 2 * capacity * sizeof(uint32_t));
+    rebuildIndex(store, 0, store->count);
+    rebuildIdSlots(store);
+
+    return true;
+}
+
+bool internTexts(EpgStore* store, const EpgEvent* event, const EpgEventText* text, uint32_t* offsets)
+{
+    TextArena* arena = &store->arenas[event->tableId % EPG_STORE_TABLES];
+
+    offsets[EPG_TEXT_SHORT] = TEXT_ARENA_EMPTY;
+    offsets[EPG_TEXT_EXTENDED] = TEXT_ARENA_EMPTY;
+    if (textArenaIntern(arena, event->name, strlen(event->name), &offsets[EPG_TEXT_NAME]) != TEXT_ARENA_NO_ERROR)
+    {
+        return false;
+    }
+    if (text == NULL)
+    {
+        return true;
+    }
+
+    return textArenaIntern(arena, text->text, strlen(text->text), &offsets[EPG_TEXT_SHORT]) == TEXT_ARENA_NO_ERROR &&
+           textArenaIntern(arena, text->extendedText, strlen(text->extendedText), &offsets[EPG_TEXT_EXTENDED]) == TEXT_ARENA_NO_ERROR;
+}
+
+/* Returns hash entry of event_id or the free entry where it belongs, linear probing */
+uint32_t* findIdSlot(const EpgStore* store, uint16_t eventId)
+{
+    uint32_t mask = 2 * store->capacity - 1;
+    uint32_t hash = eventId * 2654435761u;
+    uint32_t index = (hash ^ (hash >> 16)) & mask;
+
+    while (store->idSlots[index] != EPG_STORE_NO_SLOT && store->eventIds[store->idSlots[index]] != eventId)
+    {
+        index = (index + 1) & mask;
+    }
+
+    return &store->idSlots[index];
+}
+
+/* Returns index position of slot, count if slot is not in index */
+uint32_t findPosition(const EpgStore* store, uint32_t slot)
+{
+    uint32_t time = store->slotStartTimes[slot];
+    uint32_t i;
+
+    /* events with equal start time are few */
+    for (i = time > 0 ? firstStartingAfter(store, time - 1) : 0; i < store->count && store->startTimes[i] == time; i++)
+    {
+        if (store->slots[i] == slot)
+        {
+            return i;
+        }
+    }
+
+    return store->count;
+}
+
+/* Drops index positions marked free from firstChanged on and merges added slots in one pass from the back */
+void mergeAdded(EpgStore* store, uint32_t* added, uint32_t addedCount, uint32_t firstChanged)
+{
+    uint32_t oldCount = store->count;
+    uint32_t kept = firstChanged;
+    uint32_t write;
+    uint32_t slot;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = firstChanged; i < oldCount; i++)
+    {
+        if (store->slots[i] != EPG_STORE_NO_SLOT)
+        {
+            store->startTimes[kept] = store->startTimes[i];
+            store->slots[kept] = store->slots[i];
+            kept++;
+        }
+    }
+
+    /* insertion sort of batch, events with equal start time keep their order */
+    for (i = 1; i < addedCount; i++)
+    {
+        slot = added[i];
+        for (j = i; j > 0 && store->slotStartTimes[added[j - 1]] > store->slotStartTimes[slot]; j--)
+        {
+            added[j] = added[j - 1];
+        }
+        added[j] = slot;
+    }
+
+    /* added event goes after stored events with equal start time */
+    write = kept + addedCount;
+    i = kept;
+    j = addedCount;
+    while (j > 0)
+    {
+        write--;
+        if (i > 0 && store->startTimes[i - 1] > store->slotStartTimes[added[j - 1]])
+        {
+            store->startTimes[write] = store->startTimes[i - 1];
+            store->slots[write] = store->slots[i - 1];
+            i--;
+        }
+        else
+        {
+            store->startTimes[write] = store->slotStartTimes[added[j - 1]];
+            store->slots[write] = added[j - 1];
+            j--;
+        }
+    }
+    store->count = kept + addedCount;
+
+    /* positions before i kept their events */
+    rebuildIndex(store, i < firstChanged ? i : firstChanged, oldCount > store->count ? oldCount : store->count);
+}
+
+/* Moves data of event at index position i into slot i, max tree leaves serve as scratch and must be rebuilt */
+void renumberSlots(EpgStore* store)
+{
+    uint32_t* scratch = &store->maxEnds[store->capacity];
+    uint32_t* arrays[2 + EPG_TEXT_COUNT] = {store->slotStartTimes, store->durations};
+    uint32_t i;
+    uint8_t j;
+
+    for (j = 0; j < EPG_TEXT_COUNT; j++)
+    {
+        arrays[2 + j] = store->textOffsets[j];
+    }
+    for (j = 0; j < 2 + EPG_TEXT_COUNT; j++)
+    {
+        for (i = 0; i < store->count; i++)
+        {
+            scratch[i] = arrays[j][store->slots[i]];
+        }
+        memcpy(arrays[j], scratch, store->count * sizeof(uint32_t));
+    }
+    for (i = 0; i < store->count; i++)
+    {
+        scratch[i] = store->eventIds[store->slots[i]] | (uint32_t)store->tableIds[store->slots[i]] << 16;
+    }
+    for (i = 0; i < store->count; i++)
+    {
+        store->eventIds[i] = (uint16_t)scratch[i];
+        store->tableIds[i] = (uint8_t)(scratch[i] >> 16);
+        store->slots[i] = i;
+    }
+
+    rebuildIdSlots(store);
+}
+
+/* Hashes event_id of every used slot, slots 0..count - 1 are used between batches */
+void rebuildIdSlots(EpgStore* store)
+{
+    uint32_t i;
+
+    memset(store->idSlots, 0xFF, 2 * store->capacity * sizeof(uint32_t));
+    for (i = 0; i < store->count; i++)
+    {
+        *findIdSlot(store, store->eventIds[i]) = i;
+    }
+}
+
+/* Updates leaves of events first..last - 1 and their ancestors, leaves from count on become zero */
+void rebuildIndex(EpgStore* store, uint32_t first, uint32_t last)
+{
+    uint32_t low = store->capacity + first;
+    uint32_t high = store->capacity + last - 1;
+    uint32_t* tree = store->maxEnds;
+    uint32_t i;
+
+    if (last > store->capacity)
+    {
+        last = store->capacity;
+        high = store->capacity + last - 1;
+    }
+    if (first >= last)
+    {
+        return;
+    }
+
+    for (i = first; i < last; i++)
+    {
+        tree[store->capacity + i] = i < store->count ? store->startTimes[i] + store->durations[store->slots[i]] : 0;
+    }
+    while (low > 1)
+    {
+        low /= 2;
+        high /= 2;
+        for (i = low; i <= high; i++)
+        {
+            tree[i] = tree[2 * i] > tree[2 * i + 1] ? tree[2 * i] : tree[2 * i + 1];
+        }
+    }
+}
+
+/* Returns index of first event from first on that ends after time, count if there is none */
+uint32_t firstEndingAfter(const EpgStore* store, uint32_t first, uint32_t time)
+{
+    const uint32_t* tree = store->maxEnds;
+    uint32_t node;
+
+    if (first >= store->count)
+    {
+        return store->count;
+    }
+
+    /* climb to the next subtree on the right until one holds such an event */
+    node = store->capacity + first;
+    while (tree[node] <= time)
+    {
+        while (node % 2 == 1)
+        {
+            node /= 2;
+        }
+        if (node == 0)
+        {
+            return store->count;
+        }
+        node++;
+    }
+
+    /* descend to its leftmost leaf ending after time */
+    while (node < store->capacity)
+    {
+        node *= 2;
+        if (tree[node] <= time)
+        {
+            node++;
+        }
+    }
+
+    return node - store->capacity;
+}
+
+/* Returns index of first event that starts after time */
+uint32_t firstStartingAfter(const EpgStore* store, uint32_t time)
+{
+    uint32_t low = 0;
+    uint32_t high = store->count;
+    uint32_t middle;
+
+    while (low < high)
+    {
+        middle = (low + high) / 2;
+        if (store->startTimes[middle] <= time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
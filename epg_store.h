@@ -0,0 +1,204 @@
+#ifndef __EPG_STORE_H__
+#define __EPG_STORE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "text_arena.h"
+
+#define EPG_NAME_LEN                256         /* Event name including terminating zero, event_name_length is 8 bits */
+#define EPG_STORE_INITIAL_CAPACITY  64          /* Events allocated on first insert, capacity stays a power of two */
+#define EPG_STORE_TABLES            16          /* Sub-tables of actual or other schedule, indexed by table_id & 0x0F */
+#define EPG_FOUND_NOW               0x01
+#define EPG_FOUND_NEXT              0x02
+
+/*
+ * Sorted event store of one service.
+ *
+ * Events are kept ordered by start time in an index of start times and
+ * slots, a query touches only the index and the interval index until it
+ * has found its events. The other event data is kept in structure-of-arrays
+ * form by slot, which does not move when events are inserted before it. The index is a max tree over end times: leaf
+ * capacity + i holds the end of event i, node k the later end of nodes 2k
+ * and 2k + 1. The first event from any position that still runs at time T
+ * is found in O(log n) by skipping subtrees that ended before T, however
+ * long overlapping events are.
+ *
+ * Name, short event text and extended event text are kept at full length
+ * in one text arena per sub-table, events keep 32 bit offsets into it.
+ * Series titles and repeated synopses are interned, so a text repeated
+ * within a sub-table is stored once.
+ *
+ * Updates come per section: inserted events replace events with the same
+ * event_id, found through a hash of event_id to slot, and the events of a
+ * section are merged into the index in one pass. All events of a sub-table
+ * are removed when its version changes, which also resets the arena of the
+ * sub-table and renumbers the slots. Texts of events replaced from another
+ * sub-table stay in their arena until then. The interval index is rebuilt
+ * only from the first changed position.
+ */
+
+/**
+ * @brief Enumeration of possible EPG store error codes
+ */
+typedef enum _EpgStoreError
+{
+    EPG_STORE_NO_ERROR = 0,
+    EPG_STORE_ERROR
+}EpgStoreError;
+
+/**
+ * @brief Enumeration of event texts
+ */
+typedef enum _EpgText
+{
+    EPG_TEXT_NAME = 0,                          /* event_name of short event descriptor */
+    EPG_TEXT_SHORT,                             /* text of short event descriptor */
+    EPG_TEXT_EXTENDED,                          /* texts of all extended event descriptors */
+    EPG_TEXT_COUNT
+}EpgText;
+
+/**
+ * @brief Structure that defines one event copied out of or into the store
+ */
+typedef struct _EpgEvent
+{
+    uint32_t startTime;                         /* Seconds since 1970-01-01 UTC */
+    uint32_t duration;                          /* Seconds */
+    uint16_t eventId;
+    uint8_t tableId;                            /* Sub-table the event was received in */
+    char name[EPG_NAME_LEN];
+}EpgEvent;
+
+/**
+ * @brief Structure that defines description texts of one inserted event
+ */
+typedef struct _EpgEventText
+{
+    const char* text;                           /* Short event text, zero terminated */
+    const char* extendedText;                   /* Extended event text, zero terminated */
+}EpgEventText;
+
+/**
+ * @brief Structure that defines events of one service
+ */
+typedef struct _EpgStore
+{
+    uint32_t* startTimes;                       /* Ascending */
+    uint32_t* slots;                            /* Slot of event data at index position */
+    uint32_t* maxEnds;                          /* Max tree of end times, 2 * capacity nodes, root is node 1 */
+    uint32_t* idSlots;                          /* Hash of event_id to slot, 2 * capacity entries */
+    uint32_t* slotStartTimes;                   /* Event data by slot, slots 0..count - 1 are used */
+    uint32_t* durations;
+    uint32_t* textOffsets[EPG_TEXT_COUNT];      /* Offsets of texts in arena of sub-table */
+    uint16_t* eventIds;
+    uint8_t* tableIds;
+    uint32_t count;
+    uint32_t capacity;
+    TextArena arenas[EPG_STORE_TABLES];
+}EpgStore;
+
+/**
+ * @brief Initializes empty store, nothing is allocated until first insert
+ *
+ * @param [out] store - EPG store
+ * @return EPG store error code
+ */
+EpgStoreError epgStoreInit(EpgStore* store);
+
+/**
+ * @brief Frees all events of store
+ *
+ * @param [in] store - EPG store
+ * @return EPG store error code
+ */
+EpgStoreError epgStoreDeinit(EpgStore* store);
+
+/**
+ * @brief Inserts events at their start time, stored event with the same event_id is replaced, O(n) per 32 events
+ *
+ * @param [in] store - EPG store
+ * @param [in] events - events, in any order
+ * @param [in] texts - description texts of events, NULL if events have none
+ * @param [in] count - number of events
+ * @return EPG store error code, events before the failed one are stored
+ */
+EpgStoreError epgStoreInsert(EpgStore* store, const EpgEvent* events, const EpgEventText* texts, uint32_t count);
+
+/**
+ * @brief Removes all events received in sub-table
+ *
+ * @param [in] store - EPG store
+ * @param [in] tableId - table_id of sub-table
+ */
+void epgStoreRemoveTable(EpgStore* store, uint8_t tableId);
+
+/**
+ * @brief Frees text memory of sub-table allocated beyond its texts, for sub-tables that were completed
+ *
+ * @param [in] store - EPG store
+ * @param [in] tableId - table_id of sub-table
+ */
+void epgStoreTrimTable(EpgStore* store, uint8_t tableId);
+
+/**
+ * @brief Finds event running at time and the event after it, O(log n)
+ *
+ * @param [in] store - EPG store
+ * @param [in] time - seconds since 1970-01-01 UTC
+ * @param [out] now - index of event running at time, earliest start if events overlap
+ * @param [out] next - index of first event starting after time
+ * @return EPG_FOUND_NOW and EPG_FOUND_NEXT flags of found events
+ */
+uint8_t epgStoreFindNowNext(const EpgStore* store, uint32_t time, uint32_t* now, uint32_t* next);
+
+/**
+ * @brief Copies events that overlap time range, ordered by start time, O((k + 1) log n)
+ *
+ * @param [in] store - EPG store
+ * @param [in] from - range start, seconds since 1970-01-01 UTC
+ * @param [in] to - range end, exclusive
+ * @param [out] events - event array
+ * @param [in] maxCount - size of event array
+ * @return number of copied events
+ */
+uint32_t epgStoreGetEvents(const EpgStore* store, uint32_t from, uint32_t to, EpgEvent* events, uint32_t maxCount);
+
+/**
+ * @brief Copies one event
+ *
+ * @param [in] store - EPG store
+ * @param [in] index - event index, less than count
+ * @param [out] event - event
+ */
+void epgStoreGetEvent(const EpgStore* store, uint32_t index, EpgEvent* event);
+
+/**
+ * @brief Finds event by event_id, O(log n)
+ *
+ * @param [in] store - EPG store
+ * @param [in] eventId - event_id
+ * @param [out] index - event index
+ * @return true if event is stored
+ */
+bool epgStoreFindEvent(const EpgStore* store, uint16_t eventId, uint32_t* index);
+
+/**
+ * @brief Returns text of event, pointer is valid until next update of store
+ *
+ * @param [in] store - EPG store
+ * @param [in] index - event index, less than count
+ * @param [in] text - text type
+ * @return zero terminated text, empty if event has none
+ */
+const char* epgStoreText(const EpgStore* store, uint32_t index, EpgText text);
+
+/**
+ * @brief Returns bytes allocated by store
+ *
+ * @param [in] store - EPG store
+ * @return allocated bytes
+ */
+uint32_t epgStoreMemory(const EpgStore* store);
+
+#endif /* __EPG_STORE_H__ */
@@ -1,38 +1,96 @@
 #include "graphic_controller.h"
+#include "latency_stats.h"
 
-static timer_t timerId;
 static IDirectFBSurface *primary = NULL;
 static DFBSurfaceDescription surfaceDesc;
 IDirectFB *dfbInterface = NULL;
 static int32_t screenWidth = 0;
 static int32_t screenHeight = 0;
 static bool isInitialized = false;
-static uint8_t threadExit = 0;
-static ScreenState state = {false, false, false, false, false};
 
-static int32_t programNumberRender = 0;
-static int32_t volumeLevelRender = 0;
-static int32_t audioPidRender = 0;
-static int32_t videoPidRender = 0;
-static int32_t teletextRender = 0;
-static char timeRender[6];
-static char nameRender[50];
+static RenderRequestQueue requestQueue;
+static RenderData render;                   /* Data of current frame, owned by render thread */
 
-static struct itimerspec timerSpec;
-static struct itimerspec timerSpecOld;
+static FontCacheEntry fontCache[FONT_CACHE_SIZE];
+static IDirectFBSurface *volumeAtlas = NULL;
+static DFBRectangle volumeIcons[VOLUME_LEVEL_COUNT];
+static int32_t volumeIconWidth = 0;
+static int32_t volumeIconHeight = 0;
+static OsdElementState osdElements[OSD_ELEMENT_COUNT];
+static CompositorStats compositorStats;
+static const char* labelStrings[OSD_LABEL_COUNT] =
+{
+    "Audio PID: ",
+    "Video PID: ",
+    "Program number: ",
+    "TXT",
+    "NO TXT"
+};
+
+static OsdTimerWheel timerWheel;
+static const uint32_t osdTimeouts[OSD_ELEMENT_COUNT] =
+{
+    OSD_CHANNEL_TIMEOUT_MS,
+    OSD_BANNER_TIMEOUT_MS,
+    OSD_VOLUME_TIMEOUT_MS
+};
+
+static const KeyLatencyType requestKeyTypes[GC_REQ_COUNT] =
+{
+    KEY_LATENCY_ZAP,
+    KEY_LATENCY_VOLUME,
+    KEY_LATENCY_INFO,
+    KEY_LATENCY_COUNT                       /* Deinit is never keyed */
+};
 
 static pthread_t gcThread;
 
 static void* graphicControllerTask();
-static void wipeScreen(union sigval signalArg);
-static void drawProgram(int32_t keycode);
-static void drawVolumeSymbol(int32_t volumeLevel);
-static void drawBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name);
-static void refreshScreen();
+static void initGraphics();
+static void deinitGraphics();
+static void drawProgram(IDirectFBSurface* surface, int32_t keycode);
+static void drawVolumeSymbol(IDirectFBSurface* surface, int32_t volumeLevel);
+static void drawBanner(IDirectFBSurface* surface, int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name);
+static void initCompositor();
+static void showElement(OsdElement element);
+static void hideElement(OsdElement element);
+static void renderLayer(OsdElement element);
+static bool contentChanged(OsdElement element);
+static void releaseLayers();
+static bool composeFrame();
+static void fillRectangle(IDirectFBSurface* surface, int32_t x, int32_t y, int32_t width, int32_t height);
+static void countBytesFilled(int32_t width, int32_t height);
+static void postRequest(RenderRequestType type, const RenderData* data, const struct timespec* keyTime);
+static bool takeRequests(bool* requests, bool* keyed, struct timespec* keyTimes, const struct timespec* frameTime, const struct timespec* deadline);
+static void timerWheelInit();
+static void timerWheelArm(OsdElement element, uint32_t milliseconds);
+static uint8_t timerWheelAdvance();
+static bool timerWheelNextDeadline(struct timespec* deadline);
+static uint32_t timerWheelTick(const struct timespec* time);
+static void setFrameTime(struct timespec* frameTime);
+static FontCacheEntry* getFont(int32_t height);
+static void releaseFontCache();
+static void releaseFontCacheEntry(FontCacheEntry* entry);
+static void prerenderText(FontCacheEntry* entry, const char* text, PrerenderedText* prerendered);
+static void drawText(IDirectFBSurface* surface, FontCacheEntry* entry, OsdLabel label, const char* value, int32_t x, int32_t y, DFBSurfaceTextFlags flags);
+static void fitText(FontCacheEntry* entry, char* text, uint32_t textSize, int32_t maxWidth);
+static void loadVolumeAtlas();
 
 
 GraphicControllerError graphicControllerInit()
 {
+    pthread_condattr_t condAttr;
+
+    /* initialize request queue, frame pacing is measured on monotonic clock */
+    memset(requestQueue.pending, 0x0, sizeof(requestQueue.pending));
+    memset(&requestQueue.data, 0x0, sizeof(requestQueue.data));
+    memset(requestQueue.keyed, 0x0, sizeof(requestQueue.keyed));
+    pthread_mutex_init(&requestQueue.mutex, NULL);
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&requestQueue.cond, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+
     if (pthread_create(&gcThread, NULL, &graphicControllerTask, NULL))
     {
         printf("Error creating input event task!\n");
@@ -50,7 +108,7 @@ GraphicControllerError graphicControllerDeinit()
         return GC_ERROR;
     }
     
-    threadExit = 1;
+    postRequest(GC_REQ_DEINIT, NULL, NULL);
     if (pthread_join(gcThread, NULL))
     {
         printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
@@ -58,9 +116,7 @@ GraphicControllerError graphicControllerDeinit()
     }
 
 	/* clean up */
-	timer_delete(timerId);
-	primary->Release(primary);
-	dfbInterface->Release(dfbInterface);
+	deinitGraphics();
 
 	/* set isInitialized flag */
     isInitialized = false;
@@ -68,36 +124,183 @@ GraphicControllerError graphicControllerDeinit()
     return GC_NO_ERROR;
 }
 
-GraphicControllerError drawCnannel(int32_t channelNumber)
+GraphicControllerError drawCnannel(int32_t channelNumber, const struct timespec* keyTime)
 {
-	programNumberRender = channelNumber;
-	state.drawChannel = true;
+	RenderData data;
+
+	data.programNumber = channelNumber;
+	postRequest(GC_REQ_CHANNEL, &data, keyTime);
+
+	return GC_NO_ERROR;
 }
 
-GraphicControllerError drawVolumeLevel(int32_t volumeLevel)
+GraphicControllerError drawVolumeLevel(int32_t volumeLevel, const struct timespec* keyTime)
 {
-	volumeLevelRender = volumeLevel;
-	state.drawVolumeChange = true;
+	RenderData data;
+
+	data.volumeLevel = volumeLevel;
+	postRequest(GC_REQ_VOLUME, &data, keyTime);
+
+	return GC_NO_ERROR;
+}
+
+GraphicControllerError drawInfoBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name, const struct timespec* keyTime)
+{
+	RenderData data;
+
+	data.audioPid = audioPid;
+	data.videoPid = videoPid;
+	data.teletext = teletext;
+	data.programNumber = channelNumber;
+	strncpy(data.time, time, GC_TIME_LEN);
+	data.time[GC_TIME_LEN - 1] = '\0';
+	strncpy(data.name, name, GC_NAME_LEN);
+	data.name[GC_NAME_LEN - 1] = '\0';
+	postRequest(GC_REQ_BANNER, &data, keyTime);
+
+	return GC_NO_ERROR;
 }
 
-GraphicControllerError drawInfoBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name)
+GraphicControllerError graphicControllerBenchmark(uint32_t iterations, OsdBenchResult* result)
 {
-	audioPidRender = audioPid;
-	videoPidRender = videoPid;
-	teletextRender = teletext;
-	programNumberRender = channelNumber;
-	strncpy(timeRender,time,6);
-	strncpy(nameRender,name,50);
-	state.drawInfo = true;	
+	struct timespec start;
+	struct timespec end;
+	uint32_t iteration;
+	uint8_t i;
+
+	if (isInitialized || result == NULL)
+	{
+		printf("\n%s : ERROR render thread is running or result is NULL!\n", __FUNCTION__);
+		return GC_ERROR;
+	}
+
+	memset(result, 0x0, sizeof(OsdBenchResult));
+	result->draws[OSD_ELEMENT_CHANNEL].name = "draw channel";
+	result->draws[OSD_ELEMENT_BANNER].name = "draw banner";
+	result->draws[OSD_ELEMENT_VOLUME].name = "draw volume";
+	result->frame.name = "compose frame";
+
+	initGraphics();
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		/* content differs every iteration, as on consecutive zaps */
+		render.programNumber = iteration % 1000;
+		render.volumeLevel = iteration % VOLUME_LEVEL_COUNT;
+		render.audioPid = 100 + iteration % 8000;
+		render.videoPid = (iteration & 1) ? -1 : 200 + iteration % 8000;
+		render.teletext = (iteration & 2) != 0;
+		snprintf(render.time, GC_TIME_LEN, "%02u:%02u", (iteration / 60) % 24, iteration % 60);
+		snprintf(render.name, GC_NAME_LEN, "Benchmark event %u", iteration);
+
+		for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			renderLayer(i);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			latencyHistogramRecord(&result->draws[i], latencyElapsed(&start, &end));
+			osdElements[i].visible = true;
+			osdElements[i].dirty = true;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		composeFrame();
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		latencyHistogramRecord(&result->frame, latencyElapsed(&start, &end));
+		compositorStats.lastFrameBytes = 0;
+	}
+	result->bytesPerFrame = iterations ? (uint32_t)(compositorStats.bytesFilled / iterations) : 0;
+
+	deinitGraphics();
+
+	return GC_NO_ERROR;
 }
 
 static void* graphicControllerTask()
 {
-	int32_t ret;
+	bool requests[GC_REQ_COUNT];
+	bool keyed[GC_REQ_COUNT];
+	struct timespec keyTimes[GC_REQ_COUNT];
+	struct timespec frameTime;
+	struct timespec deadline;
+	uint8_t expired;
+	uint8_t i;
+
+    initGraphics();
+
+    /* element timeouts are handled in this thread */
+    timerWheelInit();
+
+    /* set isInitialized flag */
+    isInitialized = true;
+
+	/* first frame can be drawn immediately */
+	clock_gettime(CLOCK_MONOTONIC, &frameTime);
+
+	while (true)
+	{	
+		/* sleeps until a request is posted or an element expires, requests posted until the frame time are drawn in one frame */
+		memset(keyed, 0x0, sizeof(keyed));
+		if (takeRequests(requests, keyed, keyTimes, &frameTime, timerWheelNextDeadline(&deadline) ? &deadline : NULL))
+		{
+			if (requests[GC_REQ_DEINIT])
+			{
+				break;
+			}
+
+			if (requests[GC_REQ_CHANNEL])
+			{
+				printf("Draw channel number!\n");
+				showElement(OSD_ELEMENT_CHANNEL);
+			}
 
-	/* structure for timer specification */
-    struct sigevent signalEvent;
+			if (requests[GC_REQ_BANNER])
+			{
+				printf("Draw banner!\n");
+				showElement(OSD_ELEMENT_BANNER);
+			}
 
+			if (requests[GC_REQ_VOLUME])
+			{
+				printf("Draw volume change!\n");
+				showElement(OSD_ELEMENT_VOLUME);
+			}
+		}
+
+		/* only regions of expired elements are cleared */
+		expired = timerWheelAdvance();
+		for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+		{
+			if (expired & (1 << i))
+			{
+				printf("OSD element %d expired!\n", i);
+				hideElement(i);
+			}
+		}
+
+		if (composeFrame())
+		{
+			printf("Frame %u composed, %u bytes filled\n", compositorStats.frames, compositorStats.lastFrameBytes);
+			compositorStats.lastFrameBytes = 0;
+		}
+
+		/* requested content is on screen now, also if it was already shown and nothing was flipped */
+		for (i = 0; i < GC_REQ_COUNT; i++)
+		{
+			if (keyed[i])
+			{
+				keyLatencyRecord(requestKeyTypes[i], &keyTimes[i]);
+			}
+		}
+		setFrameTime(&frameTime);
+	}
+
+	return 0;
+}
+
+/* Creates DirectFB surfaces, fonts, icons and element layers */
+void initGraphics()
+{
     /* initialize DirectFB */    
 	DFBCHECK(DirectFBInit(NULL, NULL));
 	DFBCHECK(DirectFBCreate(&dfbInterface));
@@ -112,295 +315,817 @@ static void* graphicControllerTask()
     /* fetch the screen size */
     DFBCHECK (primary->GetSize(primary, &screenWidth, &screenHeight));
 
+    /* load font and pre-render glyphs once, draws only blit them */
+    memset(fontCache, 0x0, sizeof(fontCache));
+    getFont(FONT_HEIGHT_CHANNEL);
 
-	signalEvent.sigev_notify = SIGEV_THREAD; /* tell the OS to notify you about timer by calling the specified function */
-    signalEvent.sigev_notify_function = wipeScreen; /* function to be called when timer runs out */
-    signalEvent.sigev_value.sival_ptr = NULL; /* thread arguments */
-    signalEvent.sigev_notify_attributes = NULL; /* thread attributes (e.g. thread stack size) - if NULL default attributes are applied */
-    ret = timer_create(/*clock for time measuring*/CLOCK_REALTIME,
-                       /*timer settings*/&signalEvent,
-                       /*where to store the ID of the newly created timer*/&timerId);
-    if(ret == -1)
-	{
-        printf("Error creating timer, abort!\n");
-        primary->Release(primary);
-        dfbInterface->Release(dfbInterface);
-        
-        return 0;
-    }
-
-    /* set isInitialized flag */
-    isInitialized = true;
-
-	while (!threadExit)
-	{	
-		if (state.drawChannel)
-		{
-			refreshScreen();
-			printf("Draw channel number!\n");
-			drawProgram(programNumberRender);
-			state.drawChannel = false;
-		}
-
-		if (state.drawInfo)
-		{
-			refreshScreen();
-			printf("Draw banner!\n");
-			drawBanner(programNumberRender, audioPidRender, videoPidRender, teletextRender, timeRender, nameRender);
-			state.drawInfo = false;
-		}
+    /* decode all volume icons once */
+    loadVolumeAtlas();
 
-		if (state.drawVolumeChange)
-		{
-			refreshScreen();
-			printf("Draw volume change!\n");
-			drawVolumeSymbol(volumeLevelRender);
-			state.drawVolumeChange = false;
-		}		
-	}
+    /* start from empty screen, later frames update only dirty regions */
+    initCompositor();
+}
 
+void deinitGraphics()
+{
+	releaseLayers();
+	releaseFontCache();
+	volumeAtlas->Release(volumeAtlas);
+	primary->Release(primary);
+	dfbInterface->Release(dfbInterface);
 }
 
-void drawProgram(int32_t keycode)
+/* Draws channel number box, coordinates are relative to element region */
+void drawProgram(IDirectFBSurface* surface, int32_t keycode)
 {
     int32_t ret;
-    IDirectFBFont *fontInterface = NULL;
-    DFBFontDescription fontDesc;
-    char keycodeString[4];
+    FontCacheEntry *font = getFont(FONT_HEIGHT_CHANNEL);
+    char keycodeString[12];
         
     /*  draw the frame */
     
-    DFBCHECK(primary->SetColor(primary, 0x40, 0x10, 0x80, 0xff));
-    DFBCHECK(primary->FillRectangle(primary, 50, 50, screenWidth/8, screenHeight/8));
+    DFBCHECK(surface->SetColor(surface, 0x40, 0x10, 0x80, 0xff));
+    fillRectangle(surface, 0, 0, screenWidth/8, screenHeight/8);
     
-    DFBCHECK(primary->SetColor(primary, 0xff, 0x0d, 0x46, 0xff));
-    DFBCHECK(primary->FillRectangle(primary, 50+FRAME_THICKNESS, 50+FRAME_THICKNESS, screenWidth/8-2*FRAME_THICKNESS, screenHeight/8-2*FRAME_THICKNESS));
+    DFBCHECK(surface->SetColor(surface, 0xff, 0x0d, 0x46, 0xff));
+    fillRectangle(surface, FRAME_THICKNESS, FRAME_THICKNESS, screenWidth/8-2*FRAME_THICKNESS, screenHeight/8-2*FRAME_THICKNESS);
     
     
     /* draw keycode */
     
-	fontDesc.flags = DFDESC_HEIGHT;
-	fontDesc.height = FONT_HEIGHT_CHANNEL;
-	
-	DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-	DFBCHECK(primary->SetFont(primary, fontInterface));
-    
     /* generate keycode string */
     sprintf(keycodeString,"%d",keycode);
     
     /* draw the string */
-    DFBCHECK(primary->SetColor(primary, 0xff, 0xff, 0xff, 0xff));
-	DFBCHECK(primary->DrawString(primary, keycodeString, -1, 50+screenWidth/16, 50+screenHeight/16 + FONT_HEIGHT_CHANNEL/2, DSTF_CENTER));
-    
-    
-    /* update screen */
-    DFBCHECK(primary->Flip(primary, NULL, 0));
-    
+	drawText(surface, font, OSD_LABEL_NONE, keycodeString, screenWidth/16, screenHeight/16 + FONT_HEIGHT_CHANNEL/2, DSTF_CENTER);
+    zapStatsMark(ZAP_STAGE_OSD_DRAWN);
 }
 
-void drawVolumeSymbol(int32_t volumeLevel)
+/* Draws volume icon aligned to bottom right corner of element region */
+void drawVolumeSymbol(IDirectFBSurface* surface, int32_t volumeLevel)
 {
-    int32_t ret;
-	IDirectFBImageProvider *provider;
-	IDirectFBSurface *volumeSurface = NULL;
-	int32_t volumeHeight, volumeWidth;
+	DFBRectangle* icon;
 	
-    /* create the image provider for the specified file */
-	switch (volumeLevel)
+	if (volumeLevel < 0)
 	{
-		case 0:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_0.png", &provider));	
-			break;
-		case 1:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_1.png", &provider));	
-			break;
-		case 2:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_2.png", &provider));	
-			break;
-		case 3:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_3.png", &provider));	
-			break;
-		case 4:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_4.png", &provider));	
-			break;
-		case 5:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_5.png", &provider));	
-			break;
-		case 6:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_6.png", &provider));	
-			break;
-		case 7:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_7.png", &provider));	
-			break;
-		case 8:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_8.png", &provider));	
-			break;
-		case 9:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_9.png", &provider));	
-			break;
-		case 10:
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_10.png", &provider));	
-			break;
+		volumeLevel = 0;
 	}
-
-    /* get surface descriptor for the surface where the image will be rendered */
-	DFBCHECK(provider->GetSurfaceDescription(provider, &surfaceDesc));
-    /* create the surface for the image */
-	DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &surfaceDesc, &volumeSurface));
-    /* render the image to the surface */
-	DFBCHECK(provider->RenderTo(provider, volumeSurface, NULL));
-	
-    /* cleanup the provider after rendering the image to the surface */
-	provider->Release(provider);
-	
-    /* fetch the logo size and add (blit) it to the screen */
-	DFBCHECK(volumeSurface->GetSize(volumeSurface, &volumeWidth, &volumeHeight));
-	DFBCHECK(primary->Blit(primary,
-                           /*source surface*/ volumeSurface,
-                           /*source region, NULL to blit the whole surface*/ NULL,
-                           /*destination x coordinate of the upper left corner of the image*/screenWidth - volumeWidth - 50,
-                           /*destination y coordinate of the upper left corner of the image*/screenHeight/2 - volumeHeight -50));
-    
-    
-    /* switch between the displayed and the work buffer (update the display) */
-	DFBCHECK(primary->Flip(primary,
-                           /*region to be updated, NULL for the whole surface*/NULL,
-                           /*flip flags*/0));
-    
-    
-    /* set the timer for clearing the screen */
-    
-    memset(&timerSpec,0,sizeof(timerSpec));
-    
-    /* specify the timer timeout time */
-    timerSpec.it_value.tv_sec = 3;
-    timerSpec.it_value.tv_nsec = 0;
-    
-    /* set the new timer specs */
-    ret = timer_settime(timerId,0,&timerSpec,&timerSpecOld);
-    if(ret == -1)
+	else if (volumeLevel >= VOLUME_LEVEL_COUNT)
 	{
-        printf("Error setting timer in %s!\n", __FUNCTION__);
-    }
-
+		volumeLevel = VOLUME_LEVEL_COUNT - 1;
+	}
+	icon = &volumeIcons[volumeLevel];
+	
+    /* add (blit) icon of this level from the atlas to the layer */
+	DFBCHECK(surface->Blit(surface,
+                           /*source surface*/ volumeAtlas,
+                           /*source region, icon of this level*/ icon,
+                           /*destination x coordinate of the upper left corner of the image*/volumeIconWidth - icon->w,
+                           /*destination y coordinate of the upper left corner of the image*/volumeIconHeight - icon->h));
+	countBytesFilled(icon->w, icon->h);
 }
 
-void drawBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name)
+/* Draws info banner, coordinates are relative to element region */
+void drawBanner(IDirectFBSurface* surface, int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name)
 {
-    int32_t ret;
-
-    IDirectFBFont *fontInterface = NULL;
-    DFBFontDescription fontDesc;
-	char audioInfo[20];     
-	char videoInfo[20];
-	char audioPidStr[5];
-	char videoPidStr[5];
-	char channelNumStr[5];
-	char txtInfo[8];
+    FontCacheEntry *font = getFont(FONT_HEIGHT_CHANNEL);
+	char audioPidStr[12];
+	char videoPidStr[12];
+	char channelNumStr[12];
 	char timeInfo[6];
-	char nameInfo[50];
-	char cnannelNumberInfo[20];
-	
+	char nameInfo[GC_NAME_LEN];
 	
-	strcpy(audioInfo, "Audio PID: ");
-	strcpy(videoInfo, "Video PID: ");
-	strcpy(cnannelNumberInfo, "Program number: ");
-
     /*  draw the frame */
         
-    DFBCHECK(primary->SetColor(primary, 0xff, 0x0d, 0x46, 0xff));
-    DFBCHECK(primary->FillRectangle(primary, 50, (screenHeight/3)*2, screenWidth-100, screenHeight/4));
+    DFBCHECK(surface->SetColor(surface, 0xff, 0x0d, 0x46, 0xff));
+    fillRectangle(surface, 50, 0, screenWidth-100, screenHeight/4);
       
     /* draw info */
-    
-	fontDesc.flags = DFDESC_HEIGHT;
-	fontDesc.height = FONT_HEIGHT_CHANNEL;
-	
-	DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-	DFBCHECK(primary->SetFont(primary, fontInterface));
-
 
 	/* generate audioPid string */
     sprintf(audioPidStr,"%d",audioPid);
-	strcat(audioInfo, audioPidStr);
 	/* generate videoPid string */
     sprintf(videoPidStr,"%d",videoPid);
-	strcat(videoInfo, videoPidStr);
-    /* generate teletext string */
-    if (teletext)
-    {
-    	strcpy(txtInfo, "TXT");
-    }
-    else
-    {
-    	strcpy(txtInfo, "NO TXT");
-    }
     /* generate time string */
 	strncpy(timeInfo, time,6);
-    /* generate time string */
-	strncpy(nameInfo, name,50);	
+	timeInfo[5] = '\0';
+    /* generate name string, centered name must not reach into the time */
+	strncpy(nameInfo, name, GC_NAME_LEN);
+	nameInfo[GC_NAME_LEN - 1] = '\0';
+	fitText(font, nameInfo, GC_NAME_LEN, 2 * ((screenWidth/2) - 100 - ((screenWidth/8) + 25)));
 	/* generate channel number string */
 	sprintf(channelNumStr,"%d",channelNumber);
-	strcat(cnannelNumberInfo, channelNumStr);
 
 
-    /* draw the string */
+    /* draw the string, labels and digits are pre-rendered */
 
-    DFBCHECK(primary->SetColor(primary, 0xff, 0xff, 0xff, 0xff));
-	DFBCHECK(primary->DrawString(primary, audioInfo, -1, (screenWidth/8) + 100, (screenHeight/3)*2 + FONT_HEIGHT_CHANNEL, DSTF_CENTER));   
-	DFBCHECK(primary->DrawString(primary, txtInfo, -1, screenWidth-300, (screenHeight/3)*2 + FONT_HEIGHT_CHANNEL, DSTF_CENTER));    
-	DFBCHECK(primary->DrawString(primary, cnannelNumberInfo, -1, (screenWidth/8) + 140, (screenHeight/3)*2 + 4*FONT_HEIGHT_CHANNEL + 40, DSTF_CENTER));
+	drawText(surface, font, OSD_LABEL_AUDIO_PID, audioPidStr, (screenWidth/8) + 100, FONT_HEIGHT_CHANNEL, DSTF_CENTER);
+	drawText(surface, font, teletext ? OSD_LABEL_TXT : OSD_LABEL_NO_TXT, "", screenWidth-300, FONT_HEIGHT_CHANNEL, DSTF_CENTER);
+	drawText(surface, font, OSD_LABEL_PROGRAM_NUMBER, channelNumStr, (screenWidth/8) + 140, 4*FONT_HEIGHT_CHANNEL + 40, DSTF_CENTER);
 	if (videoPid != -1)
 	{
-		DFBCHECK(primary->DrawString(primary, videoInfo, -1, (screenWidth/8) + 100, (screenHeight/3)*2 + 2*FONT_HEIGHT_CHANNEL, DSTF_CENTER)); 
-	    DFBCHECK(primary->DrawString(primary, timeInfo, -1, (screenWidth/8) - 25, (screenHeight/3)*2 + 3*FONT_HEIGHT_CHANNEL + 20, DSTF_CENTER));
-	    DFBCHECK(primary->DrawString(primary, nameInfo, -1, (screenWidth/2) - 100, (screenHeight/3)*2 + 3*FONT_HEIGHT_CHANNEL + 20, DSTF_CENTER));
+		drawText(surface, font, OSD_LABEL_VIDEO_PID, videoPidStr, (screenWidth/8) + 100, 2*FONT_HEIGHT_CHANNEL, DSTF_CENTER);
+	    drawText(surface, font, OSD_LABEL_NONE, timeInfo, (screenWidth/8) - 25, 3*FONT_HEIGHT_CHANNEL + 20, DSTF_CENTER);
+	    drawText(surface, font, OSD_LABEL_NONE, nameInfo, (screenWidth/2) - 100, 3*FONT_HEIGHT_CHANNEL + 20, DSTF_CENTER);
 	}
 	else
 	{
-		DFBCHECK(primary->DrawString(primary, videoInfo, -1, (screenWidth/8) + 60, (screenHeight/3)*2 + 2*FONT_HEIGHT_CHANNEL, DSTF_CENTER)); 
+		drawText(surface, font, OSD_LABEL_VIDEO_PID, videoPidStr, (screenWidth/8) + 60, 2*FONT_HEIGHT_CHANNEL, DSTF_CENTER);
 	}
-    /* update screen */
-    DFBCHECK(primary->Flip(primary, NULL, 0));
-    
-    
-    /* set the timer for clearing the screen */
-    
-    memset(&timerSpec,0,sizeof(timerSpec));
-    
-    /* specify the timer timeout time */
-    timerSpec.it_value.tv_sec = 3;
-    timerSpec.it_value.tv_nsec = 0;
-    
-    /* set the new timer specs */
-    ret = timer_settime(timerId,0,&timerSpec,&timerSpecOld);
-    if(ret == -1)
-	{
-        printf("Error setting timer in %s!\n", __FUNCTION__);
-    }
 }
 
-void refreshScreen()
+/* Sets element regions and clears both buffers of primary surface */
+void initCompositor()
 {
-    /* clear screen */
+    DFBSurfaceDescription layerDesc;
+    uint8_t i;
+
+    memset(osdElements, 0x0, sizeof(osdElements));
+    memset(&compositorStats, 0x0, sizeof(compositorStats));
+
+    osdElements[OSD_ELEMENT_CHANNEL].region.x = 50;
+    osdElements[OSD_ELEMENT_CHANNEL].region.y = 50;
+    osdElements[OSD_ELEMENT_CHANNEL].region.w = screenWidth/8;
+    osdElements[OSD_ELEMENT_CHANNEL].region.h = screenHeight/8;
+
+    /* banner strings reach below the frame, down to the bottom of the screen */
+    osdElements[OSD_ELEMENT_BANNER].region.x = 0;
+    osdElements[OSD_ELEMENT_BANNER].region.y = (screenHeight/3)*2;
+    osdElements[OSD_ELEMENT_BANNER].region.w = screenWidth;
+    osdElements[OSD_ELEMENT_BANNER].region.h = screenHeight - (screenHeight/3)*2;
+
+    /* icons are aligned to the bottom right corner of this region */
+    osdElements[OSD_ELEMENT_VOLUME].region.x = screenWidth - volumeIconWidth - 50;
+    osdElements[OSD_ELEMENT_VOLUME].region.y = screenHeight/2 - volumeIconHeight - 50;
+    osdElements[OSD_ELEMENT_VOLUME].region.w = volumeIconWidth;
+    osdElements[OSD_ELEMENT_VOLUME].region.h = volumeIconHeight;
+
+    layerDesc.flags = DSDESC_CAPS | DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+    layerDesc.caps = DSCAPS_NONE;
+    layerDesc.pixelformat = DSPF_ARGB;
+    for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+    {
+        layerDesc.width = osdElements[i].region.w;
+        layerDesc.height = osdElements[i].region.h;
+        DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &layerDesc, &osdElements[i].layer));
+    }
+
+    /* text is blended over the frame, icon is copied with its alpha */
+    DFBCHECK(osdElements[OSD_ELEMENT_CHANNEL].layer->SetBlittingFlags(osdElements[OSD_ELEMENT_CHANNEL].layer, DSBLIT_BLEND_ALPHACHANNEL));
+    DFBCHECK(osdElements[OSD_ELEMENT_BANNER].layer->SetBlittingFlags(osdElements[OSD_ELEMENT_BANNER].layer, DSBLIT_BLEND_ALPHACHANNEL));
+    DFBCHECK(osdElements[OSD_ELEMENT_VOLUME].layer->SetBlittingFlags(osdElements[OSD_ELEMENT_VOLUME].layer, DSBLIT_NOFX));
+
     DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
-    DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
-    
-    /* update screen */
-    DFBCHECK(primary->Flip(primary, NULL, 0));
+    for (i = 0; i < 2; i++)
+    {
+        DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
+        DFBCHECK(primary->Flip(primary, NULL, 0));
+    }
 }
 
-void wipeScreen(union sigval signalArg)
+/* Shows element and restarts its timeout
+ * Layer is rendered again only if element content changed, showing unchanged visible element draws nothing
+ */
+void showElement(OsdElement element)
 {
-	printf("Screen wiping!\n");
+    if (contentChanged(element))
+    {
+        renderLayer(element);
+        osdElements[element].dirty = true;
+    }
+    if (!osdElements[element].visible)
+    {
+        osdElements[element].visible = true;
+        osdElements[element].dirty = true;
+    }
+    timerWheelArm(element, osdTimeouts[element]);
+}
 
-    /* clear screen */
-    DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
-    DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
-    
-    /* update screen */
-    DFBCHECK(primary->Flip(primary, NULL, 0));  
+void hideElement(OsdElement element)
+{
+    if (osdElements[element].visible)
+    {
+        osdElements[element].visible = false;
+        osdElements[element].dirty = true;
+    }
+}
+
+/* Returns true if data of current frame differs from data element layer was rendered from */
+bool contentChanged(OsdElement element)
+{
+    RenderData* content = &osdElements[element].content;
+
+    if (!osdElements[element].rendered)
+    {
+        return true;
+    }
+
+    switch (element)
+    {
+        case OSD_ELEMENT_CHANNEL:
+            return content->programNumber != render.programNumber;
+        case OSD_ELEMENT_BANNER:
+            return content->programNumber != render.programNumber ||
+                   content->audioPid != render.audioPid ||
+                   content->videoPid != render.videoPid ||
+                   content->teletext != render.teletext ||
+                   strcmp(content->time, render.time) ||
+                   strcmp(content->name, render.name);
+        case OSD_ELEMENT_VOLUME:
+            return content->volumeLevel != render.volumeLevel;
+        default:
+            return false;
+    }
+}
+
+/* Renders element from data of current frame into its layer */
+void renderLayer(OsdElement element)
+{
+    IDirectFBSurface* layer = osdElements[element].layer;
+
+    DFBCHECK(layer->Clear(layer, 0x00, 0x00, 0x00, 0x00));
+    countBytesFilled(osdElements[element].region.w, osdElements[element].region.h);
+
+    switch (element)
+    {
+        case OSD_ELEMENT_CHANNEL:
+            drawProgram(layer, render.programNumber);
+            break;
+        case OSD_ELEMENT_BANNER:
+            drawBanner(layer, render.programNumber, render.audioPid, render.videoPid, render.teletext, render.time, render.name);
+            break;
+        case OSD_ELEMENT_VOLUME:
+            drawVolumeSymbol(layer, render.volumeLevel);
+            break;
+        default:
+            break;
+    }
+
+    osdElements[element].content = render;
+    osdElements[element].rendered = true;
+}
+
+void releaseLayers()
+{
+    uint8_t i;
+
+    for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+    {
+        if (osdElements[i].layer != NULL)
+        {
+            osdElements[i].layer->Release(osdElements[i].layer);
+            osdElements[i].layer = NULL;
+        }
+    }
+}
+
+/* Composes dirty regions from layers into back buffer and shows them with one flip, returns false if nothing was dirty
+ * Flip with region copies only that region to front buffer, so back buffer keeps content of previous frames
+ */
+bool composeFrame()
+{
+    DFBRectangle* region;
+    DFBRegion clip;
+    DFBRegion flipRegion;
+    bool dirty = false;
+    bool channelDrawn = false;
+    uint8_t i;
+    uint8_t j;
+
+    for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+    {
+        if (!osdElements[i].dirty)
+        {
+            continue;
+        }
+        osdElements[i].dirty = false;
+        region = &osdElements[i].region;
+
+        clip.x1 = region->x;
+        clip.y1 = region->y;
+        clip.x2 = region->x + region->w - 1;
+        clip.y2 = region->y + region->h - 1;
+        DFBCHECK(primary->SetClip(primary, &clip));
+
+        /* layer covers whole region, copying it replaces old content without clearing */
+        if (osdElements[i].visible)
+        {
+            DFBCHECK(primary->SetBlittingFlags(primary, DSBLIT_NOFX));
+            DFBCHECK(primary->Blit(primary, osdElements[i].layer, NULL, region->x, region->y));
+            countBytesFilled(region->w, region->h);
+            channelDrawn |= (i == OSD_ELEMENT_CHANNEL);
+        }
+        else
+        {
+            DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
+            fillRectangle(primary, region->x, region->y, region->w, region->h);
+        }
+
+        /* other visible elements that overlap the region are blended on top */
+        DFBCHECK(primary->SetBlittingFlags(primary, DSBLIT_BLEND_ALPHACHANNEL));
+        for (j = 0; j < OSD_ELEMENT_COUNT; j++)
+        {
+            if (j != i && osdElements[j].visible &&
+                osdElements[j].region.x < clip.x2 + 1 && clip.x1 < osdElements[j].region.x + osdElements[j].region.w &&
+                osdElements[j].region.y < clip.y2 + 1 && clip.y1 < osdElements[j].region.y + osdElements[j].region.h)
+            {
+                DFBCHECK(primary->Blit(primary, osdElements[j].layer, NULL, osdElements[j].region.x, osdElements[j].region.y));
+                countBytesFilled(osdElements[j].region.w, osdElements[j].region.h);
+                channelDrawn |= (j == OSD_ELEMENT_CHANNEL);
+            }
+        }
+
+        if (!dirty)
+        {
+            flipRegion = clip;
+            dirty = true;
+        }
+        else
+        {
+            flipRegion.x1 = clip.x1 < flipRegion.x1 ? clip.x1 : flipRegion.x1;
+            flipRegion.y1 = clip.y1 < flipRegion.y1 ? clip.y1 : flipRegion.y1;
+            flipRegion.x2 = clip.x2 > flipRegion.x2 ? clip.x2 : flipRegion.x2;
+            flipRegion.y2 = clip.y2 > flipRegion.y2 ? clip.y2 : flipRegion.y2;
+        }
+    }
+
+    if (!dirty)
+    {
+        return false;
+    }
+
+    DFBCHECK(primary->SetClip(primary, NULL));
+    DFBCHECK(primary->Flip(primary, &flipRegion, 0));
+    if (channelDrawn)
+    {
+        zapStatsMark(ZAP_STAGE_FIRST_FLIP);
+    }
+
+    compositorStats.frames++;
+    compositorStats.bytesFilled += compositorStats.lastFrameBytes;
+
+    return true;
+}
+
+/* Posts request, a pending request of the same type is overwritten but keeps its first key time */
+void postRequest(RenderRequestType type, const RenderData* data, const struct timespec* keyTime)
+{
+    pthread_mutex_lock(&requestQueue.mutex);
+    if (!requestQueue.pending[type])
+    {
+        requestQueue.keyed[type] = false;
+    }
+    if (keyTime != NULL && !requestQueue.keyed[type])
+    {
+        requestQueue.keyed[type] = true;
+        requestQueue.keyTimes[type] = *keyTime;
+    }
+    requestQueue.pending[type] = true;
+    switch (type)
+    {
+        case GC_REQ_CHANNEL:
+            requestQueue.data.programNumber = data->programNumber;
+            break;
+        case GC_REQ_VOLUME:
+            requestQueue.data.volumeLevel = data->volumeLevel;
+            break;
+        case GC_REQ_BANNER:
+            requestQueue.data.programNumber = data->programNumber;
+            requestQueue.data.audioPid = data->audioPid;
+            requestQueue.data.videoPid = data->videoPid;
+            requestQueue.data.teletext = data->teletext;
+            memcpy(requestQueue.data.time, data->time, GC_TIME_LEN);
+            memcpy(requestQueue.data.name, data->name, GC_NAME_LEN);
+            break;
+        default:
+            break;
+    }
+    pthread_cond_signal(&requestQueue.cond);
+    pthread_mutex_unlock(&requestQueue.mutex);
+}
+
+/* Blocks until a request is posted and frame time is reached, then takes all pending requests
+ * Requests posted while waiting for frame time are coalesced into the same frame
+ * Returns false if deadline passed without requests
+ */
+bool takeRequests(bool* requests, bool* keyed, struct timespec* keyTimes, const struct timespec* frameTime, const struct timespec* deadline)
+{
+    uint8_t i;
+    bool pending = false;
+
+    pthread_mutex_lock(&requestQueue.mutex);
+    while (!pending)
+    {
+        for (i = 0; i < GC_REQ_COUNT; i++)
+        {
+            pending |= requestQueue.pending[i];
+        }
+        if (!pending)
+        {
+            if (deadline == NULL)
+            {
+                pthread_cond_wait(&requestQueue.cond, &requestQueue.mutex);
+            }
+            else if (ETIMEDOUT == pthread_cond_timedwait(&requestQueue.cond, &requestQueue.mutex, deadline))
+            {
+                pthread_mutex_unlock(&requestQueue.mutex);
+                return false;
+            }
+        }
+    }
+    while (!requestQueue.pending[GC_REQ_DEINIT] &&
+           ETIMEDOUT != pthread_cond_timedwait(&requestQueue.cond, &requestQueue.mutex, frameTime));
+
+    memcpy(requests, requestQueue.pending, sizeof(requestQueue.pending));
+    for (i = 0; i < GC_REQ_COUNT; i++)
+    {
+        keyed[i] = requestQueue.pending[i] && requestQueue.keyed[i];
+        keyTimes[i] = requestQueue.keyTimes[i];
+    }
+    memset(requestQueue.pending, 0x0, sizeof(requestQueue.pending));
+    render = requestQueue.data;
+    pthread_mutex_unlock(&requestQueue.mutex);
+
+    return true;
+}
+
+/* Sets earliest time of next flip */
+void setFrameTime(struct timespec* frameTime)
+{
+    clock_gettime(CLOCK_MONOTONIC, frameTime);
+    frameTime->tv_nsec += (long)GC_FRAME_INTERVAL_MS * 1000000;
+    if (frameTime->tv_nsec >= 1000000000)
+    {
+        frameTime->tv_sec++;
+        frameTime->tv_nsec -= 1000000000;
+    }
+}
+
+void timerWheelInit()
+{
+    memset(&timerWheel, 0x0, sizeof(timerWheel));
+    clock_gettime(CLOCK_MONOTONIC, &timerWheel.start);
+}
+
+/* Sets element to expire after given time, earlier expiry of the element is dropped */
+void timerWheelArm(OsdElement element, uint32_t milliseconds)
+{
+    struct timespec now;
+    uint32_t expiry;
+
+    timerWheel.slots[timerWheel.expiry[element] % OSD_WHEEL_SLOTS] &= ~(1 << element);
+
+    /* rounded up, element is never removed before its time */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    expiry = timerWheelTick(&now) + (milliseconds + OSD_WHEEL_TICK_MS - 1) / OSD_WHEEL_TICK_MS;
+    if (expiry <= timerWheel.currentTick)
+    {
+        expiry = timerWheel.currentTick + 1;
+    }
+
+    timerWheel.expiry[element] = expiry;
+    timerWheel.slots[expiry % OSD_WHEEL_SLOTS] |= (1 << element);
+}
+
+/* Processes slots of ticks passed since last call, returns bit mask of expired elements */
+uint8_t timerWheelAdvance()
+{
+    struct timespec now;
+    uint32_t nowTick;
+    uint32_t steps;
+    uint32_t step;
+    uint8_t* slot;
+    uint8_t expired = 0;
+    uint8_t i;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    nowTick = timerWheelTick(&now);
+
+    /* after one full turn every slot was visited */
+    steps = nowTick - timerWheel.currentTick;
+    if (steps > OSD_WHEEL_SLOTS)
+    {
+        steps = OSD_WHEEL_SLOTS;
+    }
+
+    for (step = 1; step <= steps; step++)
+    {
+        slot = &timerWheel.slots[(timerWheel.currentTick + step) % OSD_WHEEL_SLOTS];
+        for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+        {
+            if ((*slot & (1 << i)) && timerWheel.expiry[i] <= nowTick)
+            {
+                *slot &= ~(1 << i);
+                expired |= (1 << i);
+            }
+        }
+    }
+    timerWheel.currentTick = nowTick;
+
+    return expired;
+}
+
+/* Returns time of first non empty slot, false if no element is armed */
+bool timerWheelNextDeadline(struct timespec* deadline)
+{
+    uint64_t milliseconds;
+    uint32_t step;
+
+    for (step = 1; step <= OSD_WHEEL_SLOTS; step++)
+    {
+        if (timerWheel.slots[(timerWheel.currentTick + step) % OSD_WHEEL_SLOTS])
+        {
+            milliseconds = (uint64_t)(timerWheel.currentTick + step) * OSD_WHEEL_TICK_MS;
+            deadline->tv_sec = timerWheel.start.tv_sec + milliseconds / 1000;
+            deadline->tv_nsec = timerWheel.start.tv_nsec + (milliseconds % 1000) * 1000000;
+            if (deadline->tv_nsec >= 1000000000)
+            {
+                deadline->tv_sec++;
+                deadline->tv_nsec -= 1000000000;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t timerWheelTick(const struct timespec* time)
+{
+    uint64_t milliseconds = (uint64_t)(time->tv_sec - timerWheel.start.tv_sec) * 1000 +
+                            (time->tv_nsec - timerWheel.start.tv_nsec) / 1000000;
+
+    return (uint32_t)(milliseconds / OSD_WHEEL_TICK_MS);
+}
+
+void fillRectangle(IDirectFBSurface* surface, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    DFBCHECK(surface->FillRectangle(surface, x, y, width, height));
+    countBytesFilled(width, height);
+}
+
+void countBytesFilled(int32_t width, int32_t height)
+{
+    compositorStats.lastFrameBytes += (uint32_t)width * height * OSD_BYTES_PER_PIXEL;
+}
+
+/* Returns font of given height, font is loaded and its glyphs and labels are pre-rendered on first use */
+FontCacheEntry* getFont(int32_t height)
+{
+    DFBFontDescription fontDesc;
+    FontCacheEntry* entry = NULL;
+    char glyph[2] = {0, 0};
+    uint8_t i;
+
+    for (i = 0; i < FONT_CACHE_SIZE; i++)
+    {
+        if (fontCache[i].height == height)
+        {
+            return &fontCache[i];
+        }
+        if (fontCache[i].height == 0 && entry == NULL)
+        {
+            entry = &fontCache[i];
+        }
+    }
+
+    /* all sizes are taken, last entry is replaced */
+    if (entry == NULL)
+    {
+        entry = &fontCache[FONT_CACHE_SIZE - 1];
+        releaseFontCacheEntry(entry);
+    }
+
+	fontDesc.flags = DFDESC_HEIGHT;
+	fontDesc.height = height;
+	DFBCHECK(dfbInterface->CreateFont(dfbInterface, FONT_PATH, &fontDesc, &entry->font));
+    DFBCHECK(entry->font->GetAscender(entry->font, &entry->ascender));
+    entry->height = height;
+
+    for (i = 0; i < GLYPH_CACHE_COUNT; i++)
+    {
+        glyph[0] = GLYPH_CACHE_CHARS[i];
+        prerenderText(entry, glyph, &entry->glyphs[i]);
+    }
+    for (i = 0; i < OSD_LABEL_COUNT; i++)
+    {
+        prerenderText(entry, labelStrings[i], &entry->labels[i]);
+    }
+
+    return entry;
+}
+
+void releaseFontCacheEntry(FontCacheEntry* entry)
+{
+    uint8_t i;
+
+    for (i = 0; i < GLYPH_CACHE_COUNT; i++)
+    {
+        if (entry->glyphs[i].surface != NULL)
+        {
+            entry->glyphs[i].surface->Release(entry->glyphs[i].surface);
+        }
+    }
+    for (i = 0; i < OSD_LABEL_COUNT; i++)
+    {
+        if (entry->labels[i].surface != NULL)
+        {
+            entry->labels[i].surface->Release(entry->labels[i].surface);
+        }
+    }
+    if (entry->font != NULL)
+    {
+        entry->font->Release(entry->font);
+    }
+    memset(entry, 0x0, sizeof(FontCacheEntry));
+}
+
+void releaseFontCache()
+{
+    uint8_t i;
+
+    for (i = 0; i < FONT_CACHE_SIZE; i++)
+    {
+        releaseFontCacheEntry(&fontCache[i]);
+    }
+}
+
+/* Renders white text into new ARGB surface, baseline is at font ascender */
+void prerenderText(FontCacheEntry* entry, const char* text, PrerenderedText* prerendered)
+{
+    DFBSurfaceDescription textDesc;
+    int32_t fontHeight;
+
+    prerendered->surface = NULL;
+    DFBCHECK(entry->font->GetStringWidth(entry->font, text, -1, &prerendered->width));
+    DFBCHECK(entry->font->GetHeight(entry->font, &fontHeight));
+    if (prerendered->width <= 0)
+    {
+        prerendered->width = 0;
+        return;
+    }
+
+    textDesc.flags = DSDESC_CAPS | DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+    textDesc.caps = DSCAPS_NONE;
+    textDesc.width = prerendered->width;
+    textDesc.height = fontHeight;
+    textDesc.pixelformat = DSPF_ARGB;
+    DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &textDesc, &prerendered->surface));
+
+    DFBCHECK(prerendered->surface->Clear(prerendered->surface, 0x00, 0x00, 0x00, 0x00));
+    DFBCHECK(prerendered->surface->SetFont(prerendered->surface, entry->font));
+    DFBCHECK(prerendered->surface->SetColor(prerendered->surface, 0xff, 0xff, 0xff, 0xff));
+    DFBCHECK(prerendered->surface->DrawString(prerendered->surface, text, -1, 0, entry->ascender, DSTF_LEFT));
+}
+
+/* Draws label followed by value in white, y is baseline as in DrawString
+ * Label and cached glyphs are blitted, value with any other character is drawn with cached font
+ */
+void drawText(IDirectFBSurface* surface, FontCacheEntry* entry, OsdLabel label, const char* value, int32_t x, int32_t y, DFBSurfaceTextFlags flags)
+{
+    const char* glyph;
+    uint8_t glyphIndex[50];
+    int32_t width;
+    int32_t valueWidth = 0;
+    bool prerendered = true;
+    uint8_t length = 0;
+
+    /* every character has to be cached, otherwise whole value is drawn with font */
+    for (length = 0; value[length] != '\0' && prerendered; length++)
+    {
+        glyph = strchr(GLYPH_CACHE_CHARS, value[length]);
+        prerendered = glyph != NULL && length < sizeof(glyphIndex);
+        if (prerendered)
+        {
+            glyphIndex[length] = glyph - GLYPH_CACHE_CHARS;
+            valueWidth += entry->glyphs[glyphIndex[length]].width;
+        }
+    }
+    if (!prerendered)
+    {
+        DFBCHECK(entry->font->GetStringWidth(entry->font, value, -1, &valueWidth));
+    }
+
+    width = valueWidth + (label != OSD_LABEL_NONE ? entry->labels[label].width : 0);
+    if (flags & DSTF_CENTER)
+    {
+        x -= width / 2;
+    }
+
+    if (label != OSD_LABEL_NONE && entry->labels[label].surface != NULL)
+    {
+        DFBCHECK(surface->Blit(surface, entry->labels[label].surface, NULL, x, y - entry->ascender));
+        countBytesFilled(entry->labels[label].width, entry->height);
+        x += entry->labels[label].width;
+    }
+
+    if (prerendered)
+    {
+        uint8_t i;
+
+        for (i = 0; i < length; i++)
+        {
+            DFBCHECK(surface->Blit(surface, entry->glyphs[glyphIndex[i]].surface, NULL, x, y - entry->ascender));
+            x += entry->glyphs[glyphIndex[i]].width;
+        }
+    }
+    else
+    {
+        DFBCHECK(surface->SetFont(surface, entry->font));
+        DFBCHECK(surface->SetColor(surface, 0xff, 0xff, 0xff, 0xff));
+        DFBCHECK(surface->DrawString(surface, value, -1, x, y, DSTF_LEFT));
+    }
+    countBytesFilled(valueWidth, entry->height);
+}
+
+/* Shortens text that is wider than maxWidth to the longest fitting prefix followed by an ellipsis */
+void fitText(FontCacheEntry* entry, char* text, uint32_t textSize, int32_t maxWidth)
+{
+    int32_t width;
+    int32_t ellipsisWidth;
+    uint32_t low = 0;
+    uint32_t high = strlen(text);
+    uint32_t middle;
+
+    DFBCHECK(entry->font->GetStringWidth(entry->font, text, -1, &width));
+    if (width <= maxWidth)
+    {
+        return;
+    }
+
+    /* prefix width grows with its length, ellipsis must fit into text */
+    DFBCHECK(entry->font->GetStringWidth(entry->font, "...", -1, &ellipsisWidth));
+    if (high > textSize - 4)
+    {
+        high = textSize - 4;
+    }
+    while (low < high)
+    {
+        middle = (low + high + 1) / 2;
+        DFBCHECK(entry->font->GetStringWidth(entry->font, text, middle, &width));
+        if (width + ellipsisWidth <= maxWidth)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    /* cut falls on first byte of a UTF-8 character */
+    while (low > 0 && (text[low] & 0xC0) == 0x80)
+    {
+        low--;
+    }
+    strcpy(&text[low], "...");
 }
 
+/* Decodes all volume icons into one surface, icons are stacked vertically */
+void loadVolumeAtlas()
+{
+	IDirectFBImageProvider *providers[VOLUME_LEVEL_COUNT];
+	DFBSurfaceDescription iconDesc;
+	DFBSurfaceDescription atlasDesc;
+	char iconPath[20];
+	int32_t atlasWidth = 0;
+	int32_t atlasHeight = 0;
+	uint8_t i;
 
+	for (i = 0; i < VOLUME_LEVEL_COUNT; i++)
+	{
+		sprintf(iconPath, VOLUME_ICON_PATH, i);
+		DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, iconPath, &providers[i]));
+		DFBCHECK(providers[i]->GetSurfaceDescription(providers[i], &iconDesc));
 
+		volumeIcons[i].x = 0;
+		volumeIcons[i].y = atlasHeight;
+		volumeIcons[i].w = iconDesc.width;
+		volumeIcons[i].h = iconDesc.height;
+		atlasHeight += iconDesc.height;
+		if (iconDesc.width > atlasWidth)
+		{
+			atlasWidth = iconDesc.width;
+		}
+		if (iconDesc.height > volumeIconHeight)
+		{
+			volumeIconHeight = iconDesc.height;
+		}
+	}
+
+	atlasDesc.flags = DSDESC_CAPS | DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+	atlasDesc.caps = DSCAPS_NONE;
+	atlasDesc.width = atlasWidth;
+	atlasDesc.height = atlasHeight;
+	atlasDesc.pixelformat = DSPF_ARGB;
+	DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &atlasDesc, &volumeAtlas));
+	volumeIconWidth = atlasWidth;
+	DFBCHECK(volumeAtlas->Clear(volumeAtlas, 0x00, 0x00, 0x00, 0x00));
+
+	/* render each image directly into its place in the atlas */
+	for (i = 0; i < VOLUME_LEVEL_COUNT; i++)
+	{
+		DFBCHECK(providers[i]->RenderTo(providers[i], volumeAtlas, &volumeIcons[i]));
+		providers[i]->Release(providers[i]);
+	}
+}
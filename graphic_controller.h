@@ -10,11 +10,29 @@
 #include <signal.h>
 #include <time.h>
 #include <stdint.h>
+#include <string.h>
 #include "pthread.h"
 #include <stdbool.h>
+#include <errno.h>
+#include "latency_stats.h"
 
 #define FRAME_THICKNESS 5
 #define FONT_HEIGHT_CHANNEL 50
+#define FONT_PATH "/home/galois/fonts/DejaVuSans.ttf"
+#define FONT_CACHE_SIZE 2                   /* Number of font sizes kept open */
+#define GLYPH_CACHE_CHARS "0123456789-:"    /* Characters pre-rendered for every cached font size */
+#define GLYPH_CACHE_COUNT (sizeof(GLYPH_CACHE_CHARS) - 1)
+#define VOLUME_LEVEL_COUNT 11               /* volume_0.png to volume_10.png */
+#define VOLUME_ICON_PATH "volume_%d.png"
+#define OSD_BYTES_PER_PIXEL 4
+#define OSD_CHANNEL_TIMEOUT_MS 3000         /* Time each element stays on screen */
+#define OSD_BANNER_TIMEOUT_MS 3000
+#define OSD_VOLUME_TIMEOUT_MS 3000
+#define OSD_WHEEL_SLOTS 64                  /* Power of 2, wheel spans 6.4 s */
+#define OSD_WHEEL_TICK_MS 100
+#define GC_FRAME_INTERVAL_MS 20             /* Min time between flips, one 50 Hz display frame */
+#define GC_TIME_LEN 6
+#define GC_NAME_LEN 256                     /* Event name including terminating zero, event_name_length is 8 bits */
 
 /* helper macro for error checking */
 #define DFBCHECK(x...)                                      \
@@ -41,16 +59,137 @@ typedef enum _GraphicControllerError
 
 
 /**
- * @brief Structure that defines current screen state
+ * @brief Enumeration of render thread requests
  */
-typedef struct _ScreenState
+typedef enum _RenderRequestType
 {
-	bool drawChannel;
-	bool drawVolumeChange; 
-	bool drawInfo;
-	bool drawBlackScreen;
-	bool refreshScreen;
-}ScreenState;
+    GC_REQ_CHANNEL = 0,
+    GC_REQ_VOLUME,
+    GC_REQ_BANNER,
+    GC_REQ_DEINIT,
+    GC_REQ_COUNT
+}RenderRequestType;
+
+/**
+ * @brief Structure that defines data drawn by render thread
+ */
+typedef struct _RenderData
+{
+    int32_t programNumber;
+    int32_t volumeLevel;
+    int32_t audioPid;
+    int32_t videoPid;
+    bool teletext;
+    char time[GC_TIME_LEN];
+    char name[GC_NAME_LEN];
+}RenderData;
+
+/**
+ * @brief Structure that defines render request queue, repeated requests of one type are coalesced
+ */
+typedef struct _RenderRequestQueue
+{
+    bool pending[GC_REQ_COUNT];             /* Request is posted and not yet drawn */
+    RenderData data;                        /* Latest posted data */
+    bool keyed[GC_REQ_COUNT];               /* Request was posted for a key event */
+    struct timespec keyTimes[GC_REQ_COUNT]; /* First key event since request was taken (CLOCK_MONOTONIC) */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                    /* Signaled on post, waits use CLOCK_MONOTONIC */
+}RenderRequestQueue;
+
+
+/**
+ * @brief Enumeration of OSD elements, each owns a fixed screen region
+ */
+typedef enum _OsdElement
+{
+    OSD_ELEMENT_CHANNEL = 0,
+    OSD_ELEMENT_BANNER,
+    OSD_ELEMENT_VOLUME,
+    OSD_ELEMENT_COUNT
+}OsdElement;
+
+/**
+ * @brief Structure that defines OSD element state in compositor
+ */
+typedef struct _OsdElementState
+{
+    DFBRectangle region;                    /* Screen area element draws into */
+    IDirectFBSurface* layer;                /* Offscreen render of element, size of region */
+    RenderData content;                     /* Data layer was rendered from */
+    bool rendered;                          /* Layer content is valid */
+    bool visible;
+    bool dirty;                             /* Region has to be redrawn in next frame */
+}OsdElementState;
+
+/**
+ * @brief Structure that defines timer wheel of OSD element timeouts
+ *
+ * Element expiring at tick T is in slot T % OSD_WHEEL_SLOTS, a slot holds
+ * a bit mask of elements. Elements armed further than one wheel turn stay
+ * in their slot until their tick is reached.
+ */
+typedef struct _OsdTimerWheel
+{
+    uint8_t slots[OSD_WHEEL_SLOTS];         /* Bit mask of elements expiring in slot */
+    uint32_t expiry[OSD_ELEMENT_COUNT];     /* Expiry tick of armed element */
+    uint32_t currentTick;                   /* Last processed tick */
+    struct timespec start;                  /* Time of tick 0 (CLOCK_MONOTONIC) */
+}OsdTimerWheel;
+
+/**
+ * @brief Structure that defines compositor statistics
+ */
+typedef struct _CompositorStats
+{
+    uint32_t frames;                        /* Number of flips */
+    uint32_t lastFrameBytes;                /* Bytes filled and blitted for last frame, layer renders included */
+    uint64_t bytesFilled;                   /* Bytes filled and blitted for all frames */
+}CompositorStats;
+
+/**
+ * @brief Enumeration of pre-rendered banner strings
+ */
+typedef enum _OsdLabel
+{
+    OSD_LABEL_AUDIO_PID = 0,
+    OSD_LABEL_VIDEO_PID,
+    OSD_LABEL_PROGRAM_NUMBER,
+    OSD_LABEL_TXT,
+    OSD_LABEL_NO_TXT,
+    OSD_LABEL_COUNT,
+    OSD_LABEL_NONE = OSD_LABEL_COUNT        /* Text has no label */
+}OsdLabel;
+
+/**
+ * @brief Structure that defines text rendered once into its own surface
+ */
+typedef struct _PrerenderedText
+{
+    IDirectFBSurface* surface;              /* White text on transparent background, NULL if empty */
+    int32_t width;
+}PrerenderedText;
+
+/**
+ * @brief Structure that defines one cached font size
+ */
+typedef struct _FontCacheEntry
+{
+    int32_t height;                         /* Font height in pixels, 0 if entry is free */
+    int32_t ascender;                       /* Baseline offset inside pre-rendered surfaces */
+    IDirectFBFont* font;
+    PrerenderedText glyphs[GLYPH_CACHE_COUNT];
+    PrerenderedText labels[OSD_LABEL_COUNT];
+}FontCacheEntry;
+/**
+ * @brief Structure that defines OSD render benchmark result
+ */
+typedef struct _OsdBenchResult
+{
+    LatencyHistogram draws[OSD_ELEMENT_COUNT];  /* Render of each element into its layer */
+    LatencyHistogram frame;                 /* Compose and flip of all elements */
+    uint32_t bytesPerFrame;                 /* Bytes filled and blitted per iteration, layer renders included */
+}OsdBenchResult;
 
 
 /**
@@ -69,21 +208,37 @@ GraphicControllerError graphicControllerDeinit();
 /**
  * @brief Draw cnannel number
  *
+ * Key-to-photon latency of keyTime is recorded when the number is on screen.
+ *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return graphic controller error code
  */
-GraphicControllerError drawCnannel(int32_t channelNumber);
+GraphicControllerError drawCnannel(int32_t channelNumber, const struct timespec* keyTime);
 /**
  * @brief Draw volume level symbol
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return graphic controller error code
  */
-GraphicControllerError drawVolumeLevel(int32_t volumeLevel);
+GraphicControllerError drawVolumeLevel(int32_t volumeLevel, const struct timespec* keyTime);
 /**
  * @brief Draw info banner
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
+ * @return graphic controller error code
+ */
+GraphicControllerError drawInfoBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name, const struct timespec* keyTime);
+/**
+ * @brief Renders every OSD element and composes a frame the given number of times
+ *
+ * Runs in the calling thread on its own DirectFB instance, the module must
+ * not be initialized.
+ *
+ * @param [in] iterations - number of frames
+ * @param [out] result - draw and frame times in microseconds
  * @return graphic controller error code
  */
-GraphicControllerError drawInfoBanner(int32_t channelNumber, int32_t audioPid, int32_t videoPid, bool teletext, char* time, char* name);
+GraphicControllerError graphicControllerBenchmark(uint32_t iterations, OsdBenchResult* result);
 
 
 #endif /* __GRAPHIC_CONTROLLER_H__ */
@@ -0,0 +1,262 @@
+#include "latency_stats.h"
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+
+#define ZAP_START_SHIFT     16                  /* Zap state is start time in us << 16 | marked stages */
+
+static const char* zapStageNames[ZAP_STAGE_COUNT] =
+{
+    "zap command",
+    "zap filter set",
+    "zap PMT ready",
+    "zap video created",
+    "zap audio created",
+    "zap OSD drawn",
+    "zap first flip"
+};
+
+static const char* keyLatencyNames[KEY_LATENCY_COUNT] =
+{
+    "key zap to photon",
+    "key volume to photon",
+    "key info to photon"
+};
+
+static LatencyHistogram zapHistograms[ZAP_STAGE_COUNT];
+static LatencyHistogram keyHistograms[KEY_LATENCY_COUNT];
+static uint64_t zapState = 0;                   /* 0 while no zap was started */
+
+static pthread_t dumpThread;
+static bool isInitialized = false;
+static volatile bool threadExit = false;
+
+static void* latencyDumpTask();
+static uint32_t bucketIndex(uint32_t latency);
+static uint32_t bucketUpperBound(uint32_t index);
+static uint64_t monotonicMicroseconds();
+
+void latencyHistogramRecord(LatencyHistogram* histogram, uint32_t latency)
+{
+    uint32_t max;
+
+    __sync_fetch_and_add(&histogram->buckets[bucketIndex(latency)], 1);
+    __sync_fetch_and_add(&histogram->sum, latency);
+    __sync_fetch_and_add(&histogram->count, 1);
+
+    max = histogram->max;
+    while (latency > max && !__sync_bool_compare_and_swap(&histogram->max, max, latency))
+    {
+        max = histogram->max;
+    }
+}
+
+uint32_t latencyHistogramPercentile(const LatencyHistogram* histogram, uint32_t percentile)
+{
+    uint64_t target;
+    uint64_t cumulative = 0;
+    uint32_t i;
+
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    target = ((uint64_t)histogram->count * percentile + 99) / 100;
+    for (i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        cumulative += histogram->buckets[i];
+        if (cumulative >= target)
+        {
+            break;
+        }
+    }
+
+    /* bucket bound can only be larger than the largest sample */
+    return i < LATENCY_BUCKET_COUNT && bucketUpperBound(i) < histogram->max ? bucketUpperBound(i) : histogram->max;
+}
+
+void latencyHistogramPrint(const LatencyHistogram* histogram)
+{
+    printf("%-20s | %6u | %8u | %8u | %8u | %8u | %8u\n",
+           histogram->name, histogram->count,
+           histogram->count ? (uint32_t)(histogram->sum / histogram->count) : 0,
+           latencyHistogramPercentile(histogram, 50),
+           latencyHistogramPercentile(histogram, 90),
+           latencyHistogramPercentile(histogram, 99),
+           histogram->max);
+}
+
+uint32_t latencyElapsed(const struct timespec* start, const struct timespec* end)
+{
+    int64_t elapsed = (int64_t)(end->tv_sec - start->tv_sec) * 1000000 + (end->tv_nsec - start->tv_nsec) / 1000;
+
+    return elapsed > 0 ? (uint32_t)elapsed : 0;
+}
+
+LatencyStatsError latencyStatsInit()
+{
+    sigset_t signalSet;
+    uint8_t i;
+
+    for (i = 0; i < ZAP_STAGE_COUNT; i++)
+    {
+        memset(&zapHistograms[i], 0x0, sizeof(LatencyHistogram));
+        zapHistograms[i].name = zapStageNames[i];
+    }
+    for (i = 0; i < KEY_LATENCY_COUNT; i++)
+    {
+        memset(&keyHistograms[i], 0x0, sizeof(LatencyHistogram));
+        keyHistograms[i].name = keyLatencyNames[i];
+    }
+
+    /* threads created after this point inherit blocked dump signal */
+    sigemptyset(&signalSet);
+    sigaddset(&signalSet, LATENCY_DUMP_SIGNAL);
+    if (pthread_sigmask(SIG_BLOCK, &signalSet, NULL))
+    {
+        printf("\n%s : ERROR pthread_sigmask fail\n", __FUNCTION__);
+        return LATENCY_STATS_ERROR;
+    }
+
+    threadExit = false;
+    if (pthread_create(&dumpThread, NULL, &latencyDumpTask, NULL))
+    {
+        printf("Error creating latency dump task!\n");
+        return LATENCY_STATS_THREAD_ERROR;
+    }
+
+    isInitialized = true;
+
+    return LATENCY_STATS_NO_ERROR;
+}
+
+LatencyStatsError latencyStatsDeinit()
+{
+    if (!isInitialized)
+    {
+        printf("\n%s : ERROR latencyStatsDeinit() fail, module is not initialized!\n", __FUNCTION__);
+        return LATENCY_STATS_ERROR;
+    }
+
+    /* wake up dump task */
+    threadExit = true;
+    pthread_kill(dumpThread, LATENCY_DUMP_SIGNAL);
+    if (pthread_join(dumpThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+        return LATENCY_STATS_THREAD_ERROR;
+    }
+
+    isInitialized = false;
+
+    return LATENCY_STATS_NO_ERROR;
+}
+
+void latencyStatsDump()
+{
+    uint8_t i;
+
+    printf("\n********************* Latency in us *********************\n");
+    printf("%-20s | %6s | %8s | %8s | %8s | %8s | %8s\n", "stage", "count", "mean", "p50", "p90", "p99", "max");
+    for (i = 0; i < ZAP_STAGE_COUNT; i++)
+    {
+        latencyHistogramPrint(&zapHistograms[i]);
+    }
+    for (i = 0; i < KEY_LATENCY_COUNT; i++)
+    {
+        latencyHistogramPrint(&keyHistograms[i]);
+    }
+    printf("**********************************************************\n");
+}
+
+void zapStatsBegin()
+{
+    __atomic_store_n(&zapState, monotonicMicroseconds() << ZAP_START_SHIFT, __ATOMIC_RELEASE);
+}
+
+void zapStatsMark(ZapStage stage)
+{
+    uint64_t state = __atomic_load_n(&zapState, __ATOMIC_ACQUIRE);
+    uint64_t now = monotonicMicroseconds();
+
+    /* stage and start time are claimed together, a mark never mixes two zaps */
+    do
+    {
+        if (state == 0 || (state & (1 << stage)))
+        {
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&zapState, &state, state | (1 << stage), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    latencyHistogramRecord(&zapHistograms[stage], (uint32_t)(now - (state >> ZAP_START_SHIFT)));
+}
+
+void keyLatencyRecord(KeyLatencyType type, const struct timespec* keyTime)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    latencyHistogramRecord(&keyHistograms[type], latencyElapsed(keyTime, &now));
+}
+
+void* latencyDumpTask()
+{
+    sigset_t signalSet;
+    int32_t signalNumber;
+
+    sigemptyset(&signalSet);
+    sigaddset(&signalSet, LATENCY_DUMP_SIGNAL);
+
+    while (!threadExit)
+    {
+        if (sigwait(&signalSet, &signalNumber))
+        {
+            break;
+        }
+        latencyStatsDump();
+    }
+
+    return NULL;
+}
+
+/* Values below LATENCY_SUB_BUCKETS have own bucket, larger are split by
+ * highest set bit and next LATENCY_SUB_BUCKET_BITS bits
+ */
+uint32_t bucketIndex(uint32_t latency)
+{
+    uint32_t exponent;
+
+    if (latency < LATENCY_SUB_BUCKETS)
+    {
+        return latency;
+    }
+
+    exponent = 31 - __builtin_clz(latency);
+
+    return (exponent - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS +
+           ((latency >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+uint32_t bucketUpperBound(uint32_t index)
+{
+    uint32_t shift;
+
+    if (index < LATENCY_SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    shift = index / LATENCY_SUB_BUCKETS - 1;
+
+    return (uint32_t)((((uint64_t)LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS + 1) << shift) - 1);
+}
+
+uint64_t monotonicMicroseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,141 @@
+#ifndef __LATENCY_STATS_H__
+#define __LATENCY_STATS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define LATENCY_SUB_BUCKET_BITS     3                                   /* 8 buckets per power of 2, 12.5% resolution */
+#define LATENCY_SUB_BUCKETS         (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKET_COUNT        ((32 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+#define LATENCY_DUMP_SIGNAL         SIGUSR1                             /* Prints all histograms */
+
+/**
+ * @brief Enumeration of possible latency statistics error codes
+ */
+typedef enum _LatencyStatsError
+{
+    LATENCY_STATS_NO_ERROR = 0,
+    LATENCY_STATS_ERROR,
+    LATENCY_STATS_THREAD_ERROR
+}LatencyStatsError;
+
+/**
+ * @brief Structure that defines latency histogram
+ *
+ * Samples are in microseconds, bucket width grows with the value so that
+ * every bucket covers the same relative range. Recording is lock-free and
+ * can be done from any thread.
+ */
+typedef struct _LatencyHistogram
+{
+    const char* name;
+    uint32_t buckets[LATENCY_BUCKET_COUNT];
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+}LatencyHistogram;
+
+/**
+ * @brief Enumeration of channel zap stages, each stage is measured from the key press
+ */
+typedef enum _ZapStage
+{
+    ZAP_STAGE_COMMAND = 0,              /* Stream controller task took the command */
+    ZAP_STAGE_FILTER_SET,               /* PMT filter set, only for PMT that was not cached */
+    ZAP_STAGE_PMT_READY,                /* PMT of new channel is available */
+    ZAP_STAGE_VIDEO_CREATED,            /* Player_Stream_Create for video returned */
+    ZAP_STAGE_AUDIO_CREATED,            /* Player_Stream_Create for audio returned */
+    ZAP_STAGE_OSD_DRAWN,                /* Channel number is rendered */
+    ZAP_STAGE_FIRST_FLIP,               /* Channel number is flipped to screen */
+    ZAP_STAGE_COUNT
+}ZapStage;
+
+/**
+ * @brief Enumeration of key types measured from key event to the flip that shows the result
+ */
+typedef enum _KeyLatencyType
+{
+    KEY_LATENCY_ZAP = 0,                /* Channel number is flipped to screen */
+    KEY_LATENCY_VOLUME,                 /* Volume icon is flipped to screen */
+    KEY_LATENCY_INFO,                   /* Info banner is flipped to screen */
+    KEY_LATENCY_COUNT
+}KeyLatencyType;
+
+/**
+ * @brief Records one sample
+ *
+ * @param [in] histogram - latency histogram
+ * @param [in] latency - sample in microseconds
+ */
+void latencyHistogramRecord(LatencyHistogram* histogram, uint32_t latency);
+
+/**
+ * @brief Returns upper bound of bucket that holds given percentile
+ *
+ * @param [in] histogram - latency histogram
+ * @param [in] percentile - percentile, 1 to 100
+ * @return latency in microseconds, 0 if histogram is empty
+ */
+uint32_t latencyHistogramPercentile(const LatencyHistogram* histogram, uint32_t percentile);
+
+/**
+ * @brief Prints count, p50, p90, p99 and max of histogram
+ *
+ * @param [in] histogram - latency histogram
+ */
+void latencyHistogramPrint(const LatencyHistogram* histogram);
+
+/**
+ * @brief Returns microseconds from start to end, 0 if end is before start
+ */
+uint32_t latencyElapsed(const struct timespec* start, const struct timespec* end);
+
+/**
+ * @brief Initializes latency statistics module
+ *
+ * Has to be called from main thread before any other thread is created,
+ * LATENCY_DUMP_SIGNAL is blocked and handled by a dedicated thread.
+ *
+ * @return latency statistics error code
+ */
+LatencyStatsError latencyStatsInit();
+
+/**
+ * @brief Deinitializes latency statistics module and prints final report
+ *
+ * @return latency statistics error code
+ */
+LatencyStatsError latencyStatsDeinit();
+
+/**
+ * @brief Prints all latency histograms
+ */
+void latencyStatsDump();
+
+/**
+ * @brief Starts measuring a channel zap, previous zap is abandoned
+ */
+void zapStatsBegin();
+
+/**
+ * @brief Records time from zap start to stage, only first mark of a stage per zap is recorded
+ *
+ * @param [in] stage - zap stage
+ */
+void zapStatsMark(ZapStage stage);
+
+/**
+ * @brief Records key-to-photon latency, time from key event to now
+ *
+ * When several key presses are coalesced into one command or render request,
+ * the earliest key time is passed, the user has been waiting since that key.
+ *
+ * @param [in] type - key type
+ * @param [in] keyTime - kernel timestamp of key event (CLOCK_MONOTONIC)
+ */
+void keyLatencyRecord(KeyLatencyType type, const struct timespec* keyTime);
+
+#endif /* __LATENCY_STATS_H__ */
@@ -1,6 +1,7 @@
 #include "remote_controller.h"
 #include "stream_controller.h"
 #include "graphic_controller.h"
+#include "latency_stats.h"
 
 #define ARG_NUM 2
 
@@ -25,14 +26,11 @@ if (x != 0)                                                                 \
  }                                                                          \
 }
 
-static void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value);
+static void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value, const struct timespec* eventTime);
 static pthread_cond_t deinitCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t deinitMutex = PTHREAD_MUTEX_INITIALIZER;
 
 
-extern ChannelInfo currentChannel;
-extern int16_t volumeLevel;
-
 int main(int argc, char* argv[])
 {
 	/* read config file */
@@ -42,6 +40,9 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
+    /* initialize latency statistics before other threads are created, dump with kill -USR1 */
+    ERRORCHECK(latencyStatsInit());
+
     /* initialize remote controller module */
     ERRORCHECK(remoteControllerInit());
     
@@ -73,50 +74,52 @@ int main(int argc, char* argv[])
 
     /* deinitialize stream controller module */
     ERRORCHECK(streamControllerDeinit());
+
+    /* deinitialize latency statistics module, prints final report */
+    ERRORCHECK(latencyStatsDeinit());
   
     return 0;
 }
 
-void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
+void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value, const struct timespec* eventTime)
 {
+    ChannelInfo channelInfo;
+
 	//printf("Callback with code %d \n", code);
     switch(code)
 	{
 		case KEYCODE_INFO:
             printf("\nInfo pressed\n");  
 		        
-            if (getChannelInfo(&currentChannel) == SC_NO_ERROR)
+            if (getChannelInfo(&channelInfo) == SC_NO_ERROR)
             {
                 printf("\n********************* Channel info *********************\n");
-                printf("Program number: %d\n", currentChannel.programNumber);
-                printf("Audio pid: %d\n", currentChannel.audioPid);
-                printf("Video pid: %d\n", currentChannel.videoPid);
+                printf("Program number: %d\n", channelInfo.programNumber);
+                printf("Audio pid: %d\n", channelInfo.audioPid);
+                printf("Video pid: %d\n", channelInfo.videoPid);
                 printf("**********************************************************\n");
+			    drawInfoBanner(channelInfo.programNumber, channelInfo.audioPid, channelInfo.videoPid, channelInfo.teletext, channelInfo.eventTime, channelInfo.eventName, eventTime);
             }
-			drawInfoBanner(currentChannel.programNumber, currentChannel.audioPid, currentChannel.videoPid, currentChannel.teletext, currentChannel.eventTime, currentChannel.eventName);
 			break;
 		case KEYCODE_P_PLUS:
 			printf("\nCH+ pressed\n");
-            channelUp();
+            channelUp(eventTime);
 			break;
 		case KEYCODE_P_MINUS:
 		    printf("\nCH- pressed\n");
-            channelDown();
+            channelDown(eventTime);
 			break;
 		case KEYCODE_V_PLUS:
 			printf("\nVOL+ pressed\n");
-            volumeUp();
-			drawVolumeLevel(volumeLevel);
+            volumeUp(eventTime);
 			break;
 		case KEYCODE_V_MINUS:
 			printf("\nVOL- pressed\n");
-            volumeDown();
-			drawVolumeLevel(volumeLevel);
+            volumeDown(eventTime);
 			break;
 		case KEYCODE_MUTE:
 			printf("\nMUTE pressed\n");
-			mute();
-			drawVolumeLevel(0);
+			mute(eventTime);
 			break;
 		case KEYCODE_EXIT:
 			printf("\nExit pressed\n");
@@ -130,12 +133,12 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 				if (code != KEYCODE_NUMBER_0)
 				{
 					printf("\nNumber %d pressed\n", code - 1);
-					channelSwitch(code - 1);
+					channelSwitch(code - 1, eventTime);
 				}
 				else
 				{
 					printf("\nNumber 0 pressed\n");
-					channelSwitch(0);
+					channelSwitch(0, eventTime);
 				}
 			}
 			else
@@ -0,0 +1,51 @@
+#include "graphic_controller.h"
+
+/*
+ * OSD render microbenchmark, renders channel number, info banner and volume
+ * icon into their layers and composes a frame, prints time of each step.
+ * Built against the system memory DirectFB stand-in (see dfb_sim/dfb_sim.c),
+ * set DFB_SIM_FONT to a font available on the host.
+ *
+ * usage: osd_bench [iterations]
+ */
+
+#define BENCH_DEFAULT_ITERATIONS    5000
+
+static void printResult(const LatencyHistogram* histogram);
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    OsdBenchResult result;
+    uint8_t i;
+
+    if (iterations == 0)
+    {
+        printf("\nERROR iterations must be positive\n");
+        return 1;
+    }
+
+    if (graphicControllerBenchmark(iterations, &result) != GC_NO_ERROR)
+    {
+        return 1;
+    }
+
+    printf("%u iterations, %u bytes filled per frame\n", iterations, result.bytesPerFrame);
+    printf("step          | mean us | p50 us | p99 us | max us\n");
+    for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+    {
+        printResult(&result.draws[i]);
+    }
+    printResult(&result.frame);
+
+    return 0;
+}
+
+void printResult(const LatencyHistogram* histogram)
+{
+    printf("%-13s | %7.1f | %6u | %6u | %6u\n", histogram->name,
+           histogram->count ? (double)histogram->sum / histogram->count : 0.0,
+           latencyHistogramPercentile(histogram, 50),
+           latencyHistogramPercentile(histogram, 99),
+           histogram->max);
+}
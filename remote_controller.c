@@ -1,19 +1,57 @@
 #include "remote_controller.h"
 
-static int32_t inputFileDesc;
+#define RC_WAKEUP_ID RC_MAX_DEVICES     /* epoll data of wakeup eventfd, devices use their index */
+
+static int32_t inputFileDescs[RC_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+static int32_t epollFileDesc = -1;
+static int32_t wakeupFileDesc = -1;
 static void* inputEventTask();
-static int32_t getKey(uint8_t* buf);
+static void openDevices();
+static void closeDevice(uint8_t index);
+static void closeFileDescs();
+static void readEvents(uint8_t index);
 static pthread_t remote;
 static uint8_t threadExit = 0;
 static RemoteControllerCallback callback = NULL;
 
 RemoteControllerError remoteControllerInit()
 {
+    struct epoll_event event;
+
+    epollFileDesc = epoll_create1(EPOLL_CLOEXEC);
+    wakeupFileDesc = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFileDesc == -1 || wakeupFileDesc == -1)
+    {
+        printf("\n%s : ERROR Cannot create epoll or eventfd (%s)\n", __FUNCTION__, strerror(errno));
+        closeFileDescs();
+        return RC_ERROR;
+    }
+
+    /* write to eventfd wakes the task for deinit */
+    event.events = EPOLLIN;
+    event.data.u32 = RC_WAKEUP_ID;
+    if (epoll_ctl(epollFileDesc, EPOLL_CTL_ADD, wakeupFileDesc, &event))
+    {
+        printf("\n%s : ERROR Cannot add eventfd to epoll (%s)\n", __FUNCTION__, strerror(errno));
+        closeFileDescs();
+        return RC_ERROR;
+    }
+
+    openDevices();
+    if (deviceCount == 0)
+    {
+        printf("\n%s : ERROR No input device could be opened\n", __FUNCTION__);
+        closeFileDescs();
+        return RC_ERROR;
+    }
 
     /* handle input events in background process*/
+    threadExit = 0;
     if (pthread_create(&remote, NULL, &inputEventTask, NULL))
     {
         printf("Error creating input event task!\n");
+        closeFileDescs();
         return RC_THREAD_ERROR;
     }
 
@@ -22,13 +60,22 @@ RemoteControllerError remoteControllerInit()
 
 RemoteControllerError remoteControllerDeinit()
 {
-    /* wait for EXIT key press input event*/
+    uint64_t wakeup = 1;
+
+    /* task is blocked in epoll_wait, wake it up */
     threadExit = 1;
+    if (write(wakeupFileDesc, &wakeup, sizeof(wakeup)) != sizeof(wakeup))
+    {
+        printf("\n%s : ERROR Cannot wake up input event task (%s)\n", __FUNCTION__, strerror(errno));
+    }
     if (pthread_join(remote, NULL))
     {
         printf("Error during thread join!\n");
         return RC_THREAD_ERROR;
     }
+
+    closeFileDescs();
+
     return RC_NO_ERROR;
 }
 
@@ -53,66 +100,161 @@ RemoteControllerError unregisterRemoteControllerCallback(RemoteControllerCallbac
 		printf("Error can't unregister callback!\n");
 		return RC_ERROR;
 	}
-    
+
 	return RC_NO_ERROR;
 }
 
+/* Waits on all devices and wakeup eventfd, one read per ready device takes a whole batch of events */
 void* inputEventTask()
 {
-    char deviceName[20];
-    struct input_event eventBuf;
-    int32_t counter = 0;
-    const char* dev = "/dev/input/event0";
-    
-    inputFileDesc = open(dev, O_RDWR);
-    if(inputFileDesc == -1)
+    struct epoll_event events[RC_MAX_DEVICES + 1];
+    int32_t count;
+    int32_t i;
+
+    while (!threadExit)
     {
-        printf("Error while opening device (%s) !", strerror(errno));
-		return (void*)RC_ERROR;
+        count = epoll_wait(epollFileDesc, events, RC_MAX_DEVICES + 1, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            printf("\n%s : ERROR epoll_wait fail (%s)\n", __FUNCTION__, strerror(errno));
+            return (void*)RC_ERROR;
+        }
+
+        for (i = 0; i < count && !threadExit; i++)
+        {
+            if (events[i].data.u32 == RC_WAKEUP_ID)
+            {
+                continue;
+            }
+            readEvents(events[i].data.u32);
+        }
     }
-    
-    /* get the name of input device */
-    ioctl(inputFileDesc, EVIOCGNAME(sizeof(deviceName)), deviceName);
-	printf("RC device opened succesfully [%s]\n", deviceName);
-        
-    while(!threadExit)
+
+	return (void*)RC_NO_ERROR;
+}
+
+/* Opens every device of RC_DEVICE_PATHS and adds it to epoll, devices that cannot be opened are skipped */
+void openDevices()
+{
+    char paths[] = RC_DEVICE_PATHS;
+    char deviceName[64];
+    char* savePtr;
+    char* dev;
+    struct epoll_event event;
+    int32_t clockId = CLOCK_MONOTONIC;
+    int32_t fileDesc;
+
+    deviceCount = 0;
+    for (dev = strtok_r(paths, ",", &savePtr); dev != NULL && deviceCount < RC_MAX_DEVICES; dev = strtok_r(NULL, ",", &savePtr))
     {
-        
-        /* read next input event */
-        if(getKey((uint8_t*)&eventBuf))
+        fileDesc = open(dev, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fileDesc == -1)
         {
-			printf("Error while reading input events !");
-			return (void*)RC_ERROR;
-		}
+            printf("Error while opening device %s (%s) !\n", dev, strerror(errno));
+            continue;
+        }
 
-		
-		/* filter input events */
-        if(eventBuf.type == EV_KEY && 
-          (eventBuf.value == EV_VALUE_KEYPRESS || eventBuf.value == EV_VALUE_AUTOREPEAT))
+        /* event timestamps are compared with CLOCK_MONOTONIC of other modules */
+        if (ioctl(fileDesc, EVIOCSCLOCKID, &clockId))
         {
-			printf("Event time: %d sec, %d usec\n",(int)eventBuf.time.tv_sec,(int)eventBuf.time.tv_usec);
-			printf("Event type: %hu\n",eventBuf.type);
-			printf("Event code: %hu\n",eventBuf.code);
-			printf("Event value: %d\n",eventBuf.value);
-			printf("\n");
-            /* trigger callback */
-            callback(eventBuf.code, eventBuf.type, eventBuf.value);         
-		}
+            printf("\n%s : ERROR Cannot set monotonic clock of %s, key latency is not valid (%s)\n", __FUNCTION__, dev, strerror(errno));
+        }
+
+        event.events = EPOLLIN;
+        event.data.u32 = deviceCount;
+        if (epoll_ctl(epollFileDesc, EPOLL_CTL_ADD, fileDesc, &event))
+        {
+            printf("\n%s : ERROR Cannot add %s to epoll (%s)\n", __FUNCTION__, dev, strerror(errno));
+            close(fileDesc);
+            continue;
+        }
+        inputFileDescs[deviceCount++] = fileDesc;
+
+        /* get the name of input device */
+        memset(deviceName, 0x0, sizeof(deviceName));
+        ioctl(fileDesc, EVIOCGNAME(sizeof(deviceName) - 1), deviceName);
+        printf("RC device opened succesfully %s [%s]\n", dev, deviceName);
     }
-	return (void*)RC_NO_ERROR;
 }
 
-int32_t getKey(uint8_t* buf)
+void closeDevice(uint8_t index)
 {
-    int32_t ret = 0;
-    
-    /* read next input event and put it in buffer */
-    ret = read(inputFileDesc, buf, (size_t)(sizeof(struct input_event)));
-    if(ret <= 0)
+    if (inputFileDescs[index] != -1)
     {
-        printf("Error code %d", ret);
-        return RC_ERROR;
+        epoll_ctl(epollFileDesc, EPOLL_CTL_DEL, inputFileDescs[index], NULL);
+        close(inputFileDescs[index]);
+        inputFileDescs[index] = -1;
+    }
+}
+
+/* Closes all devices, wakeup eventfd and epoll */
+void closeFileDescs()
+{
+    uint8_t i;
+
+    for (i = 0; i < deviceCount; i++)
+    {
+        closeDevice(i);
+    }
+    deviceCount = 0;
+    if (wakeupFileDesc != -1)
+    {
+        close(wakeupFileDesc);
+        wakeupFileDesc = -1;
+    }
+    if (epollFileDesc != -1)
+    {
+        close(epollFileDesc);
+        epollFileDesc = -1;
+    }
+}
+
+/* Reads up to RC_EVENT_BATCH events of device and dispatches key presses in order
+ * epoll is level triggered, events left in device are reported by next epoll_wait
+ */
+void readEvents(uint8_t index)
+{
+    struct input_event eventBuf[RC_EVENT_BATCH];
+    struct timespec eventTime;
+    ssize_t ret;
+    uint32_t count;
+    uint32_t i;
+
+    ret = read(inputFileDescs[index], eventBuf, sizeof(eventBuf));
+    if (ret <= 0)
+    {
+        if (ret == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            /* device was unplugged */
+            printf("Error while reading input events (%s) !\n", strerror(errno));
+            closeDevice(index);
+        }
+        return;
+    }
+
+    count = ret / sizeof(struct input_event);
+    for (i = 0; i < count; i++)
+    {
+		/* filter input events */
+        if (eventBuf[i].type == EV_KEY &&
+          (eventBuf[i].value == EV_VALUE_KEYPRESS || eventBuf[i].value == EV_VALUE_AUTOREPEAT))
+        {
+			printf("Event time: %d sec, %d usec\n",(int)eventBuf[i].time.tv_sec,(int)eventBuf[i].time.tv_usec);
+			printf("Event type: %hu\n",eventBuf[i].type);
+			printf("Event code: %hu\n",eventBuf[i].code);
+			printf("Event value: %d\n",eventBuf[i].value);
+			printf("\n");
+            /* trigger callback */
+            if (callback != NULL)
+            {
+                eventTime.tv_sec = eventBuf[i].time.tv_sec;
+                eventTime.tv_nsec = eventBuf[i].time.tv_usec * 1000;
+                callback(eventBuf[i].code, eventBuf[i].type, eventBuf[i].value, &eventTime);
+            }
+		}
     }
-    
-    return RC_NO_ERROR;
 }
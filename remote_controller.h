@@ -9,6 +9,11 @@
 #include <stdint.h>
 #include <errno.h>
 #include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #define KEYCODE_EXIT 102
 #define KEYCODE_P_PLUS 62
@@ -20,6 +25,10 @@
 #define KEYCODE_NUMBER_1 2
 #define KEYCODE_NUMBER_0 11
 
+#define RC_DEVICE_PATHS "/dev/input/event0"     /* Comma separated list of evdev devices */
+#define RC_MAX_DEVICES 8
+#define RC_EVENT_BATCH 64                       /* Max events taken by one read */
+
 /* input event values for 'EV_KEY' type */
 #define EV_VALUE_RELEASE    0
 #define EV_VALUE_KEYPRESS   1
@@ -36,12 +45,12 @@ typedef enum _RemoteControllerError
 }RemoteControllerError;
 
 /**
- * @brief Remote controller callback
+ * @brief Remote controller callback, eventTime is kernel timestamp of the event (CLOCK_MONOTONIC)
  */
-typedef void(*RemoteControllerCallback)(uint16_t code, uint16_t type, uint32_t value);
+typedef void(*RemoteControllerCallback)(uint16_t code, uint16_t type, uint32_t value, const struct timespec* eventTime);
 
 /*
- * @brief Initializes remote controller module
+ * @brief Initializes remote controller module, fails if no input device can be opened
  *
  * @return remote cotroller error code
  */
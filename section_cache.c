@@ -0,0 +1,162 @@
+#include "section_cache.h"
+#include "section_view.h"
+#include <stdlib.h>
+#include <string.h>
+
+static SectionCacheEntry* findEntry(SectionCache* cache, uint32_t key, bool insert);
+
+static inline uint32_t sectionKey(const SectionView* view)
+{
+    return ((uint32_t)sectionViewTableId(view) << 24) | ((uint32_t)sectionViewTableIdExtension(view) << 8) | sectionViewSectionNumber(view);
+}
+
+static inline uint8_t sectionVersion(const SectionView* view)
+{
+    return (uint8_t)((sectionViewVersionNumber(view) << 1) | sectionViewCurrentNextIndicator(view));
+}
+
+SectionCacheError sectionCacheInit(SectionCache* cache, uint32_t capacity)
+{
+    uint32_t size = 1;
+    uint8_t shift = 32;
+
+    if (cache == NULL || capacity == 0)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SECTION_CACHE_ERROR;
+    }
+
+    while (size < capacity)
+    {
+        size <<= 1;
+        shift--;
+    }
+
+    memset(cache, 0x0, sizeof(SectionCache));
+    cache->entries = (SectionCacheEntry*)calloc(size, sizeof(SectionCacheEntry));
+    if (cache->entries == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return SECTION_CACHE_ERROR;
+    }
+    cache->capacity = size;
+    cache->hashShift = shift;
+
+    return SECTION_CACHE_NO_ERROR;
+}
+
+SectionCacheError sectionCacheDeinit(SectionCache* cache)
+{
+    if (cache == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return SECTION_CACHE_ERROR;
+    }
+
+    free(cache->entries);
+    memset(cache, 0x0, sizeof(SectionCache));
+
+    return SECTION_CACHE_NO_ERROR;
+}
+
+SectionCacheResult sectionCacheLookup(SectionCache* cache, const uint8_t* sectionBuffer)
+{
+    SectionCacheEntry* entry;
+    SectionView view;
+
+    if (cache == NULL || cache->entries == NULL || !sectionViewInit(&view, sectionBuffer, 0) || !sectionViewSyntaxIndicator(&view))
+    {
+        return SECTION_CACHE_MISS;
+    }
+
+    entry = findEntry(cache, sectionKey(&view), false);
+    if (entry != NULL && entry->version == sectionVersion(&view))
+    {
+        cache->hits++;
+        return SECTION_CACHE_HIT;
+    }
+
+    cache->misses++;
+    return SECTION_CACHE_MISS;
+}
+
+SectionCacheError sectionCacheUpdate(SectionCache* cache, const uint8_t* sectionBuffer)
+{
+    SectionCacheEntry* entry;
+    SectionView view;
+
+    if (cache == NULL || cache->entries == NULL || !sectionViewInit(&view, sectionBuffer, 0))
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SECTION_CACHE_ERROR;
+    }
+
+    if (!sectionViewSyntaxIndicator(&view))
+    {
+        return SECTION_CACHE_NO_ERROR;
+    }
+
+    entry = findEntry(cache, sectionKey(&view), true);
+    if (entry == NULL)
+    {
+        /* cache is full, section will be parsed every time */
+        return SECTION_CACHE_ERROR;
+    }
+    entry->version = sectionVersion(&view);
+
+    return SECTION_CACHE_NO_ERROR;
+}
+
+SectionCacheError sectionCacheInvalidate(SectionCache* cache, uint8_t tableId)
+{
+    uint32_t i;
+
+    if (cache == NULL || cache->entries == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return SECTION_CACHE_ERROR;
+    }
+
+    /* keys stay in place so that probe sequences are not broken */
+    for (i = 0; i < cache->capacity; i++)
+    {
+        if (cache->entries[i].used && (cache->entries[i].key >> 24) == tableId)
+        {
+            cache->entries[i].version = SECTION_CACHE_INVALID_VERSION;
+        }
+    }
+
+    return SECTION_CACHE_NO_ERROR;
+}
+
+/* Linear probing lookup, inserts key into first free entry when insert is set */
+SectionCacheEntry* findEntry(SectionCache* cache, uint32_t key, bool insert)
+{
+    uint32_t mask = cache->capacity - 1;
+    uint32_t index = cache->hashShift < 32 ? (key * 2654435761U) >> cache->hashShift : 0;
+    uint32_t probes;
+    SectionCacheEntry* entry;
+
+    for (probes = 0; probes < cache->capacity; probes++)
+    {
+        entry = &cache->entries[(index + probes) & mask];
+        if (!entry->used)
+        {
+            if (!insert)
+            {
+                return NULL;
+            }
+            entry->used = true;
+            entry->key = key;
+            entry->version = SECTION_CACHE_INVALID_VERSION;
+            cache->count++;
+            return entry;
+        }
+        if (entry->key == key)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,98 @@
+#ifndef __SECTION_CACHE_H__
+#define __SECTION_CACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SECTION_CACHE_DEFAULT_CAPACITY  1024        /* Default number of cached sections, power of 2 */
+#define SECTION_CACHE_INVALID_VERSION   0xFF        /* Version of invalidated entry, never matches */
+
+/**
+ * @brief Enumeration of possible section cache error codes
+ */
+typedef enum _SectionCacheError
+{
+    SECTION_CACHE_NO_ERROR = 0,
+    SECTION_CACHE_ERROR
+}SectionCacheError;
+
+/**
+ * @brief Enumeration of section cache lookup results
+ */
+typedef enum _SectionCacheResult
+{
+    SECTION_CACHE_MISS = 0,                         /* Section is new or changed, it has to be parsed */
+    SECTION_CACHE_HIT                               /* Same version was already parsed */
+}SectionCacheResult;
+
+/**
+ * @brief Structure that defines one cached section
+ */
+typedef struct _SectionCacheEntry
+{
+    uint32_t key;                                   /* table_id, table_id_extension, section_number */
+    uint8_t version;                                /* version_number and current_next_indicator */
+    bool used;                                      /* Entry holds a key */
+}SectionCacheEntry;
+
+/**
+ * @brief Structure that defines section cache
+ */
+typedef struct _SectionCache
+{
+    SectionCacheEntry* entries;                     /* Open addressing table */
+    uint32_t capacity;                              /* Number of entries, power of 2 */
+    uint8_t hashShift;                              /* 32 - log2(capacity) */
+    uint32_t count;                                 /* Number of used entries */
+    uint32_t hits;                                  /* Sections not parsed again */
+    uint32_t misses;                                /* Sections passed to parsers */
+}SectionCache;
+
+/**
+ * @brief Initializes section cache
+ *
+ * @param [out] cache - section cache
+ * @param [in] capacity - number of sections that can be cached, rounded up to power of 2
+ * @return section cache error code
+ */
+SectionCacheError sectionCacheInit(SectionCache* cache, uint32_t capacity);
+
+/**
+ * @brief Deinitializes section cache
+ *
+ * @param [in] cache - section cache
+ * @return section cache error code
+ */
+SectionCacheError sectionCacheDeinit(SectionCache* cache);
+
+/**
+ * @brief Checks whether this version of section was already parsed
+ *
+ * Only the section header is read. Sections without section_syntax_indicator are always a miss.
+ *
+ * @param [in] cache - section cache
+ * @param [in] sectionBuffer - section starting with table_id
+ * @return section cache lookup result
+ */
+SectionCacheResult sectionCacheLookup(SectionCache* cache, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Stores version of section after it was parsed successfully
+ *
+ * @param [in] cache - section cache
+ * @param [in] sectionBuffer - section starting with table_id
+ * @return section cache error code
+ */
+SectionCacheError sectionCacheUpdate(SectionCache* cache, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Forgets versions of all sections of a table, next section of the table is a miss
+ *
+ * @param [in] cache - section cache
+ * @param [in] tableId - table id
+ * @return section cache error code
+ */
+SectionCacheError sectionCacheInvalidate(SectionCache* cache, uint8_t tableId);
+
+#endif /* __SECTION_CACHE_H__ */
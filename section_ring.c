@@ -0,0 +1,145 @@
+#include "section_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool ringEmpty(SectionRing* ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == ring->tail;
+}
+
+SectionRingError sectionRingInit(SectionRing* ring, uint32_t slotCount)
+{
+    uint32_t size = 1;
+
+    if (ring == NULL || slotCount > SECTION_RING_MAX_SLOTS)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SECTION_RING_ERROR;
+    }
+
+    if (slotCount == 0)
+    {
+        slotCount = SECTION_RING_DEFAULT_SLOTS;
+    }
+    while (size < slotCount)
+    {
+        size <<= 1;
+    }
+
+    memset(ring, 0x0, sizeof(SectionRing));
+    ring->slots = (uint8_t*)malloc((size_t)size * SECTION_RING_SLOT_SIZE);
+    if (ring->slots == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return SECTION_RING_ERROR;
+    }
+    ring->slotCount = size;
+    ring->mask = size - 1;
+
+    if (sem_init(&ring->wakeup, 0, 0))
+    {
+        printf("\n%s : ERROR sem_init fail\n", __FUNCTION__);
+        free(ring->slots);
+        ring->slots = NULL;
+        return SECTION_RING_ERROR;
+    }
+
+    return SECTION_RING_NO_ERROR;
+}
+
+SectionRingError sectionRingDeinit(SectionRing* ring)
+{
+    if (ring == NULL || ring->slots == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return SECTION_RING_ERROR;
+    }
+
+    sem_destroy(&ring->wakeup);
+    free(ring->slots);
+    ring->slots = NULL;
+
+    return SECTION_RING_NO_ERROR;
+}
+
+bool sectionRingPush(SectionRing* ring, const uint8_t* sectionBuffer)
+{
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t length = 3 + (((sectionBuffer[1] & 0x0F) << 8) | sectionBuffer[2]);
+
+    if (length > SECTION_RING_SLOT_SIZE)
+    {
+        ring->oversized++;
+        return false;
+    }
+
+    if (head - tail == ring->slotCount)
+    {
+        ring->overflows++;
+        return false;
+    }
+
+    memcpy(ring->slots + (size_t)(head & ring->mask) * SECTION_RING_SLOT_SIZE, sectionBuffer, length);
+    ring->pushed++;
+    if (head - tail + 1 > ring->highWater)
+    {
+        ring->highWater = head - tail + 1;
+    }
+
+    /* slot content is visible before new head */
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+
+    /* system call only when consumer sleeps */
+    if (__atomic_exchange_n(&ring->consumerSleeping, 0, __ATOMIC_SEQ_CST))
+    {
+        sem_post(&ring->wakeup);
+    }
+
+    return true;
+}
+
+const uint8_t* sectionRingPeek(SectionRing* ring)
+{
+    uint32_t tail = ring->tail;
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return NULL;
+    }
+
+    return ring->slots + (size_t)(tail & ring->mask) * SECTION_RING_SLOT_SIZE;
+}
+
+void sectionRingRelease(SectionRing* ring)
+{
+    /* slot is not read after it is handed back */
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+void sectionRingWait(SectionRing* ring)
+{
+    /* announce sleep, then check again so that a push in between is not missed */
+    __atomic_store_n(&ring->consumerSleeping, 1, __ATOMIC_SEQ_CST);
+    if (ringEmpty(ring))
+    {
+        sem_wait(&ring->wakeup);
+    }
+    __atomic_store_n(&ring->consumerSleeping, 0, __ATOMIC_SEQ_CST);
+
+    ring->batches++;
+}
+
+void sectionRingWake(SectionRing* ring)
+{
+    sem_post(&ring->wakeup);
+}
+
+void sectionRingGetStats(SectionRing* ring, SectionRingStats* stats)
+{
+    stats->pushed = __atomic_load_n(&ring->pushed, __ATOMIC_RELAXED);
+    stats->overflows = __atomic_load_n(&ring->overflows, __ATOMIC_RELAXED);
+    stats->oversized = __atomic_load_n(&ring->oversized, __ATOMIC_RELAXED);
+    stats->highWater = __atomic_load_n(&ring->highWater, __ATOMIC_RELAXED);
+    stats->batches = __atomic_load_n(&ring->batches, __ATOMIC_RELAXED);
+}
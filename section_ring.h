@@ -0,0 +1,131 @@
+#ifndef __SECTION_RING_H__
+#define __SECTION_RING_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <semaphore.h>
+
+#define SECTION_RING_SLOT_SIZE          4096        /* Max private section size */
+#define SECTION_RING_DEFAULT_SLOTS      64          /* Used when config does not set ring size */
+#define SECTION_RING_MAX_SLOTS          1024
+#define SECTION_RING_CACHE_LINE         64
+
+/*
+ * Single producer, single consumer ring of preallocated section slots.
+ *
+ * Demux callback is the only producer, one section worker is the only consumer.
+ * Push copies the section into the next free slot and never blocks, when
+ * the ring is full the section is dropped and counted. Consumer takes
+ * sections in place and releases each slot after it is parsed.
+ */
+
+/**
+ * @brief Enumeration of possible section ring error codes
+ */
+typedef enum _SectionRingError
+{
+    SECTION_RING_NO_ERROR = 0,
+    SECTION_RING_ERROR
+}SectionRingError;
+
+/**
+ * @brief Structure that defines section ring statistics
+ */
+typedef struct _SectionRingStats
+{
+    uint32_t pushed;                                /* Sections stored by producer */
+    uint32_t overflows;                             /* Sections dropped because ring was full */
+    uint32_t oversized;                             /* Sections dropped because they do not fit into slot */
+    uint32_t highWater;                             /* Max number of queued sections */
+    uint32_t batches;                               /* Number of consumer wakeups */
+}SectionRingStats;
+
+/**
+ * @brief Structure that defines section ring
+ */
+typedef struct _SectionRing
+{
+    /* producer side */
+    uint32_t head __attribute__((aligned(SECTION_RING_CACHE_LINE)));    /* Next slot to write */
+    uint32_t pushed;
+    uint32_t overflows;
+    uint32_t oversized;
+    uint32_t highWater;
+
+    /* consumer side */
+    uint32_t tail __attribute__((aligned(SECTION_RING_CACHE_LINE)));    /* Next slot to read */
+    uint32_t batches;
+    uint32_t consumerSleeping;                      /* Consumer is about to wait, producer has to post */
+
+    /* read only after init */
+    uint8_t* slots __attribute__((aligned(SECTION_RING_CACHE_LINE)));
+    uint32_t slotCount;                             /* Power of 2 */
+    uint32_t mask;
+    sem_t wakeup;
+}SectionRing;
+
+/**
+ * @brief Initializes section ring, all slots are allocated upfront
+ *
+ * @param [out] ring - section ring
+ * @param [in] slotCount - number of slots, rounded up to power of 2, 0 for default
+ * @return section ring error code
+ */
+SectionRingError sectionRingInit(SectionRing* ring, uint32_t slotCount);
+
+/**
+ * @brief Deinitializes section ring, producer and consumer have to be stopped
+ *
+ * @param [in] ring - section ring
+ * @return section ring error code
+ */
+SectionRingError sectionRingDeinit(SectionRing* ring);
+
+/**
+ * @brief Copies section into ring and wakes consumer, called by producer only
+ *
+ * @param [in] ring - section ring
+ * @param [in] sectionBuffer - section starting with table_id
+ * @return true if section was queued, false if it was dropped
+ */
+bool sectionRingPush(SectionRing* ring, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Returns oldest queued section without removing it, called by consumer only
+ *
+ * @param [in] ring - section ring
+ * @return section starting with table_id, NULL if ring is empty
+ */
+const uint8_t* sectionRingPeek(SectionRing* ring);
+
+/**
+ * @brief Returns slot of section returned by sectionRingPeek to producer
+ *
+ * @param [in] ring - section ring
+ */
+void sectionRingRelease(SectionRing* ring);
+
+/**
+ * @brief Blocks consumer until ring is not empty or sectionRingWake is called
+ *
+ * @param [in] ring - section ring
+ */
+void sectionRingWait(SectionRing* ring);
+
+/**
+ * @brief Wakes consumer blocked in sectionRingWait, used on shutdown
+ *
+ * @param [in] ring - section ring
+ */
+void sectionRingWake(SectionRing* ring);
+
+/**
+ * @brief Returns section ring statistics
+ *
+ * @param [in] ring - section ring
+ * @param [out] stats - section ring statistics
+ */
+void sectionRingGetStats(SectionRing* ring, SectionRingStats* stats);
+
+#endif /* __SECTION_RING_H__ */
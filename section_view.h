@@ -0,0 +1,451 @@
+#ifndef __SECTION_VIEW_H__
+#define __SECTION_VIEW_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Zero-copy accessors for PSI/SI sections.
+ *
+ * Fields are read directly from the section buffer delivered by the demux,
+ * nothing is copied and only the fields that are asked for are decoded.
+ * sectionViewInit checks that the buffer holds the whole section, iterators
+ * never step outside of the loop they walk.
+ */
+
+#define SECTION_VIEW_HEADER_LEN         3       /* table_id and section_length */
+#define SECTION_VIEW_LONG_HEADER_LEN    8       /* Header of section with section_syntax_indicator */
+#define SECTION_VIEW_CRC_LEN            4       /* CRC_32 */
+#define SECTION_VIEW_MAX_LEN            4096    /* Max private section size */
+
+/**
+ * @brief Structure that defines view of one section
+ */
+typedef struct _SectionView
+{
+    const uint8_t* buffer;                      /* Section starting with table_id */
+    uint16_t length;                            /* Section size including header and CRC_32 */
+}SectionView;
+
+/**
+ * @brief Structure that defines iterator over a loop inside a section
+ */
+typedef struct _SectionLoopIterator
+{
+    const uint8_t* position;                    /* Next loop entry */
+    const uint8_t* end;                         /* First byte after the loop */
+}SectionLoopIterator;
+
+/**
+ * @brief Structure that defines view of PAT program
+ */
+typedef struct _PatProgramView
+{
+    uint16_t programNumber;
+    uint16_t pid;                               /* PMT pid, or NIT pid for program 0 */
+}PatProgramView;
+
+/**
+ * @brief Structure that defines view of PMT elementary stream
+ */
+typedef struct _PmtEsView
+{
+    uint8_t streamType;
+    uint16_t elementaryPid;
+    const uint8_t* descriptors;                 /* ES descriptor loop */
+    uint16_t descriptorsLength;
+}PmtEsView;
+
+/**
+ * @brief Structure that defines view of EIT event
+ */
+typedef struct _EitEventView
+{
+    uint16_t eventId;
+    const uint8_t* startTime;                   /* 16 bit MJD followed by 6 BCD digits UTC */
+    uint32_t duration;                          /* 6 BCD digits */
+    uint8_t runningStatus;
+    bool freeCaMode;
+    const uint8_t* descriptors;                 /* Event descriptor loop */
+    uint16_t descriptorsLength;
+}EitEventView;
+
+/**
+ * @brief Structure that defines view of descriptor
+ */
+typedef struct _DescriptorView
+{
+    uint8_t tag;
+    uint8_t length;
+    const uint8_t* data;                        /* Descriptor payload after tag and length */
+}DescriptorView;
+
+static inline uint16_t readBe16(const uint8_t* buffer)
+{
+    return (uint16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static inline uint32_t readBe24(const uint8_t* buffer)
+{
+    return ((uint32_t)buffer[0] << 16) | ((uint32_t)buffer[1] << 8) | buffer[2];
+}
+
+static inline uint32_t readBe32(const uint8_t* buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+}
+
+/* Returns bitCount bits that end shift bits above the lowest bit of 16 bit big-endian word */
+static inline uint16_t readBits16(const uint8_t* buffer, uint8_t shift, uint8_t bitCount)
+{
+    return (uint16_t)((readBe16(buffer) >> shift) & ((1U << bitCount) - 1));
+}
+
+/**
+ * @brief Initializes view of section
+ *
+ * @param [out] view - section view
+ * @param [in] buffer - section starting with table_id
+ * @param [in] bufferLength - number of valid bytes in buffer, 0 if only section_length is known
+ * @return true if buffer holds a complete section
+ */
+static inline bool sectionViewInit(SectionView* view, const uint8_t* buffer, uint16_t bufferLength)
+{
+    uint16_t length;
+
+    if (view == NULL || buffer == NULL || (bufferLength != 0 && bufferLength < SECTION_VIEW_HEADER_LEN))
+    {
+        return false;
+    }
+
+    length = SECTION_VIEW_HEADER_LEN + readBits16(buffer + 1, 0, 12);
+    if (length > SECTION_VIEW_MAX_LEN || (bufferLength != 0 && length > bufferLength))
+    {
+        return false;
+    }
+
+    /* long form section has to hold its header and CRC_32 */
+    if ((buffer[1] & 0x80) && length < SECTION_VIEW_LONG_HEADER_LEN + SECTION_VIEW_CRC_LEN)
+    {
+        return false;
+    }
+
+    view->buffer = buffer;
+    view->length = length;
+
+    return true;
+}
+
+static inline uint8_t sectionViewTableId(const SectionView* view)
+{
+    return view->buffer[0];
+}
+
+static inline bool sectionViewSyntaxIndicator(const SectionView* view)
+{
+    return (view->buffer[1] & 0x80) != 0;
+}
+
+static inline uint16_t sectionViewSectionLength(const SectionView* view)
+{
+    return view->length - SECTION_VIEW_HEADER_LEN;
+}
+
+/* Fields below are valid only for sections with section_syntax_indicator set */
+
+/* transport_stream_id for PAT, program_number for PMT, service_id for EIT */
+static inline uint16_t sectionViewTableIdExtension(const SectionView* view)
+{
+    return readBe16(view->buffer + 3);
+}
+
+static inline uint8_t sectionViewVersionNumber(const SectionView* view)
+{
+    return (view->buffer[5] >> 1) & 0x1F;
+}
+
+static inline bool sectionViewCurrentNextIndicator(const SectionView* view)
+{
+    return (view->buffer[5] & 0x01) != 0;
+}
+
+static inline uint8_t sectionViewSectionNumber(const SectionView* view)
+{
+    return view->buffer[6];
+}
+
+static inline uint8_t sectionViewLastSectionNumber(const SectionView* view)
+{
+    return view->buffer[7];
+}
+
+static inline uint32_t sectionViewCrc(const SectionView* view)
+{
+    return readBe32(view->buffer + view->length - SECTION_VIEW_CRC_LEN);
+}
+
+/* Initializes iterator over loop [start, end), empty if loop does not fit into section */
+static inline bool sectionLoopInit(const SectionView* view, SectionLoopIterator* iterator, uint16_t start, uint16_t end)
+{
+    if (start > end || end > view->length)
+    {
+        iterator->position = iterator->end = view->buffer;
+        return false;
+    }
+
+    iterator->position = view->buffer + start;
+    iterator->end = view->buffer + end;
+
+    return true;
+}
+
+/**
+ * @brief Initializes iterator over PAT programs
+ *
+ * @param [in] view - PAT section view
+ * @param [out] iterator - program iterator
+ * @return true if view is PAT
+ */
+static inline bool patProgramIteratorInit(const SectionView* view, SectionLoopIterator* iterator)
+{
+    if (sectionViewTableId(view) != 0x00 || !sectionViewSyntaxIndicator(view))
+    {
+        return false;
+    }
+
+    return sectionLoopInit(view, iterator, SECTION_VIEW_LONG_HEADER_LEN, view->length - SECTION_VIEW_CRC_LEN);
+}
+
+static inline bool patProgramIteratorNext(SectionLoopIterator* iterator, PatProgramView* program)
+{
+    if (iterator->end - iterator->position < 4)
+    {
+        return false;
+    }
+
+    program->programNumber = readBe16(iterator->position);
+    program->pid = readBits16(iterator->position + 2, 0, 13);
+    iterator->position += 4;
+
+    return true;
+}
+
+static inline uint16_t pmtViewPcrPid(const SectionView* view)
+{
+    return readBits16(view->buffer + 8, 0, 13);
+}
+
+static inline uint16_t pmtViewProgramInfoLength(const SectionView* view)
+{
+    return readBits16(view->buffer + 10, 0, 12);
+}
+
+/**
+ * @brief Initializes iterator over PMT program info descriptors
+ *
+ * @param [in] view - PMT section view
+ * @param [out] iterator - descriptor iterator
+ * @return true if view is PMT with consistent program_info_length
+ */
+static inline bool pmtProgramInfoIteratorInit(const SectionView* view, SectionLoopIterator* iterator)
+{
+    if (sectionViewTableId(view) != 0x02 || view->length < 12 + SECTION_VIEW_CRC_LEN)
+    {
+        return false;
+    }
+
+    return sectionLoopInit(view, iterator, 12, 12 + pmtViewProgramInfoLength(view));
+}
+
+/**
+ * @brief Initializes iterator over PMT elementary streams
+ *
+ * @param [in] view - PMT section view
+ * @param [out] iterator - elementary stream iterator
+ * @return true if view is PMT with consistent program_info_length
+ */
+static inline bool pmtEsIteratorInit(const SectionView* view, SectionLoopIterator* iterator)
+{
+    if (sectionViewTableId(view) != 0x02 || view->length < 12 + SECTION_VIEW_CRC_LEN)
+    {
+        return false;
+    }
+
+    return sectionLoopInit(view, iterator, 12 + pmtViewProgramInfoLength(view), view->length - SECTION_VIEW_CRC_LEN);
+}
+
+static inline bool pmtEsIteratorNext(SectionLoopIterator* iterator, PmtEsView* es)
+{
+    uint16_t esInfoLength;
+
+    if (iterator->end - iterator->position < 5)
+    {
+        return false;
+    }
+
+    esInfoLength = readBits16(iterator->position + 3, 0, 12);
+    if (iterator->end - iterator->position < 5 + esInfoLength)
+    {
+        iterator->position = iterator->end;
+        return false;
+    }
+
+    es->streamType = iterator->position[0];
+    es->elementaryPid = readBits16(iterator->position + 1, 0, 13);
+    es->descriptors = iterator->position + 5;
+    es->descriptorsLength = esInfoLength;
+    iterator->position += 5 + esInfoLength;
+
+    return true;
+}
+
+static inline uint16_t eitViewTransportStreamId(const SectionView* view)
+{
+    return readBe16(view->buffer + 8);
+}
+
+static inline uint16_t eitViewOriginalNetworkId(const SectionView* view)
+{
+    return readBe16(view->buffer + 10);
+}
+
+static inline uint8_t eitViewSegmentLastSectionNumber(const SectionView* view)
+{
+    return view->buffer[12];
+}
+
+static inline uint8_t eitViewLastTableId(const SectionView* view)
+{
+    return view->buffer[13];
+}
+
+static inline uint8_t bcdToBinary(uint8_t bcd)
+{
+    return (uint8_t)((bcd >> 4) * 10 + (bcd & 0x0F));
+}
+
+/* Converts EIT start_time (16 bit MJD, 6 BCD digits UTC) to seconds since 1970-01-01 UTC */
+static inline uint32_t eitStartTimeToUnix(const uint8_t* startTime)
+{
+    /* MJD 40587 is 1970-01-01 */
+    return (uint32_t)(readBe16(startTime) - 40587) * 86400 +
+           bcdToBinary(startTime[2]) * 3600 + bcdToBinary(startTime[3]) * 60 + bcdToBinary(startTime[4]);
+}
+
+/* Converts EIT duration (6 BCD digits hhmmss) to seconds */
+static inline uint32_t eitDurationToSeconds(uint32_t duration)
+{
+    return bcdToBinary((uint8_t)(duration >> 16)) * 3600 + bcdToBinary((uint8_t)(duration >> 8)) * 60 + bcdToBinary((uint8_t)duration);
+}
+
+/**
+ * @brief Initializes iterator over EIT events
+ *
+ * @param [in] view - EIT section view, p/f or schedule
+ * @param [out] iterator - event iterator
+ * @return true if view is EIT
+ */
+static inline bool eitEventIteratorInit(const SectionView* view, SectionLoopIterator* iterator)
+{
+    if (sectionViewTableId(view) < 0x4E || sectionViewTableId(view) > 0x6F || view->length < 14 + SECTION_VIEW_CRC_LEN)
+    {
+        return false;
+    }
+
+    return sectionLoopInit(view, iterator, 14, view->length - SECTION_VIEW_CRC_LEN);
+}
+
+static inline bool eitEventIteratorNext(SectionLoopIterator* iterator, EitEventView* event)
+{
+    uint16_t descriptorsLength;
+
+    if (iterator->end - iterator->position < 12)
+    {
+        return false;
+    }
+
+    descriptorsLength = readBits16(iterator->position + 10, 0, 12);
+    if (iterator->end - iterator->position < 12 + descriptorsLength)
+    {
+        iterator->position = iterator->end;
+        return false;
+    }
+
+    event->eventId = readBe16(iterator->position);
+    event->startTime = iterator->position + 2;
+    event->duration = readBe24(iterator->position + 7);
+    event->runningStatus = (uint8_t)readBits16(iterator->position + 10, 13, 3);
+    event->freeCaMode = readBits16(iterator->position + 10, 12, 1) != 0;
+    event->descriptors = iterator->position + 12;
+    event->descriptorsLength = descriptorsLength;
+    iterator->position += 12 + descriptorsLength;
+
+    return true;
+}
+
+/**
+ * @brief Initializes iterator over descriptor loop
+ *
+ * @param [out] iterator - descriptor iterator
+ * @param [in] descriptors - first descriptor
+ * @param [in] length - descriptor loop length
+ */
+static inline void descriptorIteratorInit(SectionLoopIterator* iterator, const uint8_t* descriptors, uint16_t length)
+{
+    iterator->position = descriptors;
+    iterator->end = descriptors + length;
+}
+
+static inline bool descriptorIteratorNext(SectionLoopIterator* iterator, DescriptorView* descriptor)
+{
+    if (iterator->end - iterator->position < 2 || iterator->end - iterator->position < 2 + iterator->position[1])
+    {
+        iterator->position = iterator->end;
+        return false;
+    }
+
+    descriptor->tag = iterator->position[0];
+    descriptor->length = iterator->position[1];
+    descriptor->data = iterator->position + 2;
+    iterator->position += 2 + descriptor->length;
+
+    return true;
+}
+
+/**
+ * @brief Appends DVB text to zero terminated string
+ *
+ * Character table selection bytes are skipped, text is cut to fit.
+ *
+ * @param [in,out] dest - zero terminated string
+ * @param [in] destLength - length of string in dest
+ * @param [in] destSize - size of dest buffer
+ * @param [in] text - DVB text
+ * @param [in] length - DVB text length
+ * @return new length of string in dest
+ */
+static inline uint16_t dvbTextAppend(char* dest, uint16_t destLength, uint16_t destSize, const uint8_t* text, uint8_t length)
+{
+    uint8_t skip = 0;
+
+    /* 0x10 selects ISO/IEC 8859 part in the next two bytes, 0x1F is followed by encoding_type_id */
+    if (length > 0 && text[0] < 0x20)
+    {
+        skip = text[0] == 0x10 ? 3 : (text[0] == 0x1F ? 2 : 1);
+        skip = skip < length ? skip : length;
+    }
+    text += skip;
+    length -= skip;
+    if (length > destSize - 1 - destLength)
+    {
+        length = destSize - 1 - destLength;
+    }
+    memcpy(dest + destLength, text, length);
+    dest[destLength + length] = '\0';
+
+    return destLength + length;
+}
+
+#endif /* __SECTION_VIEW_H__ */
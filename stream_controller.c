@@ -2,11 +2,19 @@
 #include "tables.h"
 #include "config_parser.h"
 #include "graphic_controller.h"
+#include "crc32.h"
+#include "section_cache.h"
+#include "latency_stats.h"
+#include "channel_db.h"
+#include "section_ring.h"
+#include "table_snapshot.h"
 #include <string.h>
 
-static PatTable *patTable;
-static PmtTable *pmtTable;
-static EitTable *eitTable;
+static TableSnapshot patSnapshot;                           /* PatTable */
+static TableSnapshot pmtSnapshot;                           /* PmtCache, PMT of every service in PAT */
+static TableSnapshot eitSnapshot;                           /* EitPfCache, present/following of every service */
+static uint16_t currentServiceId = 0;                       /* program_number of current channel */
+static bool pmtSeen[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT];      /* PMT of service arrived in current round, owned by stream controller task */
 static pthread_cond_t statusCondition = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t statusMutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -18,18 +26,15 @@ static uint32_t sourceHandle = 0;
 static uint32_t streamHandleA = 0;
 static uint32_t streamHandleV = 0;
 static uint32_t filterHandle = 0;
-static uint8_t threadExit = 0;
-static bool changeChannel = false;
-static bool changeVolume = false;
-static bool volumeMute = false;
-static int16_t programNumber = 0;
+static int16_t programNumber = 0;                           /* Owned by stream controller task */
+static int16_t playerVolumeLevel = 0;                       /* Volume set to player, owned by stream controller task */
+static bool playerMute = false;
 static bool isInitialized = false;
 static InitConfig config; 
 static char configPathname[CONFIG_NAME_LEN];
-
-
-ChannelInfo currentChannel;
-int16_t volumeLevel = 0;
+static char channelDbPathname[CONFIG_NAME_LEN + sizeof(CHANNEL_DB_FILE_NAME)];
+static ChannelInfo currentChannel;                          /* Written by stream controller task only */
+static pthread_mutex_t channelInfoMutex = PTHREAD_MUTEX_INITIALIZER;   /* Guards currentChannel against readers of other threads */
 
 static struct timespec lockStatusWaitTime;
 static struct timeval now;
@@ -37,22 +42,91 @@ static pthread_t scThread;
 static pthread_cond_t demuxCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t demuxMutex = PTHREAD_MUTEX_INITIALIZER;
 
+static StreamCommandQueue commandQueue;
+static uint32_t commandLatencyLast[SC_CMD_COUNT];
+static uint32_t commandLatencyMax[SC_CMD_COUNT];
+static PsiStats psiStats;
+static SectionCache sectionCache;
+
+static PsiAcquisitionState psiState = PSI_STATE_PAT;
+static uint8_t psiIndex = 0;                                /* Service whose PMT is filtered */
+static struct timespec psiDeadline;                         /* Next acquisition step */
+static bool channelDbDirty = false;                         /* Channel database differs from tables, owned by stream controller task */
+
+static EpgSchedule epgSchedule;                             /* EIT schedule of all services */
+static uint32_t eitFilterHandles[EPG_TABLE_LAST - EIT_FILTER_FIRST_TABLE + 1];
+static uint32_t eitFilteredTables = 0;                      /* Bit (table_id - 0x4E) of set EIT filters */
+static bool eitSharedFilter = false;                        /* Demux has no filter left for EIT, EIT shares PSI filter */
+static uint8_t eitSharedTableId = EIT_FILTER_FIRST_TABLE;   /* Table on shared filter, 0x00 while PAT is watched */
+static uint8_t eitSharedNext = 1;                           /* Bit of table visited after next p/f actual */
+static struct timespec psiRefreshTime;                      /* Next PMT refresh round */
+
+static SectionRing sectionRing;                             /* Sections from demux callback to PSI worker */
+static SectionRing scheduleRing;                            /* EIT schedule sections from demux callback to EPG worker */
+static pthread_t psiThread;
+static pthread_t epgThread;
+static volatile bool psiWorkerExit = false;
+
 
 static void* streamControllerTask();
-static StreamControllerError startChannel(int32_t channelNumber);
-static void getEvent();
+static void* sectionWorkerTask(void* ring);
+static void stopSectionWorkers();
+static void releaseTaskResources();
+static int32_t parseSection(const uint8_t* buffer);
+static bool sectionCrcValid(const uint8_t* buffer);
+static void parsePfSection(const uint8_t* buffer);
+static int16_t findPfService(const EitPfCache* cache, const SectionView* view);
+static void parseScheduleSection(const uint8_t* buffer);
+static void postCommand(StreamCommandType type, int32_t value, bool relative, const struct timespec* keyTime);
+static void postPsiCommand(uint32_t flags);
+static bool waitCommands(StreamCommand* commands, const struct timespec* deadline);
+static uint32_t commandLatency(StreamCommandType type, const StreamCommand* command);
+static StreamControllerError startChannel(int32_t channelNumber, const struct timespec* keyTime);
+static int16_t channelTarget(const StreamCommand* command);
+static void setPlayerVolume(const StreamCommand* commands);
+static void getEvent(uint16_t serviceId);
+static StreamControllerError setPsiFilter(uint16_t pid, uint8_t tableId);
+static void setEitFilters();
+static void freeEitFilters();
+static void eitSharedFilterStep();
+static void psiAcquisitionStart();
+static void psiAcquisitionStep();
+static int8_t findServiceIndex(uint16_t serviceId);
+static void setDeadline(struct timespec* deadline, uint32_t milliseconds);
+static bool deadlinePassed(const struct timespec* deadline);
+static void setChannelDbPathname();
+static bool loadChannelDb();
+static void saveChannelDb();
+static bool patServicesEqual(const PatTable* first, const PatTable* second);
+static bool pmtStreamsEqual(const PmtTable* first, const PmtTable* second);
+static StreamControllerError initTables();
+static void freeTables();
+static uint8_t getServiceCount();
+static bool copyServicePmt(uint8_t serviceIndex, PmtTable* pmtTable);
 
 
 StreamControllerError streamControllerInit(char* configFile)
 {
+    pthread_condattr_t condAttr;
+
+    /* initialize command queue, waits are measured on monotonic clock */
+    memset(commandQueue.commands, 0x0, sizeof(commandQueue.commands));
+    pthread_mutex_init(&commandQueue.mutex, NULL);
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&commandQueue.cond, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+
+    /* config path has to be set before task starts */
+	strncpy(configPathname, configFile, CONFIG_NAME_LEN - 1);
+    setChannelDbPathname();
+
     if (pthread_create(&scThread, NULL, &streamControllerTask, NULL))
     {
         printf("Error creating input event task!\n");
         return SC_THREAD_ERROR;
     }
 
-	strcpy(configPathname, configFile);
-
     return SC_NO_ERROR;
 }
 
@@ -64,15 +138,20 @@ StreamControllerError streamControllerDeinit()
         return SC_ERROR;
     }
     
-    threadExit = 1;
+    postCommand(SC_CMD_DEINIT, 0, false, NULL);
     if (pthread_join(scThread, NULL))
     {
         printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
         return SC_THREAD_ERROR;
     }
     
-    /* free demux filter */  
+    /* free demux filters */  
     Demux_Free_Filter(playerHandle, filterHandle);
+    freeEitFilters();
+
+    /* stop section workers, no section is queued after filters are freed */
+    stopSectionWorkers();
+    epgScheduleDeinit(&epgSchedule);
 
 	/* remove audio stream */
 	Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
@@ -89,10 +168,12 @@ StreamControllerError streamControllerDeinit()
     /* deinitialize tuner device */
     Tuner_Deinit();
     
+    /* store last channel and volume for next start */
+    saveChannelDb();
+
     /* free allocated memory */  
-    free(patTable);
-    free(pmtTable);
-	free(eitTable);    
+    freeTables();
+    sectionCacheDeinit(&sectionCache);
 
     /* set isInitialized flag */
     isInitialized = false;
@@ -100,108 +181,62 @@ StreamControllerError streamControllerDeinit()
     return SC_NO_ERROR;
 }
 
-StreamControllerError channelUp()
+StreamControllerError channelUp(const struct timespec* keyTime)
 {   
-    if (programNumber >= patTable->serviceInfoCount - 2)
-    {
-        programNumber = 0;
-    } 
-    else
-    {
-        programNumber++;
-    }
-
-    /* set flag to start current channel */
-    changeChannel = true;
+    /* post command to start next channel, task wraps around last channel */
+    zapStatsBegin();
+    postCommand(SC_CMD_CHANNEL, 1, true, keyTime);
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError channelDown()
+StreamControllerError channelDown(const struct timespec* keyTime)
 {
-    if (programNumber <= 0)
-    {
-        programNumber = patTable->serviceInfoCount - 2;
-    } 
-    else
-    {
-        programNumber--;
-    }
-   
-    /* set flag to start current channel */
-    changeChannel = true;
+    /* post command to start previous channel, task wraps around first channel */
+    zapStatsBegin();
+    postCommand(SC_CMD_CHANNEL, -1, true, keyTime);
 
     return SC_NO_ERROR;
 }
 
 
-StreamControllerError channelSwitch(int16_t ch)
+StreamControllerError channelSwitch(int16_t ch, const struct timespec* keyTime)
 {
 
-    if (ch > patTable->serviceInfoCount)
+    if (ch > getServiceCount())
     {
         return SC_ERROR;
     } 
       
-    programNumber = ch;
- 	
 	printf("\nSwitch to channel %d \n", ch);
    
-    /* set flag to start current channel */
-    changeChannel = true;
+    /* post command to start channel */
+    zapStatsBegin();
+    postCommand(SC_CMD_CHANNEL, ch, false, keyTime);
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError volumeUp()
+StreamControllerError volumeUp(const struct timespec* keyTime)
 {   
-    if (volumeLevel != MAX_VOL_LEVEL)
-    {
-        volumeLevel++;
-    } 
-
-	printf("\nChange volume %d \n", volumeLevel);
- 
-    /* set flag to start volume up */
-    changeVolume = true;
-
-	volumeMute = false;
+    /* post command to step volume up, task clamps to max level */
+    postCommand(SC_CMD_VOLUME, 1, true, keyTime);
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError volumeDown()
+StreamControllerError volumeDown(const struct timespec* keyTime)
 {   
-    if (volumeLevel != 0)
-    {
-        volumeLevel--;
-    } 
-
-	printf("\nChange volume %d \n", volumeLevel);
- 
-    /* set flag to start volume down */
-    changeVolume = true;
-
-	volumeMute = false;
+    /* post command to step volume down, task clamps to zero */
+    postCommand(SC_CMD_VOLUME, -1, true, keyTime);
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError mute()
+StreamControllerError mute(const struct timespec* keyTime)
 {   
-    if (!volumeMute)
-    {
-        volumeMute = true;
-    }
-	else
-	{
-		volumeMute = false;		
-	} 
-
-	printf("\nMute volume %d \n", 0);
- 
-    /* set flag to start volume mute */
-    changeVolume = true;
+    /* post command to toggle mute, task resolves it against player mute state */
+    postCommand(SC_CMD_MUTE, 1, true, keyTime);
 
     return SC_NO_ERROR;
 }
@@ -214,48 +249,66 @@ StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
         return SC_ERROR;
     }
     
-    channelInfo->programNumber = currentChannel.programNumber;
-    channelInfo->audioPid = currentChannel.audioPid;
-    channelInfo->videoPid = currentChannel.videoPid;
+    pthread_mutex_lock(&channelInfoMutex);
+    *channelInfo = currentChannel;
+    pthread_mutex_unlock(&channelInfoMutex);
     
     return SC_NO_ERROR;
 }
 
-/* Sets filter to receive current channel PMT table
- * Parses current channel PMT table when it arrives
+/* Takes current channel PMT table from PMT cache,
+ * sets filter and waits for it only if it is not cached yet
  * Creates streams with current channel audio and video pids
+ * Key time is passed to channel number draw, its flip ends key-to-photon measurement of the zap
  */
-StreamControllerError startChannel(int32_t channelNumber)
+StreamControllerError startChannel(int32_t channelNumber, const struct timespec* keyTime)
 {
-    /* free PAT table filter */
-    Demux_Free_Filter(playerHandle, filterHandle);
-    
-    /* set demux filter for receive PMT table of program */
-    if(Demux_Set_Filter(playerHandle, patTable->patServiceInfoArray[channelNumber + 1].pid, 0x02, &filterHandle))
-	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-        return SC_ERROR;
-	}
-    
-    /* wait for a PMT table to be parsed*/
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
-	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        streamControllerDeinit();
-	}
-	pthread_mutex_unlock(&demuxMutex);
+    uint8_t serviceIndex = channelNumber + 1;
+    struct timespec pmtDeadline;
+    int32_t waitResult = 0;
+    PmtTable channelPmt;
+    const PmtTable* pmtTable = &channelPmt;
+    const PatTable* pat;
+    uint16_t pmtPid;
+    uint8_t slot;
+    bool pmtReady;
+    bool pmtFiltered = false;
+
+    pmtReady = copyServicePmt(serviceIndex, &channelPmt);
+    if (!pmtReady)
+    {
+        pat = tableSnapshotAcquire(&patSnapshot, &slot);
+        pmtPid = pat->patServiceInfoArray[serviceIndex].pid;
+        tableSnapshotRelease(&patSnapshot, slot);
 
-    /* free EIT table filter */
-    Demux_Free_Filter(playerHandle, filterHandle);
+        /* set demux filter for receive PMT table of program */
+        if (setPsiFilter(pmtPid, 0x02) != SC_NO_ERROR)
+        {
+            return SC_ERROR;
+        }
+        zapStatsMark(ZAP_STAGE_FILTER_SET);
+
+        /* wait for a PMT table to be parsed */
+        clock_gettime(CLOCK_REALTIME, &pmtDeadline);
+        pmtDeadline.tv_sec += ZAP_PMT_TIMEOUT_S;
+        pthread_mutex_lock(&demuxMutex);
+        while (!(pmtReady = copyServicePmt(serviceIndex, &channelPmt)) && waitResult != ETIMEDOUT)
+        {
+            waitResult = pthread_cond_timedwait(&demuxCond, &demuxMutex, &pmtDeadline);
+        }
+        pthread_mutex_unlock(&demuxMutex);
+
+        if (!pmtReady)
+        {
+            printf("\n%s : ERROR PMT of channel %d not received!\n", __FUNCTION__, channelNumber);
+            psiAcquisitionStep();
+            return SC_ERROR;
+        }
+        pmtFiltered = true;
+    }
+    __atomic_store_n(&currentServiceId, channelPmt.pmtHeader.programNumber, __ATOMIC_RELAXED);
+    zapStatsMark(ZAP_STAGE_PMT_READY);
 
-    /* set demux filter for receive EIT table of program */
-    if(Demux_Set_Filter(playerHandle, 0x12, 0x4E, &filterHandle))
-	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-        return SC_ERROR;
-	}
-    
     /* get audio and video pids */
     int16_t audioPid = -1;
     int16_t videoPid = -1;
@@ -270,7 +323,7 @@ StreamControllerError startChannel(int32_t channelNumber)
         {
             videoPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
 			/* check video config pids*/
-			if (config.configVideoPid != videoPid && !isInitialized)
+			if (config.configVideoPid != videoPid && !isInitialized && channelNumber == config.configProgramNumber)
 			{
 				printf("\nERROR Incompatabile video pid!\n"); 
 				return SC_ERROR;  	
@@ -281,15 +334,16 @@ StreamControllerError startChannel(int32_t channelNumber)
         {
             audioPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
 			/* check audio config pids*/
-			if (config.configAudioPid != audioPid && !isInitialized)
+			if (config.configAudioPid != audioPid && !isInitialized && channelNumber == config.configProgramNumber)
 			{
 				printf("\nERROR Incompatabile audio pid!\n");
   				return SC_ERROR; 	
 			}
         }
-        else if ((pmtTable->pmtElementaryInfoArray[i].streamType == 0x6))
+        else if (pmtEsIsTeletext(pmtTable, i))
         {
-        	hasTeletext = true; 
+            /* private PES without teletext_descriptor is subtitles or AC-3 */
+            hasTeletext = true;
         }
     }
 
@@ -308,6 +362,7 @@ StreamControllerError startChannel(int32_t channelNumber)
             printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
             streamControllerDeinit();
         }
+        zapStatsMark(ZAP_STAGE_VIDEO_CREATED);
     }
 	else
 	{
@@ -334,17 +389,28 @@ StreamControllerError startChannel(int32_t channelNumber)
             printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
             streamControllerDeinit();
         }
+        zapStatsMark(ZAP_STAGE_AUDIO_CREATED);
     }
     
     /* store current channel info */
+    pthread_mutex_lock(&channelInfoMutex);
     currentChannel.programNumber = channelNumber;
     currentChannel.audioPid = audioPid;
     currentChannel.videoPid = videoPid;
 	currentChannel.teletext = hasTeletext; 
+    pthread_mutex_unlock(&channelInfoMutex);
+
+    /* present event of every service is cached, banner is right in the first frame */
+    getEvent(channelPmt.pmtHeader.programNumber);
+
+	drawCnannel(currentChannel.programNumber, keyTime);
+	drawInfoBanner(currentChannel.programNumber, currentChannel.audioPid, currentChannel.videoPid, currentChannel.teletext,  currentChannel.eventTime, currentChannel.eventName, NULL);
 
-	sleep(3.6);
-	drawCnannel(currentChannel.programNumber);
-	drawInfoBanner(currentChannel.programNumber, currentChannel.audioPid, currentChannel.videoPid, currentChannel.teletext,  currentChannel.eventTime, currentChannel.eventName);
+    /* continue background acquisition where it was, a completed round saves channel database after the zap */
+    if (pmtFiltered)
+    {
+        psiAcquisitionStep();
+    }
 
 	return SC_NO_ERROR;
 }
@@ -354,40 +420,17 @@ void* streamControllerTask()
     gettimeofday(&now,NULL);
     lockStatusWaitTime.tv_sec = now.tv_sec+10;
 
-    /* allocate memory for PAT table section */
-    patTable=(PatTable*)malloc(sizeof(PatTable));
-    if(patTable==NULL)
-    {
-		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
-        return (void*) SC_ERROR;
-	}  
-    memset(patTable, 0x0, sizeof(PatTable));
-
-    /* allocate memory for PMT table section */
-    pmtTable=(PmtTable*)malloc(sizeof(PmtTable));
-    if(pmtTable==NULL)
-    {
-		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
-        return (void*) SC_ERROR;
-	}  
-    memset(pmtTable, 0x0, sizeof(PmtTable));
-
-    /* allocate memory for EIT table section */
-    eitTable=(EitTable*)malloc(sizeof(EitTable));
-    if(eitTable==NULL)
+    /* allocate published PAT, PMT cache and EIT tables */
+    if (initTables() != SC_NO_ERROR)
     {
-		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
         return (void*) SC_ERROR;
-	}  
-    memset(eitTable, 0x0, sizeof(EitTable));
+    }
       
     /* initialize tuner device */
     if(Tuner_Init())
     {
         printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(eitTable);
+        freeTables();
         return (void*) SC_ERROR;
     }
     
@@ -412,9 +455,7 @@ void* streamControllerTask()
     else
     {
         printf("\n%s: ERROR Tuner_Lock_To_Frequency(): %d Hz - fail!\n",__FUNCTION__,config.configFreq);
-        free(patTable);
-        free(pmtTable);
-		free(eitTable);
+        freeTables();
         Tuner_Deinit();
         return (void*) SC_ERROR;
     }
@@ -424,9 +465,7 @@ void* streamControllerTask()
     if(ETIMEDOUT == pthread_cond_timedwait(&statusCondition, &statusMutex, &lockStatusWaitTime))
     {
         printf("\n%s : ERROR Lock timeout exceeded!\n",__FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(eitTable);
+        freeTables();
         Tuner_Deinit();
         return (void*) SC_ERROR;
     }
@@ -436,9 +475,7 @@ void* streamControllerTask()
     if(Player_Init(&playerHandle))
     {
 		printf("\n%s : ERROR Player_Init() fail\n", __FUNCTION__);
-		free(patTable);
-        free(pmtTable);
-		free(eitTable);
+        freeTables();
         Tuner_Deinit();
         return (void*) SC_ERROR;
 	}
@@ -447,190 +484,1308 @@ void* streamControllerTask()
 	if(Player_Source_Open(playerHandle, &sourceHandle))
     {
 		printf("\n%s : ERROR Player_Source_Open() fail\n", __FUNCTION__);
-		free(patTable);
-        free(pmtTable);
+        freeTables();
 		Player_Deinit(playerHandle);
         Tuner_Deinit();
         return (void*) SC_ERROR;	
 	}
 
 	/* set PAT pid and tableID to demultiplexer */
-	if(Demux_Set_Filter(playerHandle, 0x00, 0x00, &filterHandle))
-	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-	}
+	setPsiFilter(0x00, 0x00);
 	
+    /* build CRC tables before first section arrives */
+    crc32Init();
+
+    /* initialize parsed sections cache */
+    if (sectionCacheInit(&sectionCache, SECTION_CACHE_DEFAULT_CAPACITY) != SECTION_CACHE_NO_ERROR)
+    {
+		printf("\n%s : ERROR sectionCacheInit() fail\n", __FUNCTION__);
+    }
+
+    /* schedule acquisition time is measured from here */
+    epgScheduleInit(&epgSchedule);
+
+    /* sections are parsed by workers, demux callback only queues them
+     * schedule carousel has its own ring and worker, its bursts cannot drop PAT or PMT of a zap
+     */
+    if (sectionRingInit(&sectionRing, config.configSectionRingSize) != SECTION_RING_NO_ERROR)
+    {
+		printf("\n%s : ERROR sectionRingInit() fail\n", __FUNCTION__);
+        Demux_Free_Filter(playerHandle, filterHandle);
+        releaseTaskResources();
+        return (void*) SC_ERROR;
+    }
+    if (sectionRingInit(&scheduleRing, EPG_SECTION_RING_SIZE) != SECTION_RING_NO_ERROR)
+    {
+		printf("\n%s : ERROR sectionRingInit() fail\n", __FUNCTION__);
+        Demux_Free_Filter(playerHandle, filterHandle);
+        sectionRingDeinit(&sectionRing);
+        releaseTaskResources();
+        return (void*) SC_ERROR;
+    }
+    if (pthread_create(&psiThread, NULL, &sectionWorkerTask, &sectionRing))
+    {
+        printf("Error creating section worker task!\n");
+        Demux_Free_Filter(playerHandle, filterHandle);
+        sectionRingDeinit(&sectionRing);
+        sectionRingDeinit(&scheduleRing);
+        releaseTaskResources();
+        return (void*) SC_THREAD_ERROR;
+    }
+    if (pthread_create(&epgThread, NULL, &sectionWorkerTask, &scheduleRing))
+    {
+        printf("Error creating section worker task!\n");
+        Demux_Free_Filter(playerHandle, filterHandle);
+
+        /* PSI worker is already running, it is stopped before its ring is freed */
+        psiWorkerExit = true;
+        sectionRingWake(&sectionRing);
+        if (pthread_join(psiThread, NULL))
+        {
+            printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+        }
+        sectionRingDeinit(&sectionRing);
+        sectionRingDeinit(&scheduleRing);
+        releaseTaskResources();
+        return (void*) SC_THREAD_ERROR;
+    }
+
+    /* start last channel from channel database, PSI is validated in background */
+    if (loadChannelDb())
+    {
+        printf("\n%s : INFO channel %d started from %s\n", __FUNCTION__, programNumber, channelDbPathname);
+        startChannel(programNumber, NULL);
+        postCommand(SC_CMD_VOLUME, playerVolumeLevel, false, NULL);
+        isInitialized = true;
+    }
+
 	/* register section filter callback */
     if(Demux_Register_Section_Filter_Callback(sectionReceivedCallback))
     {
 		printf("\n%s : ERROR Demux_Register_Section_Filter_Callback() fail\n", __FUNCTION__);
 	}
 
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
-	{
-		printf("\n%s:ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(eitTable);
-		Player_Deinit(playerHandle);
-        Tuner_Deinit();
-        return (void*) SC_ERROR;
-	}
-	pthread_mutex_unlock(&demuxMutex);
-
-
-	/* set program number to config program number */
-	if (config.configProgramNumber > patTable->serviceInfoCount - 2)
-	{
-		printf("\nERROR Config channel doesn't exist!\n");		
-		return (void*) SC_ERROR;				
- 	}
-	programNumber = config.configProgramNumber;    
+    /* EIT p/f and schedule are collected on their own filters, PSI filter stays free for zap */
+    setEitFilters();
 
-    /* start current channel if pid correct */
-    startChannel(programNumber);
+    if (!isInitialized)
+    {
+        struct timespec patDeadline;
+        int32_t waitResult = 0;
+
+        clock_gettime(CLOCK_REALTIME, &patDeadline);
+        patDeadline.tv_sec += PAT_TIMEOUT_S;
+        pthread_mutex_lock(&demuxMutex);
+	    while (getServiceCount() == 0 && waitResult != ETIMEDOUT)
+	    {
+	        waitResult = pthread_cond_timedwait(&demuxCond, &demuxMutex, &patDeadline);
+	    }
+	    pthread_mutex_unlock(&demuxMutex);
+
+	    if (getServiceCount() == 0)
+	    {
+		    printf("\n%s:ERROR PAT not received, timeout exceeded!\n", __FUNCTION__);
+
+            /* section workers read tables, they are stopped before tables are freed */
+            Demux_Free_Filter(playerHandle, filterHandle);
+            freeEitFilters();
+            stopSectionWorkers();
+            releaseTaskResources();
+            return (void*) SC_ERROR;
+	    }
+
+	    /* set program number to config program number */
+	    if (config.configProgramNumber > getServiceCount() - 2)
+	    {
+		    printf("\nERROR Config channel doesn't exist!\n");		
+		    return (void*) SC_ERROR;				
+ 	    }
+	    programNumber = config.configProgramNumber;    
+
+        /* acquire PMTs of all services in background */
+        psiAcquisitionStart();
+
+        /* start current channel if pid correct */
+        startChannel(programNumber, NULL);
 	        
-    /* set isInitialized flag */
-    isInitialized = true;
+        /* set isInitialized flag */
+        isInitialized = true;
+    }
 
-    while(!threadExit)
+    while(1)
     {
-        if (changeChannel)
+        StreamCommand commands[SC_CMD_COUNT];
+
+        /* sleep until a command is posted or next acquisition step is due */
+        if (!waitCommands(commands, psiState == PSI_STATE_PAT ? NULL : &psiDeadline))
+        {
+            if (psiState == PSI_STATE_PMT)
+            {
+                /* PMT did not arrive in time, try it again in next round */
+                pmtSeen[psiIndex] = true;
+                psiAcquisitionStep();
+            }
+            else if (psiState == PSI_STATE_EIT)
+            {
+                eitSharedFilterStep();
+            }
+            else
+            {
+                /* refresh all PMTs */
+                psiAcquisitionStart();
+            }
+            continue;
+        }
+
+        if (commands[SC_CMD_PSI].pending)
+        {
+            uint32_t psiFlags = (uint32_t)commands[SC_CMD_PSI].value;
+            uint8_t i;
+
+            /* workers only post, tables were published before the flags */
+            for (i = 0; i < TABLES_MAX_NUMBER_OF_PIDS_IN_PAT; i++)
+            {
+                if (psiFlags & SC_PSI_SERVICE(i))
+                {
+                    pmtSeen[i] = true;
+                }
+            }
+            if (psiFlags & SC_PSI_TABLES_CHANGED)
+            {
+                channelDbDirty = true;
+            }
+
+            if (psiState == PSI_STATE_PAT)
+            {
+                /* PAT arrived after start from channel database */
+                psiAcquisitionStart();
+            }
+            else if (psiState == PSI_STATE_PMT)
+            {
+                psiAcquisitionStep();
+            }
+        }
+
+        if (commands[SC_CMD_EPG].pending)
+        {
+            setEitFilters();
+        }
+
+        if (commands[SC_CMD_EVENT].pending)
+        {
+            getEvent(__atomic_load_n(&currentServiceId, __ATOMIC_RELAXED));
+            printf("Event name %s \n", currentChannel.eventName);
+        }
+
+        if (commands[SC_CMD_CHANNEL].pending)
         {
-            changeChannel = false;
-            startChannel(programNumber);
-			printf("\nSwitched to channel %d\n", programNumber);
+            programNumber = channelTarget(&commands[SC_CMD_CHANNEL]);
+            zapStatsMark(ZAP_STAGE_COMMAND);
+            startChannel(programNumber, commands[SC_CMD_CHANNEL].keyed ? &commands[SC_CMD_CHANNEL].keyTime : NULL);
+            channelDbDirty = true;
+			printf("\nSwitched to channel %d (latency %u us)\n", programNumber, commandLatency(SC_CMD_CHANNEL, &commands[SC_CMD_CHANNEL]));
         }
 
-		if (changeVolume)
+		if (commands[SC_CMD_VOLUME].pending || commands[SC_CMD_MUTE].pending)
         {
-            changeVolume = false;
-			if (!volumeMute)
+			setPlayerVolume(commands);
+			channelDbDirty = true;
+			if (commands[SC_CMD_VOLUME].keyed || commands[SC_CMD_MUTE].keyed)
+			{
+				drawVolumeLevel(playerMute ? 0 : playerVolumeLevel, commands[SC_CMD_VOLUME].keyed ? &commands[SC_CMD_VOLUME].keyTime : &commands[SC_CMD_MUTE].keyTime);
+			}
+			if (commands[SC_CMD_VOLUME].pending)
 			{
-				if (Player_Volume_Set(playerHandle, volumeLevel * 165400000))
-				{
-					printf("\n%s : ERROR Player_Volume_Set() fail\n", __FUNCTION__);
-				}
+				printf("\nVolume changed to %d (latency %u us)\n", playerVolumeLevel, commandLatency(SC_CMD_VOLUME, &commands[SC_CMD_VOLUME]));
 			}
-			else
+			if (commands[SC_CMD_MUTE].pending)
 			{
-				if (Player_Volume_Set(playerHandle, 0))
-				{
-					printf("\n%s : ERROR Player_Volume_Set() fail\n", __FUNCTION__);
-				}
+				printf("\nVolume mute %d (latency %u us)\n", playerMute, commandLatency(SC_CMD_MUTE, &commands[SC_CMD_MUTE]));
 			}
-			printf("\nVolume changed to %d\n", volumeLevel);
+        }
+
+        if (commands[SC_CMD_DEINIT].pending)
+        {
+            break;
         }
     }
+
+    return (void*) SC_NO_ERROR;
 }
 
-int32_t sectionReceivedCallback(uint8_t *buffer)
+/* Stores command in its type slot and wakes stream controller task,
+ * a command of the same type that was not executed yet is overwritten but keeps its first key time
+ * Relative value is added to the value of a pending command, so coalesced steps add up
+ */
+void postCommand(StreamCommandType type, int32_t value, bool relative, const struct timespec* keyTime)
 {
-    uint8_t tableId = *buffer;  
-    if(tableId==0x00)
+    pthread_mutex_lock(&commandQueue.mutex);
+    if (!commandQueue.commands[type].pending)
     {
-        //printf("\n%s -----PAT TABLE ARRIVED-----\n",__FUNCTION__);
-        
-        if(parsePatTable(buffer,patTable)==TABLES_PARSE_OK)
+        commandQueue.commands[type].keyed = false;
+    }
+    if (keyTime != NULL && !commandQueue.commands[type].keyed)
+    {
+        commandQueue.commands[type].keyed = true;
+        commandQueue.commands[type].keyTime = *keyTime;
+    }
+    if (relative && commandQueue.commands[type].pending)
+    {
+        commandQueue.commands[type].value += value;
+    }
+    else
+    {
+        commandQueue.commands[type].value = value;
+        commandQueue.commands[type].relative = relative;
+    }
+    commandQueue.commands[type].pending = true;
+    clock_gettime(CLOCK_MONOTONIC, &commandQueue.commands[type].postTime);
+    pthread_cond_signal(&commandQueue.cond);
+    pthread_mutex_unlock(&commandQueue.mutex);
+}
+
+/* Posts PSI command, flags are added to the flags of a pending PSI command so no arrival is lost */
+void postPsiCommand(uint32_t flags)
+{
+    pthread_mutex_lock(&commandQueue.mutex);
+    if (!commandQueue.commands[SC_CMD_PSI].pending)
+    {
+        commandQueue.commands[SC_CMD_PSI].value = 0;
+        commandQueue.commands[SC_CMD_PSI].relative = false;
+        commandQueue.commands[SC_CMD_PSI].keyed = false;
+    }
+    commandQueue.commands[SC_CMD_PSI].value |= (int32_t)flags;
+    commandQueue.commands[SC_CMD_PSI].pending = true;
+    clock_gettime(CLOCK_MONOTONIC, &commandQueue.commands[SC_CMD_PSI].postTime);
+    pthread_cond_signal(&commandQueue.cond);
+    pthread_mutex_unlock(&commandQueue.mutex);
+}
+
+/* Blocks until a command is posted or deadline passes, then takes all pending commands
+ * Returns false if deadline passed without commands
+ */
+bool waitCommands(StreamCommand* commands, const struct timespec* deadline)
+{
+    uint8_t i;
+    bool pending = false;
+
+    pthread_mutex_lock(&commandQueue.mutex);
+    while (!pending)
+    {
+        for (i = 0; i < SC_CMD_COUNT; i++)
         {
-            //printPatTable(patTable);
-            pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
-            
+            pending |= commandQueue.commands[i].pending;
         }
-    } 
-    else if (tableId==0x02)
-    {
-        //printf("\n%s -----PMT TABLE ARRIVED-----\n",__FUNCTION__);
-        
-        if(parsePmtTable(buffer,pmtTable)==TABLES_PARSE_OK)
+        if (!pending)
         {
-            //printPmtTable(pmtTable);
-            pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
+            if (deadline == NULL)
+            {
+                pthread_cond_wait(&commandQueue.cond, &commandQueue.mutex);
+            }
+            else if (ETIMEDOUT == pthread_cond_timedwait(&commandQueue.cond, &commandQueue.mutex, deadline))
+            {
+                pthread_mutex_unlock(&commandQueue.mutex);
+                return false;
+            }
         }
     }
-	else if (tableId==0x4E)
-	{
-		printf("\n%s -----EIT TABLE ARRIVED-----\n",__FUNCTION__);		
-		if(parseEitTable(buffer,eitTable)==TABLES_PARSE_OK)
-        {
-			//printEitTable(eitTable);
-			if ((pmtTable->pmtHeader).programNumber == (eitTable->eitHeader).serviceId && eitTable->eitInfoArray[0].runningStatus == 0x4)
-			{			
-				getEvent();
-				printf("Event name %s\n",eitTable->eitInfoArray[0].eventName);
-				printf("Event name %s \n",currentChannel.eventName);
-			} 
-			/*
-            pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
-			*/
+    memcpy(commands, commandQueue.commands, sizeof(commandQueue.commands));
+    for (i = 0; i < SC_CMD_COUNT; i++)
+    {
+        commandQueue.commands[i].pending = false;
+    }
+    pthread_mutex_unlock(&commandQueue.mutex);
+
+    return true;
+}
+
+/* Returns channel that channel command starts, relative command steps from current channel
+ * and wraps around channel list
+ */
+int16_t channelTarget(const StreamCommand* command)
+{
+    int32_t channelCount = getServiceCount() - 1;
+    int32_t target;
+
+    if (!command->relative)
+    {
+        return command->value;
+    }
+    if (channelCount <= 0)
+    {
+        return programNumber;
+    }
+
+    target = (programNumber + command->value) % channelCount;
+
+    return target < 0 ? target + channelCount : target;
+}
+
+/* Sets volume of taken volume and mute commands to player, volume command also unmutes
+ * and the later posted one wins when both are pending
+ */
+void setPlayerVolume(const StreamCommand* commands)
+{
+    const StreamCommand* volume = &commands[SC_CMD_VOLUME];
+    const StreamCommand* muteCommand = &commands[SC_CMD_MUTE];
+
+    int32_t level;
+
+    if (volume->pending)
+    {
+        level = volume->relative ? playerVolumeLevel + volume->value : volume->value;
+        playerVolumeLevel = level < 0 ? 0 : (level > MAX_VOL_LEVEL ? MAX_VOL_LEVEL : level);
+        playerMute = false;
+    }
+    if (muteCommand->pending && (!volume->pending ||
+        muteCommand->postTime.tv_sec > volume->postTime.tv_sec ||
+        (muteCommand->postTime.tv_sec == volume->postTime.tv_sec && muteCommand->postTime.tv_nsec >= volume->postTime.tv_nsec)))
+    {
+        /* even number of coalesced toggles keeps mute state */
+        if (muteCommand->value & 1)
+        {
+            playerMute = !playerMute;
         }
+    }
 
-	}
+    if (Player_Volume_Set(playerHandle, playerMute ? 0 : playerVolumeLevel * 165400000))
+    {
+        printf("\n%s : ERROR Player_Volume_Set() fail\n", __FUNCTION__);
+    }
+}
 
+/* Frees current PSI filter and sets new one, nothing is done if filter is already set */
+StreamControllerError setPsiFilter(uint16_t pid, uint8_t tableId)
+{
+    static bool filterSet = false;
+    static uint16_t filterPid;
+    static uint8_t filterTableId;
 
-    return 0;
+    if (filterSet && filterPid == pid && filterTableId == tableId)
+    {
+        return SC_NO_ERROR;
+    }
+
+    if (filterSet)
+    {
+        Demux_Free_Filter(playerHandle, filterHandle);
+        filterSet = false;
+    }
+
+    if (Demux_Set_Filter(playerHandle, pid, tableId, &filterHandle))
+    {
+		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+    filterSet = true;
+    filterPid = pid;
+    filterTableId = tableId;
+
+    return SC_NO_ERROR;
 }
 
-int32_t tunerStatusCallback(t_LockStatus status)
+/* Sets filters for EIT p/f actual and other and for every schedule table announced so far,
+ * set filters are kept
+ * Demux of the target may have a single section filter, when a filter cannot be set all EIT
+ * filters are freed and EIT tables are visited by PSI filter once all PMTs are cached
+ */
+void setEitFilters()
 {
-    if(status == STATUS_LOCKED)
+    uint32_t wantedTables = 0x3 | (epgScheduleGetWantedTables(&epgSchedule) << (EPG_TABLE_ACTUAL_FIRST - EIT_FILTER_FIRST_TABLE));
+    uint8_t bit;
+
+    if (eitSharedFilter)
     {
-        pthread_mutex_lock(&statusMutex);
-        pthread_cond_signal(&statusCondition);
-        pthread_mutex_unlock(&statusMutex);
-        printf("\n%s -----TUNER LOCKED-----\n",__FUNCTION__);
+        return;
     }
-    else
+
+    wantedTables &= ~eitFilteredTables;
+    for (bit = 0; wantedTables != 0; bit++, wantedTables >>= 1)
     {
-        printf("\n%s -----TUNER NOT LOCKED-----\n",__FUNCTION__);
+        if (!(wantedTables & 1))
+        {
+            continue;
+        }
+        if (Demux_Set_Filter(playerHandle, EPG_SCHEDULE_PID, EIT_FILTER_FIRST_TABLE + bit, &eitFilterHandles[bit]))
+        {
+            printf("\n%s : INFO Demux_Set_Filter() fail for table 0x%x, EIT shares PSI filter\n", __FUNCTION__, EIT_FILTER_FIRST_TABLE + bit);
+            freeEitFilters();
+            eitSharedFilter = true;
+            if (psiState == PSI_STATE_IDLE)
+            {
+                psiState = PSI_STATE_EIT;
+                eitSharedFilterStep();
+            }
+            return;
+        }
+        eitFilteredTables |= 1U << bit;
     }
-    return 0;
 }
 
-void getEvent()
+void freeEitFilters()
 {
-	uint32_t time = eitTable->eitInfoArray[0].startTime;
-	uint32_t mask = 0x0000F000;
-	uint16_t num;
-	char parsed_time[MAX_EVENT_LEN]; 
-	uint8_t i;
-	uint8_t j;
-	uint8_t k = 0;
+    uint8_t bit;
 
-	for (i = 0; i <  2; i++)
-	{
-		for (j = 0; j < 2; j++,k++)
-		{
-			num = time & mask;
-			mask >>= 4;
-			num >>= (12 - 4 * (i*2 + j));
-			if (k == 2)
-			{
-				parsed_time[k] = ':';
-				parsed_time[++k] = num + '0';
-			}
-			else
-			{
-				parsed_time[k] = num + '0';
-			}
-		}
-	}
-	parsed_time[5] = '\0';
-	
-	strncpy(currentChannel.eventTime,parsed_time,6);
-	strncpy(currentChannel.eventName,eitTable->eitInfoArray[0].eventName,50);	
+    for (bit = 0; bit <= EPG_TABLE_LAST - EIT_FILTER_FIRST_TABLE; bit++)
+    {
+        if (eitFilteredTables & (1U << bit))
+        {
+            Demux_Free_Filter(playerHandle, eitFilterHandles[bit]);
+        }
+    }
+    eitFilteredTables = 0;
 }
 
+/* Moves shared filter to next EIT table, p/f actual is watched between all other tables
+ * PAT is watched before PMT refresh round starts
+ */
+void eitSharedFilterStep()
+{
+    uint32_t tables = 0x2 | (epgScheduleGetWantedTables(&epgSchedule) << (EPG_TABLE_ACTUAL_FIRST - EIT_FILTER_FIRST_TABLE));
+    uint8_t tableCount = EPG_TABLE_LAST - EIT_FILTER_FIRST_TABLE + 1;
 
+    if (eitSharedTableId == 0x00)
+    {
+        /* p/f actual is watched first after refresh round */
+        eitSharedTableId = EPG_TABLE_LAST;
+        psiAcquisitionStart();
+        return;
+    }
 
+    if (deadlinePassed(&psiRefreshTime))
+    {
+        eitSharedTableId = 0x00;
+        setPsiFilter(0x00, 0x00);
+        setDeadline(&psiDeadline, PSI_PAT_DWELL_MS);
+        return;
+    }
 
+    if (eitSharedTableId != EIT_FILTER_FIRST_TABLE)
+    {
+        eitSharedTableId = EIT_FILTER_FIRST_TABLE;
+        setPsiFilter(EPG_SCHEDULE_PID, eitSharedTableId);
+        setDeadline(&psiDeadline, EIT_SHARED_PF_DWELL_MS);
+        return;
+    }
 
+    /* p/f other is always visited, loop ends */
+    while (!(tables & (1U << eitSharedNext)))
+    {
+        eitSharedNext = (eitSharedNext + 1) % tableCount;
+    }
+    eitSharedTableId = EIT_FILTER_FIRST_TABLE + eitSharedNext;
+    eitSharedNext = (eitSharedNext + 1) % tableCount;
+    setPsiFilter(EPG_SCHEDULE_PID, eitSharedTableId);
+    setDeadline(&psiDeadline, EIT_SHARED_TABLE_DWELL_MS);
+}
 
+/* Starts round in which the filter visits PMT of every service in PAT */
+void psiAcquisitionStart()
+{
+    memset(pmtSeen, 0x0, sizeof(pmtSeen));
+    psiState = PSI_STATE_PMT;
+    psiIndex = 0;
+    psiAcquisitionStep();
+}
 
+/* Sets filter for next PMT that did not arrive in this round,
+ * filter watches PAT when round is complete
+ */
+void psiAcquisitionStep()
+{
+    if (psiState == PSI_STATE_PAT)
+    {
+        setPsiFilter(0x00, 0x00);
+        return;
+    }
+
+    if (psiState == PSI_STATE_PMT)
+    {
+        const PatTable* pat;
+        uint16_t pmtPid = 0;
+        uint8_t slot;
+
+        /* program 0 carries NIT pid, it has no PMT */
+        pat = tableSnapshotAcquire(&patSnapshot, &slot);
+        while (psiIndex < pat->serviceInfoCount &&
+              (pmtSeen[psiIndex] || pat->patServiceInfoArray[psiIndex].programNumber == 0))
+        {
+            psiIndex++;
+        }
+        if (psiIndex < pat->serviceInfoCount)
+        {
+            pmtPid = pat->patServiceInfoArray[psiIndex].pid;
+        }
+        tableSnapshotRelease(&patSnapshot, slot);
+
+        if (pmtPid != 0)
+        {
+            setPsiFilter(pmtPid, 0x02);
+            setDeadline(&psiDeadline, PSI_PMT_TIMEOUT_MS);
+            return;
+        }
+
+        psiState = eitSharedFilter ? PSI_STATE_EIT : PSI_STATE_IDLE;
+        setDeadline(&psiRefreshTime, PSI_REFRESH_PERIOD_S * 1000);
+        psiDeadline = psiRefreshTime;
+
+        /* round is complete, store what changed */
+        saveChannelDb();
+
+        if (psiState == PSI_STATE_EIT)
+        {
+            eitSharedFilterStep();
+            return;
+        }
+    }
+
+    if (psiState == PSI_STATE_EIT)
+    {
+        /* filter was taken for PMT of started channel, EIT table is watched again */
+        setPsiFilter(eitSharedTableId == 0x00 ? 0x00 : EPG_SCHEDULE_PID, eitSharedTableId);
+        return;
+    }
+
+    /* EIT has its own filters, PSI filter looks for new PAT version */
+    setPsiFilter(0x00, 0x00);
+}
+
+/* Returns index of service in PAT, -1 if service is not in PAT */
+int8_t findServiceIndex(uint16_t serviceId)
+{
+    const PatTable* pat;
+    int8_t serviceIndex = -1;
+    uint8_t slot;
+    uint8_t i;
+
+    pat = tableSnapshotAcquire(&patSnapshot, &slot);
+    for (i = 0; i < pat->serviceInfoCount; i++)
+    {
+        if (pat->patServiceInfoArray[i].programNumber == serviceId)
+        {
+            serviceIndex = i;
+            break;
+        }
+    }
+    tableSnapshotRelease(&patSnapshot, slot);
+
+    return serviceIndex;
+}
+
+void setDeadline(struct timespec* deadline, uint32_t milliseconds)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += (milliseconds % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+/* Places channel database into directory of config file */
+void setChannelDbPathname()
+{
+    const char* separator = strrchr(configPathname, '/');
+    int32_t directoryLength = separator != NULL ? separator - configPathname + 1 : 0;
+
+    snprintf(channelDbPathname, sizeof(channelDbPathname), "%.*s%s", directoryLength, configPathname, CHANNEL_DB_FILE_NAME);
+}
+
+bool deadlinePassed(const struct timespec* deadline)
+{
+    struct timespec nowTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &nowTime);
+
+    return nowTime.tv_sec > deadline->tv_sec || (nowTime.tv_sec == deadline->tv_sec && nowTime.tv_nsec >= deadline->tv_nsec);
+}
+
+/* Fills PAT and PMT cache from channel database written on previous run
+ * Returns true if last channel can be started without waiting for PSI
+ */
+bool loadChannelDb()
+{
+    ChannelDb db;
+    PatTable* pat;
+    PmtCache* pmts;
+    uint8_t i;
+    int16_t lastChannel;
+    bool lastValid;
+
+    if (channelDbOpen(channelDbPathname, &db) != CHANNEL_DB_NO_ERROR)
+    {
+        return false;
+    }
+
+    /* database of other multiplex is not used */
+    lastChannel = db.header->lastChannel;
+    if (db.header->frequency != (uint32_t)config.configFreq || lastChannel < 0 || lastChannel + 1 >= db.header->serviceCount)
+    {
+        channelDbClose(&db);
+        return false;
+    }
+
+    pat = (PatTable*)tableSnapshotBeginUpdate(&patSnapshot);
+    pmts = (PmtCache*)tableSnapshotBeginUpdate(&pmtSnapshot);
+    pat->patHeader.transportStreamId = db.header->transportStreamId;
+    pat->serviceInfoCount = db.header->serviceCount;
+    for (i = 0; i < db.header->serviceCount; i++)
+    {
+        pmts->valid[i] = channelDbServiceToTables(&db.services[i], &pat->patServiceInfoArray[i], &pmts->tables[i]);
+    }
+    lastValid = pmts->valid[lastChannel + 1];
+    tableSnapshotPublish(&pmtSnapshot);
+    tableSnapshotPublish(&patSnapshot);
+
+    if (db.header->volumeLevel >= 0 && db.header->volumeLevel <= MAX_VOL_LEVEL)
+    {
+        playerVolumeLevel = db.header->volumeLevel;
+    }
+    channelDbClose(&db);
+
+    if (!lastValid)
+    {
+        return false;
+    }
+    programNumber = lastChannel;
+
+    return true;
+}
+
+/* Writes services, last channel and volume to channel database if anything changed since last write */
+void saveChannelDb()
+{
+    ChannelDbHeader header;
+    ChannelDbService services[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT];
+    const PatTable* pat;
+    const PmtCache* pmts;
+    uint8_t patSlot;
+    uint8_t pmtSlot;
+    uint8_t i;
+
+    if (!channelDbDirty || getServiceCount() == 0)
+    {
+        return;
+    }
+    channelDbDirty = false;
+
+    memset(&header, 0x0, sizeof(ChannelDbHeader));
+    pat = tableSnapshotAcquire(&patSnapshot, &patSlot);
+    pmts = tableSnapshotAcquire(&pmtSnapshot, &pmtSlot);
+    header.frequency = config.configFreq;
+    header.transportStreamId = pat->patHeader.transportStreamId;
+    header.serviceCount = pat->serviceInfoCount;
+    for (i = 0; i < pat->serviceInfoCount; i++)
+    {
+        channelDbServiceFromTables(&services[i], &pat->patServiceInfoArray[i], pmts->valid[i] ? &pmts->tables[i] : NULL);
+    }
+    tableSnapshotRelease(&pmtSnapshot, pmtSlot);
+    tableSnapshotRelease(&patSnapshot, patSlot);
+
+    header.lastChannel = programNumber;
+    header.volumeLevel = playerVolumeLevel;
+    if (channelDbSave(channelDbPathname, &header, services) != CHANNEL_DB_NO_ERROR)
+    {
+        channelDbDirty = true;
+    }
+}
+
+bool patServicesEqual(const PatTable* first, const PatTable* second)
+{
+    uint8_t i;
+
+    if (first->patHeader.transportStreamId != second->patHeader.transportStreamId ||
+        first->serviceInfoCount != second->serviceInfoCount)
+    {
+        return false;
+    }
+
+    for (i = 0; i < first->serviceInfoCount; i++)
+    {
+        if (first->patServiceInfoArray[i].programNumber != second->patServiceInfoArray[i].programNumber ||
+            first->patServiceInfoArray[i].pid != second->patServiceInfoArray[i].pid)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Allocates published tables, every reader sees empty tables until first publish */
+StreamControllerError initTables()
+{
+    if (tableSnapshotInit(&patSnapshot, sizeof(PatTable)) != TABLE_SNAPSHOT_NO_ERROR ||
+        tableSnapshotInit(&pmtSnapshot, sizeof(PmtCache)) != TABLE_SNAPSHOT_NO_ERROR ||
+        tableSnapshotInit(&eitSnapshot, sizeof(EitPfCache)) != TABLE_SNAPSHOT_NO_ERROR)
+    {
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        freeTables();
+        return SC_ERROR;
+    }
+
+    return SC_NO_ERROR;
+}
+
+void freeTables()
+{
+    tableSnapshotDeinit(&patSnapshot);
+    tableSnapshotDeinit(&pmtSnapshot);
+    tableSnapshotDeinit(&eitSnapshot);
+}
+
+uint8_t getServiceCount()
+{
+    const PatTable* pat;
+    uint8_t serviceCount;
+    uint8_t slot;
+
+    pat = tableSnapshotAcquire(&patSnapshot, &slot);
+    serviceCount = pat->serviceInfoCount;
+    tableSnapshotRelease(&patSnapshot, slot);
+
+    return serviceCount;
+}
+
+/* Copies cached PMT of service, returns false if PMT is not cached */
+bool copyServicePmt(uint8_t serviceIndex, PmtTable* pmtTable)
+{
+    const PmtCache* pmts;
+    uint8_t slot;
+    bool valid;
+
+    pmts = tableSnapshotAcquire(&pmtSnapshot, &slot);
+    valid = pmts->valid[serviceIndex];
+    if (valid)
+    {
+        *pmtTable = pmts->tables[serviceIndex];
+    }
+    tableSnapshotRelease(&pmtSnapshot, slot);
+
+    return valid;
+}
+
+/* Compares only fields that are used to start a channel */
+bool pmtStreamsEqual(const PmtTable* first, const PmtTable* second)
+{
+    uint8_t i;
+
+    if (first->pmtHeader.pcrPid != second->pmtHeader.pcrPid ||
+        first->elementaryInfoCount != second->elementaryInfoCount)
+    {
+        return false;
+    }
+
+    for (i = 0; i < first->elementaryInfoCount; i++)
+    {
+        /* PMT restored from channel database keeps only the teletext_descriptor of ES descriptors */
+        if (first->pmtElementaryInfoArray[i].streamType != second->pmtElementaryInfoArray[i].streamType ||
+            first->pmtElementaryInfoArray[i].elementaryPid != second->pmtElementaryInfoArray[i].elementaryPid ||
+            pmtEsIsTeletext(first, i) != pmtEsIsTeletext(second, i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Returns time from command post to now in microseconds and updates latency stats */
+uint32_t commandLatency(StreamCommandType type, const StreamCommand* command)
+{
+    struct timespec nowTime;
+    uint32_t latency;
+
+    clock_gettime(CLOCK_MONOTONIC, &nowTime);
+    latency = (uint32_t)((nowTime.tv_sec - command->postTime.tv_sec) * 1000000 + (nowTime.tv_nsec - command->postTime.tv_nsec) / 1000);
+
+    commandLatencyLast[type] = latency;
+    if (latency > commandLatencyMax[type])
+    {
+        commandLatencyMax[type] = latency;
+    }
+
+    return latency;
+}
+
+StreamControllerError getPsiStats(PsiStats* stats)
+{
+    if (stats == NULL)
+    {
+        printf("\n%s : ERROR wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    SectionRingStats ringStats;
+
+    *stats = psiStats;
+    stats->cacheHits = sectionCache.hits;
+    stats->cacheMisses = sectionCache.misses;
+
+    sectionRingGetStats(&sectionRing, &ringStats);
+    stats->ringOverflows = ringStats.overflows + ringStats.oversized;
+    stats->ringHighWater = ringStats.highWater;
+    sectionRingGetStats(&scheduleRing, &ringStats);
+    stats->scheduleRingOverflows = ringStats.overflows + ringStats.oversized;
+
+    return SC_NO_ERROR;
+}
+
+StreamControllerError getEpgProgress(EpgProgress* progress)
+{
+    if (progress == NULL)
+    {
+        printf("\n%s : ERROR wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    if (epgScheduleGetProgress(&epgSchedule, progress) != EPG_SCHEDULE_NO_ERROR)
+    {
+        return SC_ERROR;
+    }
+
+    return SC_NO_ERROR;
+}
+
+StreamControllerError getEpgEvents(uint16_t serviceId, uint32_t from, uint32_t to, EpgEvent* events, uint32_t* count)
+{
+    if (events == NULL || count == NULL)
+    {
+        printf("\n%s : ERROR wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    *count = epgScheduleGetEvents(&epgSchedule, serviceId, from, to, events, *count);
+
+    return SC_NO_ERROR;
+}
+
+StreamControllerError getEpgEventText(uint16_t serviceId, uint16_t eventId, EpgText type, char* text, uint32_t textSize)
+{
+    if (text == NULL || textSize == 0)
+    {
+        printf("\n%s : ERROR wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    return epgScheduleGetEventText(&epgSchedule, serviceId, eventId, type, text, textSize) ? SC_NO_ERROR : SC_ERROR;
+}
+
+StreamControllerError getCommandLatency(StreamCommandType type, uint32_t* lastLatency, uint32_t* maxLatency)
+{
+    if (type >= SC_CMD_COUNT || lastLatency == NULL || maxLatency == NULL)
+    {
+        printf("\n%s : ERROR wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    *lastLatency = commandLatencyLast[type];
+    *maxLatency = commandLatencyMax[type];
+
+    return SC_NO_ERROR;
+}
+
+/* Runs in demux context, section is only queued for PSI or EPG worker */
+int32_t sectionReceivedCallback(uint8_t *buffer)
+{
+    if (*buffer >= EPG_TABLE_ACTUAL_FIRST && *buffer <= EPG_TABLE_LAST)
+    {
+        sectionRingPush(&scheduleRing, buffer);
+    }
+    else
+    {
+        sectionRingPush(&sectionRing, buffer);
+    }
+
+    return 0;
+}
+
+/* Drains section ring in batches, reports sections lost on overflow */
+void* sectionWorkerTask(void* ring)
+{
+    SectionRing* sectionQueue = (SectionRing*)ring;
+    const uint8_t* section;
+    SectionRingStats ringStats;
+    uint32_t reportedDrops = 0;
+
+    while (!psiWorkerExit)
+    {
+        sectionRingWait(sectionQueue);
+
+        while ((section = sectionRingPeek(sectionQueue)) != NULL)
+        {
+            parseSection(section);
+            sectionRingRelease(sectionQueue);
+        }
+
+        sectionRingGetStats(sectionQueue, &ringStats);
+        if (ringStats.overflows + ringStats.oversized != reportedDrops)
+        {
+            reportedDrops = ringStats.overflows + ringStats.oversized;
+            printf("\n%s : ERROR %s ring overflow, %u sections dropped so far (ring size %u)\n", __FUNCTION__,
+                   sectionQueue == &scheduleRing ? "schedule" : "section", reportedDrops, sectionQueue->slotCount);
+        }
+    }
+
+    return NULL;
+}
+
+/* Stops PSI and EPG workers and frees their rings, demux callback must not queue sections any more */
+void stopSectionWorkers()
+{
+    psiWorkerExit = true;
+    sectionRingWake(&sectionRing);
+    sectionRingWake(&scheduleRing);
+    if (pthread_join(psiThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+    }
+    if (pthread_join(epgThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+    }
+    sectionRingDeinit(&sectionRing);
+    sectionRingDeinit(&scheduleRing);
+}
+
+/* Releases what stream controller task acquired before its section workers, on failed start */
+void releaseTaskResources()
+{
+    epgScheduleDeinit(&epgSchedule);
+    sectionCacheDeinit(&sectionCache);
+    freeTables();
+    Player_Source_Close(playerHandle, sourceHandle);
+    Player_Deinit(playerHandle);
+    Tuner_Deinit();
+}
+
+int32_t parseSection(const uint8_t* buffer)
+{
+    uint8_t tableId = *buffer;  
+
+    /* PSI and EPG worker both count */
+    __atomic_add_fetch(&psiStats.sections, 1, __ATOMIC_RELAXED);
+
+    /* schedule sections are too many for section cache, collector keeps its own section bitmaps */
+    if (tableId >= EPG_TABLE_ACTUAL_FIRST && tableId <= EPG_TABLE_LAST)
+    {
+        parseScheduleSection(buffer);
+        return 0;
+    }
+
+    /* p/f of services with equal service_id on other transport streams share section cache key,
+     * present/following cache keeps version of every service
+     */
+    if (tableId == 0x4E || tableId == 0x4F)
+    {
+        parsePfSection(buffer);
+        return 0;
+    }
+
+    /* skip sections whose version was already parsed, CRC_32 is computed only for new versions */
+    if (sectionCacheLookup(&sectionCache, buffer) == SECTION_CACHE_HIT)
+    {
+        SectionView view;
+        int8_t serviceIndex;
+
+        /* unchanged PMT still completes its acquisition step */
+        if (tableId == 0x02 && sectionViewInit(&view, buffer, 0) &&
+           (serviceIndex = findServiceIndex(sectionViewTableIdExtension(&view))) >= 0)
+        {
+            postPsiCommand(SC_PSI_SERVICE(serviceIndex));
+        }
+        return 0;
+    }
+
+    /* drop corrupted sections before they reach the parsers */
+    if (!sectionCrcValid(buffer))
+    {
+        return 0;
+    }
+
+    if(tableId==0x00)
+    {
+        //printf("\n%s -----PAT TABLE ARRIVED-----\n",__FUNCTION__);
+        PatTable receivedPat;
+        PatTable* pat;
+        PmtCache* pmts;
+        bool changed;
+
+        pat = (PatTable*)tableSnapshotBeginUpdate(&patSnapshot);
+        if(parsePatTable(buffer,&receivedPat)==TABLES_PARSE_OK)
+        {
+            //printPatTable(&receivedPat);
+            sectionCacheUpdate(&sectionCache, buffer);
+
+            /* PMTs from channel database or previous PAT may not belong to new services */
+            changed = !patServicesEqual(pat, &receivedPat);
+            if (changed)
+            {
+                pmts = (PmtCache*)tableSnapshotBeginUpdate(&pmtSnapshot);
+                memset(pmts->valid, 0x0, sizeof(pmts->valid));
+                tableSnapshotPublish(&pmtSnapshot);
+            }
+            *pat = receivedPat;
+            tableSnapshotPublish(&patSnapshot);
+
+            pthread_mutex_lock(&demuxMutex);
+		    pthread_cond_signal(&demuxCond);
+		    pthread_mutex_unlock(&demuxMutex);
+
+            postPsiCommand(changed ? SC_PSI_TABLES_CHANGED : 0);
+
+            /* current channel has to wait for its PMT again */
+            if (changed && isInitialized)
+            {
+                postCommand(SC_CMD_CHANNEL, 0, true, NULL);
+            }
+        }
+        else
+        {
+            tableSnapshotAbort(&patSnapshot);
+        }
+    } 
+    else if (tableId==0x02)
+    {
+        //printf("\n%s -----PMT TABLE ARRIVED-----\n",__FUNCTION__);
+        PmtTable receivedPmt;
+        PmtCache* pmts;
+        int8_t serviceIndex;
+        bool changed;
+        bool stored;
+        
+        if(parsePmtTable(buffer,&receivedPmt)==TABLES_PARSE_OK)
+        {
+            //printPmtTable(&receivedPmt);
+            serviceIndex = findServiceIndex(receivedPmt.pmtHeader.programNumber);
+            if (serviceIndex < 0)
+            {
+                return 0;
+            }
+            sectionCacheUpdate(&sectionCache, buffer);
+
+            /* store PMT of service into PMT cache */
+            pmts = (PmtCache*)tableSnapshotBeginUpdate(&pmtSnapshot);
+            changed = pmts->valid[serviceIndex] && !pmtStreamsEqual(&pmts->tables[serviceIndex], &receivedPmt);
+            stored = pmts->valid[serviceIndex];
+            pmts->tables[serviceIndex] = receivedPmt;
+            pmts->valid[serviceIndex] = true;
+            tableSnapshotPublish(&pmtSnapshot);
+
+            pthread_mutex_lock(&demuxMutex);
+		    pthread_cond_signal(&demuxCond);
+		    pthread_mutex_unlock(&demuxMutex);
+
+            postPsiCommand(SC_PSI_SERVICE(serviceIndex) | (!stored || changed ? SC_PSI_TABLES_CHANGED : 0));
+
+            /* new version of current channel PMT, streams have to be created again */
+            if (changed && isInitialized && receivedPmt.pmtHeader.programNumber == __atomic_load_n(&currentServiceId, __ATOMIC_RELAXED))
+            {
+                postCommand(SC_CMD_CHANNEL, 0, true, NULL);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Checks CRC_32 of PSI or EIT p/f section, corrupted section is counted and reported */
+bool sectionCrcValid(const uint8_t* buffer)
+{
+    if (!crc32SectionValid(buffer))
+    {
+        printf("\n%s : ERROR CRC_32 mismatch, table 0x%x dropped (%u so far)\n", __FUNCTION__, *buffer,
+               __atomic_add_fetch(&psiStats.crcErrors, 1, __ATOMIC_RELAXED));
+        return false;
+    }
+
+    return true;
+}
+
+/* Stores present or following event of any service, section_number 0 is present and 1 following
+ * Section of a version that is already stored is skipped
+ */
+void parsePfSection(const uint8_t* buffer)
+{
+    SectionView view;
+    SectionLoopIterator iterator;
+    EitEventView eventView;
+    Descriptor descriptor;
+    const EitPfCache* publishedCache;
+    EitPfCache* cache;
+    EitPfService* service = NULL;
+    EitPfEvent* event;
+    uint8_t sectionNumber;
+    bool currentPresent;
+    uint8_t slot;
+    int16_t serviceIndex;
+
+    if (!sectionViewInit(&view, buffer, 0) || !eitEventIteratorInit(&view, &iterator) || sectionViewSectionNumber(&view) > 1)
+    {
+        return;
+    }
+    sectionNumber = sectionViewSectionNumber(&view);
+
+    publishedCache = tableSnapshotAcquire(&eitSnapshot, &slot);
+    serviceIndex = findPfService(publishedCache, &view);
+    if (serviceIndex >= 0 && publishedCache->services[serviceIndex].versions[sectionNumber] == sectionViewVersionNumber(&view))
+    {
+        tableSnapshotRelease(&eitSnapshot, slot);
+        return;
+    }
+    tableSnapshotRelease(&eitSnapshot, slot);
+
+    /* CRC_32 is computed only for new versions */
+    if (!sectionCrcValid(buffer))
+    {
+        return;
+    }
+
+    cache = (EitPfCache*)tableSnapshotBeginUpdate(&eitSnapshot);
+    if (serviceIndex >= 0)
+    {
+        service = &cache->services[serviceIndex];
+    }
+    else
+    {
+        if (cache->serviceCount == EIT_PF_MAX_SERVICES)
+        {
+            tableSnapshotAbort(&eitSnapshot);
+            return;
+        }
+        service = &cache->services[cache->serviceCount++];
+        memset(service, 0x0, sizeof(EitPfService));
+        service->originalNetworkId = eitViewOriginalNetworkId(&view);
+        service->transportStreamId = eitViewTransportStreamId(&view);
+        service->serviceId = sectionViewTableIdExtension(&view);
+        service->actual = sectionViewTableId(&view) == 0x4E;
+        memset(service->versions, 0xFF, sizeof(service->versions));
+    }
+    service->versions[sectionNumber] = sectionViewVersionNumber(&view);
+
+    /* section without event clears it, e.g. no following event */
+    event = &service->events[sectionNumber];
+    memset(event, 0x0, sizeof(EitPfEvent));
+    if (eitEventIteratorNext(&iterator, &eventView))
+    {
+        event->valid = true;
+        event->eventId = eventView.eventId;
+        event->startTime = eitStartTimeToUnix(eventView.startTime);
+        event->duration = eitDurationToSeconds(eventView.duration);
+        event->runningStatus = eventView.runningStatus;
+        if (parseDescriptor(eventView.descriptors, eventView.descriptorsLength, DESCRIPTOR_SHORT_EVENT, &descriptor) == TABLES_PARSE_OK)
+        {
+            strncpy(event->name, descriptor.shortEvent.eventName, EPG_NAME_LEN - 1);
+        }
+    }
+    currentPresent = service->actual && sectionNumber == 0 && service->serviceId == __atomic_load_n(&currentServiceId, __ATOMIC_RELAXED);
+    tableSnapshotPublish(&eitSnapshot);
+
+    /* present event of current channel changed, channel info belongs to stream controller task */
+    if (currentPresent)
+    {
+        postCommand(SC_CMD_EVENT, 0, false, NULL);
+    }
+}
+
+/* Returns index of service of EIT p/f section in present/following cache, -1 if service is not cached */
+int16_t findPfService(const EitPfCache* cache, const SectionView* view)
+{
+    uint8_t i;
+
+    for (i = 0; i < cache->serviceCount; i++)
+    {
+        if (cache->services[i].serviceId == sectionViewTableIdExtension(view) &&
+            cache->services[i].transportStreamId == eitViewTransportStreamId(view) &&
+            cache->services[i].originalNetworkId == eitViewOriginalNetworkId(view))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Stores schedule section, filters of newly announced tables are set by stream controller task */
+void parseScheduleSection(const uint8_t* buffer)
+{
+    EpgProgress progress;
+    uint32_t wantedTables = epgSchedule.wantedTables;
+    bool wasComplete = epgSchedule.complete;
+
+    switch (epgScheduleAddSection(&epgSchedule, buffer))
+    {
+        case EPG_SECTION_STORED:
+            if (epgSchedule.wantedTables != wantedTables)
+            {
+                postCommand(SC_CMD_EPG, 0, false, NULL);
+            }
+            if (!wasComplete && epgSchedule.complete)
+            {
+                epgScheduleGetProgress(&epgSchedule, &progress);
+                printf("\n%s : INFO EPG schedule complete, %u services, %u events, %u sections in %u ms\n", __FUNCTION__,
+                       progress.services, progress.events, progress.sectionsReceived, progress.completeMs);
+            }
+            break;
+        case EPG_SECTION_CRC_ERROR:
+            printf("\n%s : ERROR CRC_32 mismatch, table 0x%x dropped (%u so far)\n", __FUNCTION__, *buffer,
+                   __atomic_add_fetch(&psiStats.crcErrors, 1, __ATOMIC_RELAXED));
+            break;
+        default:
+            break;
+    }
+}
+
+int32_t tunerStatusCallback(t_LockStatus status)
+{
+    if(status == STATUS_LOCKED)
+    {
+        pthread_mutex_lock(&statusMutex);
+        pthread_cond_signal(&statusCondition);
+        pthread_mutex_unlock(&statusMutex);
+        printf("\n%s -----TUNER LOCKED-----\n",__FUNCTION__);
+    }
+    else
+    {
+        printf("\n%s -----TUNER NOT LOCKED-----\n",__FUNCTION__);
+    }
+    return 0;
+}
+
+/* Copies present event of service from present/following cache to current channel info,
+ * event is cleared if service has no present event yet
+ */
+void getEvent(uint16_t serviceId)
+{
+    const EitPfCache* cache;
+    const EitPfEvent* present = NULL;
+    uint8_t slot;
+    uint8_t i;
+
+    pthread_mutex_lock(&channelInfoMutex);
+    cache = tableSnapshotAcquire(&eitSnapshot, &slot);
+    for (i = 0; i < cache->serviceCount; i++)
+    {
+        if (cache->services[i].serviceId == serviceId && cache->services[i].actual)
+        {
+            present = &cache->services[i].events[0];
+            break;
+        }
+    }
+
+    if (present != NULL && present->valid)
+    {
+        snprintf(currentChannel.eventTime, MAX_EVENT_LEN, "%02u:%02u", (present->startTime / 3600) % 24, (present->startTime / 60) % 60);
+        strncpy(currentChannel.eventName, present->name, EPG_NAME_LEN - 1);
+        currentChannel.eventName[EPG_NAME_LEN - 1] = '\0';
+    }
+    else
+    {
+        currentChannel.eventTime[0] = '\0';
+        currentChannel.eventName[0] = '\0';
+    }
+    tableSnapshotRelease(&eitSnapshot, slot);
+    pthread_mutex_unlock(&channelInfoMutex);
+}
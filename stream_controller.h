@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include "tables.h"
+#include "epg_schedule.h"
 #include "tdp_api.h"
 #include "pthread.h"
 #include <stdlib.h>
@@ -17,7 +18,20 @@
 
 #define MAX_VOL_LEVEL 10
 
-#define MAX_EVENT_LEN 10
+#define MAX_EVENT_LEN 10                    /* Event start time string */
+
+#define PSI_PMT_TIMEOUT_MS 500              /* Time to wait for one PMT during background acquisition */
+#define PSI_REFRESH_PERIOD_S 30             /* Period of background PMT refresh */
+#define ZAP_PMT_TIMEOUT_S 3                 /* Time to wait for PMT that is not cached yet */
+#define PAT_TIMEOUT_S 10                    /* Time to wait for first PAT when no channel database is found */
+#define EIT_PF_MAX_SERVICES 64              /* Services of actual and other TS in present/following cache */
+#define EIT_FILTER_FIRST_TABLE 0x4E         /* EIT filters cover p/f 0x4E-0x4F and schedule 0x50-0x6F */
+#define EIT_SHARED_PF_DWELL_MS 2000         /* Time shared filter watches EIT p/f actual */
+#define EIT_SHARED_TABLE_DWELL_MS 10000     /* Time shared filter watches other EIT table, one schedule repetition */
+#define PSI_PAT_DWELL_MS 500                /* Time shared filter watches PAT before PMT refresh */
+#define EPG_SECTION_RING_SIZE 256           /* Slots of schedule section ring */
+#define SC_PSI_SERVICE(index) (1U << (index))   /* SC_CMD_PSI flag, PMT of service index arrived */
+#define SC_PSI_TABLES_CHANGED (1U << 30)    /* SC_CMD_PSI flag, published tables differ from channel database */
 
 
 /**
@@ -30,6 +44,114 @@ typedef enum _StreamControllerError
     SC_THREAD_ERROR
 }StreamControllerError;
 
+/**
+ * @brief Enumeration of stream controller commands
+ */
+typedef enum _StreamCommandType
+{
+    SC_CMD_CHANNEL = 0,                 /* Start channel, value is channel number or relative channel step */
+    SC_CMD_VOLUME,                      /* Set volume, value is volume level or relative volume step */
+    SC_CMD_MUTE,                        /* Toggle mute, value is number of toggles */
+    SC_CMD_PSI,                         /* PSI section parsed, value is SC_PSI_* flags of all posts since taken */
+    SC_CMD_EPG,                         /* Schedule section announced new EIT schedule tables */
+    SC_CMD_EVENT,                       /* Present event of current channel changed */
+    SC_CMD_DEINIT,                      /* Stop stream controller task */
+    SC_CMD_COUNT
+}StreamCommandType;
+
+/**
+ * @brief Enumeration of background PSI acquisition states
+ */
+typedef enum _PsiAcquisitionState
+{
+    PSI_STATE_PAT = 0,                  /* Waiting for PAT */
+    PSI_STATE_PMT,                      /* Filter cycles through PMTs of all services */
+    PSI_STATE_IDLE,                     /* All PMTs are cached, filter watches PAT until next refresh */
+    PSI_STATE_EIT                       /* All PMTs are cached, demux has no filter left for EIT,
+                                           filter visits EIT tables and PAT until next refresh */
+}PsiAcquisitionState;
+
+/**
+ * @brief Structure that defines one pending stream controller command
+ */
+typedef struct _StreamCommand
+{
+    bool pending;                       /* Command is posted and not yet executed */
+    int32_t value;                      /* Command argument, latest post wins unless relative */
+    bool relative;                      /* Value is a step from current state, coalesced steps add up */
+    struct timespec postTime;           /* Time of the latest post (CLOCK_MONOTONIC) */
+    bool keyed;                         /* Command was posted for a key event */
+    struct timespec keyTime;            /* Time of the first key event since the command was taken (CLOCK_MONOTONIC) */
+}StreamCommand;
+
+/**
+ * @brief Structure that defines stream controller command queue
+ */
+typedef struct _StreamCommandQueue
+{
+    StreamCommand commands[SC_CMD_COUNT];   /* One slot per command type */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                    /* Signaled on every post */
+}StreamCommandQueue;
+
+/**
+ * @brief Structure that defines PSI section statistics
+ */
+typedef struct _PsiStats
+{
+    uint32_t sections;                  /* Sections received from demux */
+    uint32_t crcErrors;                 /* Sections dropped because of wrong CRC_32 */
+    uint32_t cacheHits;                 /* Sections skipped because version was already parsed */
+    uint32_t cacheMisses;               /* Sections passed to parsers */
+    uint32_t ringOverflows;             /* Sections dropped before PSI worker took them */
+    uint32_t ringHighWater;             /* Max number of sections waiting for PSI worker */
+    uint32_t scheduleRingOverflows;     /* EIT schedule sections dropped before EPG worker took them */
+}PsiStats;
+
+/**
+ * @brief Structure that defines PMT cache, PMT of every service in PAT
+ */
+typedef struct _PmtCache
+{
+    PmtTable tables[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT];     /* Indexed like PAT services */
+    bool valid[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT];          /* PMT of service was received */
+}PmtCache;
+
+/**
+ * @brief Structure that defines present or following event
+ */
+typedef struct _EitPfEvent
+{
+    bool valid;                         /* Section of event carried an event */
+    uint16_t eventId;
+    uint32_t startTime;                 /* Seconds since 1970-01-01 UTC */
+    uint32_t duration;                  /* Seconds */
+    uint8_t runningStatus;
+    char name[EPG_NAME_LEN];
+}EitPfEvent;
+
+/**
+ * @brief Structure that defines present and following event of one service
+ */
+typedef struct _EitPfService
+{
+    uint16_t originalNetworkId;
+    uint16_t transportStreamId;
+    uint16_t serviceId;
+    bool actual;                        /* Received in EIT p/f actual (0x4E) */
+    uint8_t versions[2];                /* version_number of present and following section, 0xFF before first */
+    EitPfEvent events[2];               /* Indexed by section_number, present and following */
+}EitPfService;
+
+/**
+ * @brief Structure that defines present/following cache of all services in EIT p/f actual and other
+ */
+typedef struct _EitPfCache
+{
+    EitPfService services[EIT_PF_MAX_SERVICES];
+    uint8_t serviceCount;
+}EitPfCache;
+
 /**
  * @brief Structure that defines channel info
  */
@@ -40,7 +162,7 @@ typedef struct _ChannelInfo
     int16_t videoPid;
 	bool teletext;
 	char eventTime[MAX_EVENT_LEN];
-	char eventName[MAX_EVENT_LEN];
+	char eventName[EPG_NAME_LEN];
 }ChannelInfo;
 
 /**
@@ -56,6 +178,7 @@ typedef struct _InitConfig
 	t_Module configModule;
     tStreamType configAudioType;
 	tStreamType configVideoType;	
+	uint16_t configSectionRingSize;     /* Number of section ring slots, 0 for default */
 }InitConfig;
 
 /**
@@ -76,53 +199,110 @@ StreamControllerError streamControllerDeinit();
 /**
  * @brief Channel up
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError channelUp();
+StreamControllerError channelUp(const struct timespec* keyTime);
 
 /**
  * @brief Channel down
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError channelDown();
+StreamControllerError channelDown(const struct timespec* keyTime);
 
 /**
  * @brief Channel switch to channel number
  *
+ * @param [in] ch - channel number
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError channelSwitch(int16_t ch);
+StreamControllerError channelSwitch(int16_t ch, const struct timespec* keyTime);
 
 /**
  * @brief Volume up
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError volumeUp();
+StreamControllerError volumeUp(const struct timespec* keyTime);
 
 /**
  * @brief Volume down
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError volumeDown();
+StreamControllerError volumeDown(const struct timespec* keyTime);
 
 /**
  * @brief Volume mute
  *
+ * @param [in] keyTime - time of key event (CLOCK_MONOTONIC), NULL if not triggered by key
  * @return stream controller error
  */
-StreamControllerError mute();
+StreamControllerError mute(const struct timespec* keyTime);
 
 /**
- * @brief Returns current channel info
+ * @brief Returns copy of current channel info
  *
  * @param [out] channelInfo - channel info structure with current channel info
  * @return stream controller error code
  */
 StreamControllerError getChannelInfo(ChannelInfo* channelInfo);
 
+/**
+ * @brief Returns latency from command post to command execution
+ *
+ * @param [in] type - command type
+ * @param [out] lastLatency - latency of the last executed command in microseconds
+ * @param [out] maxLatency - max latency since init in microseconds
+ * @return stream controller error code
+ */
+StreamControllerError getCommandLatency(StreamCommandType type, uint32_t* lastLatency, uint32_t* maxLatency);
+
+/**
+ * @brief Returns PSI section statistics
+ *
+ * @param [out] psiStats - PSI section statistics
+ * @return stream controller error code
+ */
+StreamControllerError getPsiStats(PsiStats* psiStats);
+
+/**
+ * @brief Returns EIT schedule acquisition progress
+ *
+ * @param [out] progress - acquisition progress
+ * @return stream controller error code
+ */
+StreamControllerError getEpgProgress(EpgProgress* progress);
+
+/**
+ * @brief Returns scheduled events of service that overlap time range
+ *
+ * @param [in] serviceId - service_id
+ * @param [in] from - range start, seconds since 1970-01-01 UTC
+ * @param [in] to - range end, exclusive
+ * @param [out] events - event array
+ * @param [in,out] count - size of event array, number of returned events
+ * @return stream controller error code
+ */
+StreamControllerError getEpgEvents(uint16_t serviceId, uint32_t from, uint32_t to, EpgEvent* events, uint32_t* count);
+
+/**
+ * @brief Returns short or extended description text of scheduled event
+ *
+ * @param [in] serviceId - service_id
+ * @param [in] eventId - event_id
+ * @param [in] type - EPG_TEXT_SHORT or EPG_TEXT_EXTENDED
+ * @param [out] text - text, cut to fit and always terminated
+ * @param [in] textSize - size of text buffer
+ * @return stream controller error code, SC_ERROR if event is not in schedule
+ */
+StreamControllerError getEpgEventText(uint16_t serviceId, uint16_t eventId, EpgText type, char* text, uint32_t textSize);
+
 
 #endif /* __STREAM_CONTROLLER_H__ */
 
@@ -1,5 +1,32 @@
 #include "tables.h"
 
+typedef ParseErrorCode(*DescriptorDecoder)(const DescriptorView* descriptorView, Descriptor* descriptor);
+
+static void copyLanguage(char* language, const uint8_t* code);
+static ParseErrorCode decodeShortEvent(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeExtendedEvent(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeComponent(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeStreamIdentifier(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeContent(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeParentalRating(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeIso639Language(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeTeletext(const DescriptorView* descriptorView, Descriptor* descriptor);
+static ParseErrorCode decodeSubtitling(const DescriptorView* descriptorView, Descriptor* descriptor);
+
+/* Decoders indexed by descriptor tag, descriptors are decoded only when a consumer asks for their tag */
+static const DescriptorDecoder descriptorDecoders[256] =
+{
+    [DESCRIPTOR_ISO_639_LANGUAGE] = decodeIso639Language,
+    [DESCRIPTOR_SHORT_EVENT] = decodeShortEvent,
+    [DESCRIPTOR_EXTENDED_EVENT] = decodeExtendedEvent,
+    [DESCRIPTOR_COMPONENT] = decodeComponent,
+    [DESCRIPTOR_STREAM_IDENTIFIER] = decodeStreamIdentifier,
+    [DESCRIPTOR_CONTENT] = decodeContent,
+    [DESCRIPTOR_PARENTAL_RATING] = decodeParentalRating,
+    [DESCRIPTOR_TELETEXT] = decodeTeletext,
+    [DESCRIPTOR_SUBTITLING] = decodeSubtitling
+};
+
 ParseErrorCode parsePatHeader(const uint8_t* patHeaderBuffer, PatHeader* patHeader)
 {    
     if(patHeaderBuffer==NULL || patHeader==NULL)
@@ -234,6 +261,8 @@ ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable
 {
     uint8_t * currentBufferPosition = NULL;
     uint32_t parsedLength = 0;
+    uint16_t esDescriptorsLength = 0;
+    uint16_t esInfoLength;
     
     if(pmtSectionBuffer==NULL || pmtTable==NULL)
     {
@@ -261,6 +290,18 @@ ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable
         
         if(parsePmtElementaryInfo(currentBufferPosition, &(pmtTable->pmtElementaryInfoArray[pmtTable->elementaryInfoCount])) == TABLES_PARSE_OK)
         {
+            /* ES descriptors are kept undecoded, consumers decode the tags they need */
+            esInfoLength = pmtTable->pmtElementaryInfoArray[pmtTable->elementaryInfoCount].esInfoLength;
+            if(esDescriptorsLength + esInfoLength > TABLES_MAX_ES_DESCRIPTORS_LEN ||
+               parsedLength + 5 + esInfoLength > pmtTable->pmtHeader.sectionLength)
+            {
+                printf("\n%s : ERROR ES_info_length exceeds section\n", __FUNCTION__);
+                return TABLES_PARSE_ERROR;
+            }
+            memcpy(&pmtTable->esDescriptors[esDescriptorsLength], currentBufferPosition + 5, esInfoLength);
+            pmtTable->pmtElementaryInfoArray[pmtTable->elementaryInfoCount].esDescriptorsOffset = esDescriptorsLength;
+            esDescriptorsLength += esInfoLength;
+
             currentBufferPosition += 5 + pmtTable->pmtElementaryInfoArray[pmtTable->elementaryInfoCount].esInfoLength; /* Size from stream type to elemntary info descriptor*/
             parsedLength += 5 + pmtTable->pmtElementaryInfoArray[pmtTable->elementaryInfoCount].esInfoLength; /* Size from stream type to elementary info descriptor */
             pmtTable->elementaryInfoCount++;
@@ -299,218 +340,266 @@ ParseErrorCode printPmtTable(PmtTable* pmtTable)
     return TABLES_PARSE_OK;
 }
 
-ParseErrorCode parseEitHeader(const uint8_t* eitHeaderBuffer, EitTableHeader* eitHeader)
-{    
-    if(eitHeaderBuffer==NULL || eitHeader==NULL)
+bool findDescriptor(SectionLoopIterator* iterator, uint8_t tag, DescriptorView* descriptorView)
+{
+    /* only tag and length of skipped descriptors are read */
+    while (descriptorIteratorNext(iterator, descriptorView))
+    {
+        if (descriptorView->tag == tag)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ParseErrorCode decodeDescriptor(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    if (descriptorView == NULL || descriptor == NULL || descriptorDecoders[descriptorView->tag] == NULL)
     {
         printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
         return TABLES_PARSE_ERROR;
     }
 
-    eitHeader->tableId = (uint8_t)* eitHeaderBuffer; 
-    if (eitHeader->tableId != 0x4E)
+    descriptor->tag = descriptorView->tag;
+
+    return descriptorDecoders[descriptorView->tag](descriptorView, descriptor);
+}
+
+ParseErrorCode parseDescriptor(const uint8_t* descriptors, uint16_t descriptorsLength, uint8_t tag, Descriptor* descriptor)
+{
+    SectionLoopIterator iterator;
+    DescriptorView descriptorView;
+
+    if (descriptors == NULL || descriptor == NULL)
     {
-        printf("\n%s : ERROR it is not a EIT Table\n", __FUNCTION__);
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
         return TABLES_PARSE_ERROR;
     }
-    
-    uint8_t lower8Bits = 0;
-    uint8_t higher8Bits = 0;
-    uint16_t all16Bits = 0;
-    
-    lower8Bits = (uint8_t)(*(eitHeaderBuffer + 1));
-    lower8Bits = lower8Bits >> 7;
-    eitHeader->sectionSyntaxIndicator = lower8Bits & 0x01;
 
-    higher8Bits = (uint8_t) (*(eitHeaderBuffer + 1));
-    lower8Bits = (uint8_t) (*(eitHeaderBuffer + 2));
-    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-    eitHeader->sectionLength = all16Bits & 0x0FFF;
-    
-   	higher8Bits = (uint8_t) (*(eitHeaderBuffer + 3));
-   	lower8Bits = (uint8_t) (*(eitHeaderBuffer + 4));
-  	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-	eitHeader->serviceId = all16Bits;    
-
-    lower8Bits = (uint8_t) (*(eitHeaderBuffer + 5));
-    lower8Bits = lower8Bits >> 1;
-    eitHeader->versionNumber = lower8Bits & 0x1F;
+    /* malformed descriptor does not hide a valid one with the same tag */
+    descriptorIteratorInit(&iterator, descriptors, descriptorsLength);
+    while (findDescriptor(&iterator, tag, &descriptorView))
+    {
+        if (decodeDescriptor(&descriptorView, descriptor) == TABLES_PARSE_OK)
+        {
+            return TABLES_PARSE_OK;
+        }
+    }
 
-    lower8Bits = (uint8_t) (*(eitHeaderBuffer + 5));
-    eitHeader->currentNextIndicator = lower8Bits & 0x01;
+    return TABLES_PARSE_ERROR;
+}
 
-    eitHeader->sectionNumber = (uint8_t) (*(eitHeaderBuffer + 6));
-	eitHeader->lastSectionNumber = (uint8_t) (*(eitHeaderBuffer + 7));
+void copyLanguage(char* language, const uint8_t* code)
+{
+    memcpy(language, code, 3);
+    language[3] = '\0';
+}
 
-	higher8Bits = (uint8_t) (*(eitHeaderBuffer + 8));
-    lower8Bits = (uint8_t) (*(eitHeaderBuffer + 9));
-	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-	eitHeader->transportStreamId = all16Bits;
+/* ISO_639_language_code, event_name_length, event_name, text_length, text */
+ParseErrorCode decodeShortEvent(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    const uint8_t* data = descriptorView->data;
+    uint8_t nameLength;
 
-	higher8Bits = (uint8_t) (*(eitHeaderBuffer + 10));
-    lower8Bits = (uint8_t) (*(eitHeaderBuffer + 11));
-	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-	eitHeader->transportStreamId = all16Bits;
+    if (descriptorView->length < 5 || data[3] > descriptorView->length - 5)
+    {
+        return TABLES_PARSE_ERROR;
+    }
+    nameLength = data[3];
+    if (data[4 + nameLength] > descriptorView->length - 5 - nameLength)
+    {
+        return TABLES_PARSE_ERROR;
+    }
 
-	eitHeader->segmentLastSectionNumber = (uint8_t) (*(eitHeaderBuffer + 12));
-	eitHeader->lastTableId = (uint8_t) (*(eitHeaderBuffer + 13));
+    copyLanguage(descriptor->shortEvent.language, data);
+    descriptor->shortEvent.eventName[0] = '\0';
+    dvbTextAppend(descriptor->shortEvent.eventName, 0, TABLES_MAX_DESCRIPTOR_TEXT_LEN, data + 4, nameLength);
+    descriptor->shortEvent.text[0] = '\0';
+    dvbTextAppend(descriptor->shortEvent.text, 0, TABLES_MAX_DESCRIPTOR_TEXT_LEN, data + 5 + nameLength, data[4 + nameLength]);
 
     return TABLES_PARSE_OK;
 }
 
-ParseErrorCode parseEitEventInfo(const uint8_t* eitEventInfoBuffer, EitEventInfo* eitEventInfo)
+/* descriptor_number, last_descriptor_number, ISO_639_language_code, length_of_items, items, text_length, text */
+ParseErrorCode decodeExtendedEvent(const DescriptorView* descriptorView, Descriptor* descriptor)
 {
-    if(eitEventInfoBuffer==NULL || eitEventInfo==NULL)
+    const uint8_t* data = descriptorView->data;
+    uint8_t itemsLength;
+    uint16_t position = 0;
+
+    if (descriptorView->length < 6 || data[4] > descriptorView->length - 6)
+    {
+        return TABLES_PARSE_ERROR;
+    }
+    itemsLength = data[4];
+    if (data[5 + itemsLength] > descriptorView->length - 6 - itemsLength)
     {
-        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
         return TABLES_PARSE_ERROR;
     }
-    
-	uint8_t i;
-    uint8_t lower8Bits = 0;
-    uint8_t higher8Bits = 0;
-	uint8_t descTag = 0;
-	uint8_t descLength = 0;
-	uint16_t offset;
-    uint16_t all16Bits = 0;
-	uint16_t higher16Bits = 0;
-	uint16_t lower16Bits = 0;
-	uint32_t all32Bits = 0;
 
+    descriptor->extendedEvent.descriptorNumber = data[0] >> 4;
+    descriptor->extendedEvent.lastDescriptorNumber = data[0] & 0x0F;
+    copyLanguage(descriptor->extendedEvent.language, data + 1);
 
-	higher8Bits = (uint8_t) (*eitEventInfoBuffer);
-    lower8Bits = (uint8_t) (*(eitEventInfoBuffer + 1));
-	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-	eitEventInfo->eventId = all16Bits;
+    /* item_description_length, item_description, item_length, item */
+    descriptor->extendedEvent.itemCount = 0;
+    while (position < itemsLength && position + 1 + data[5 + position] < itemsLength)
+    {
+        position += 2 + data[5 + position] + data[6 + position + data[5 + position]];
+        if (position > itemsLength)
+        {
+            break;
+        }
+        descriptor->extendedEvent.itemCount++;
+    }
 
-	higher8Bits = (uint8_t) (*(eitEventInfoBuffer + 2));
-    lower8Bits = (uint8_t) (*(eitEventInfoBuffer + 3));
-	higher16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);	
+    descriptor->extendedEvent.text[0] = '\0';
+    dvbTextAppend(descriptor->extendedEvent.text, 0, TABLES_MAX_DESCRIPTOR_TEXT_LEN, data + 6 + itemsLength, data[5 + itemsLength]);
 
-	higher8Bits = (uint8_t) (*(eitEventInfoBuffer + 4));
-    lower8Bits = (uint8_t) (*(eitEventInfoBuffer + 5));
-	lower16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    return TABLES_PARSE_OK;
+}
 
-	all32Bits = (uint16_t) ((higher16Bits << 16) + lower16Bits);
-	eitEventInfo->startTime = all32Bits;
+/* stream_content_ext, stream_content, component_type, component_tag, ISO_639_language_code, text */
+ParseErrorCode decodeComponent(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    const uint8_t* data = descriptorView->data;
 
-	higher8Bits = (uint8_t) (*(eitEventInfoBuffer + 10));
-    lower8Bits = (uint8_t) (*(eitEventInfoBuffer + 11));
-    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    if (descriptorView->length < 6)
+    {
+        return TABLES_PARSE_ERROR;
+    }
 
-    eitEventInfo->runningStatus = (uint8_t)((all16Bits & 0xE000) >> 13);
-	eitEventInfo->CAmode = (uint8_t)(all16Bits & 0x1000);
-	eitEventInfo->descriptorsLoopLength = all16Bits & 0x0FFF;
+    descriptor->component.streamContentExt = data[0] >> 4;
+    descriptor->component.streamContent = data[0] & 0x0F;
+    descriptor->component.componentType = data[1];
+    descriptor->component.componentTag = data[2];
+    copyLanguage(descriptor->component.language, data + 3);
+    descriptor->component.text[0] = '\0';
+    dvbTextAppend(descriptor->component.text, 0, TABLES_MAX_DESCRIPTOR_TEXT_LEN, data + 6, descriptorView->length - 6);
 
-	offset = 0;
+    return TABLES_PARSE_OK;
+}
 
-	if (eitEventInfo->runningStatus == 0x04)
-	{
-		while (offset < eitEventInfo->descriptorsLoopLength)
-		{	
-		   	descTag = *(eitEventInfoBuffer + 12 + offset);
-			descLength = *(eitEventInfoBuffer + 13 + offset);
+ParseErrorCode decodeStreamIdentifier(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    if (descriptorView->length < 1)
+    {
+        return TABLES_PARSE_ERROR;
+    }
 
-			if(descTag == 0x4d)
-			{
-				eitEventInfo->eventNameLength = (uint8_t) (*(eitEventInfoBuffer + 17 + offset));
-		        for(i = 0; i < eitEventInfo->eventNameLength; i++)
-		        {
-		        	eitEventInfo->eventName[i] = (char)(*(eitEventInfoBuffer + 18 + i + offset + 1));
-		        }
-		        eitEventInfo->eventName[i-1] = '\0';
+    descriptor->streamIdentifier.componentTag = descriptorView->data[0];
 
-				descLength = *(eitEventInfoBuffer + 18 + eitEventInfo->eventNameLength + offset);
+    return TABLES_PARSE_OK;
+}
 
-			}		
+/* content_nibble_level_1, content_nibble_level_2, user_byte per entry */
+ParseErrorCode decodeContent(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    const uint8_t* data = descriptorView->data;
+    uint8_t count = descriptorView->length / 2;
+    uint8_t i;
 
-			offset += descLength + 2;
-		}
-	}
+    if (count > TABLES_MAX_DESCRIPTOR_ITEMS)
+    {
+        count = TABLES_MAX_DESCRIPTOR_ITEMS;
+    }
+    for (i = 0; i < count; i++)
+    {
+        descriptor->content.items[i].level1 = data[2 * i] >> 4;
+        descriptor->content.items[i].level2 = data[2 * i] & 0x0F;
+        descriptor->content.items[i].userByte = data[2 * i + 1];
+    }
+    descriptor->content.itemCount = count;
 
     return TABLES_PARSE_OK;
 }
 
-ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable)
+/* country_code, rating per entry */
+ParseErrorCode decodeParentalRating(const DescriptorView* descriptorView, Descriptor* descriptor)
 {
-    uint8_t* currentBufferPosition = NULL;
-    uint32_t parsedLength = 0;
-    
-    if(eitSectionBuffer==NULL || eitTable==NULL)
+    const uint8_t* data = descriptorView->data;
+    uint8_t count = descriptorView->length / 4;
+    uint8_t i;
+
+    if (count > TABLES_MAX_DESCRIPTOR_ITEMS)
     {
-        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
-        return TABLES_PARSE_ERROR;
+        count = TABLES_MAX_DESCRIPTOR_ITEMS;
     }
-    
-    if(parseEitHeader(eitSectionBuffer,&(eitTable->eitHeader))!=TABLES_PARSE_OK)
+    for (i = 0; i < count; i++)
     {
-        printf("\n%s : ERROR parsing EIT header\n", __FUNCTION__);
-        return TABLES_PARSE_ERROR;
+        copyLanguage(descriptor->parentalRating.items[i].countryCode, data + 4 * i);
+        descriptor->parentalRating.items[i].rating = data[4 * i + 3];
     }
+    descriptor->parentalRating.itemCount = count;
 
-    parsedLength = 14 /*EIT header size*/ + 4/*CRC size*/ - 3 /*Not in section length*/;
-    currentBufferPosition = (uint8_t *)(eitSectionBuffer + 14); 
-    eitTable->eventInfoCount = 0; /* Number of info presented in EIT table */
-    
-    while(parsedLength < eitTable->eitHeader.sectionLength)
+    return TABLES_PARSE_OK;
+}
+
+/* ISO_639_language_code, audio_type per entry */
+ParseErrorCode decodeIso639Language(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    const uint8_t* data = descriptorView->data;
+    uint8_t count = descriptorView->length / 4;
+    uint8_t i;
+
+    if (count > TABLES_MAX_DESCRIPTOR_ITEMS)
     {
-        if(eitTable->eventInfoCount > TABLES_MAX_NUMBER_OF_EVENTS - 1)
-        {
-            printf("\n%s : ERROR there is not enough space in EIT structure for elementary info\n", __FUNCTION__);
-            return TABLES_PARSE_ERROR;
-        }
-        
-        if(parseEitEventInfo(currentBufferPosition, &(eitTable->eitInfoArray[eitTable->eventInfoCount])) == TABLES_PARSE_OK)
-        {
-            currentBufferPosition += 12 + eitTable->eitInfoArray[eitTable->eventInfoCount].descriptorsLoopLength ; 
-           	parsedLength += 12 + eitTable->eitInfoArray[eitTable->eventInfoCount].descriptorsLoopLength;
-            eitTable->eventInfoCount++;
-        }    
+        count = TABLES_MAX_DESCRIPTOR_ITEMS;
     }
+    for (i = 0; i < count; i++)
+    {
+        copyLanguage(descriptor->iso639Language.items[i].language, data + 4 * i);
+        descriptor->iso639Language.items[i].audioType = data[4 * i + 3];
+    }
+    descriptor->iso639Language.itemCount = count;
 
     return TABLES_PARSE_OK;
 }
 
-ParseErrorCode printEitTable(EitTable* eitTable)
+/* ISO_639_language_code, teletext_type, teletext_magazine_number, teletext_page_number per entry */
+ParseErrorCode decodeTeletext(const DescriptorView* descriptorView, Descriptor* descriptor)
 {
-    uint8_t i=0;
-    
-    if(eitTable==NULL)
+    const uint8_t* data = descriptorView->data;
+    uint8_t count = descriptorView->length / 5;
+    uint8_t i;
+
+    if (count > TABLES_MAX_DESCRIPTOR_ITEMS)
     {
-        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
-        return TABLES_PARSE_ERROR;
+        count = TABLES_MAX_DESCRIPTOR_ITEMS;
     }
-    
-    printf("\n********************EIT TABLE SECTION********************\n");
-    printf("table_id                 |      %x\n",eitTable->eitHeader.tableId);
-    printf("section_syntax_indicator |      %d\n",eitTable->eitHeader.sectionSyntaxIndicator);
-    printf("section_length           |      %d\n",eitTable->eitHeader.sectionLength);
-    printf("service_id               |      %d\n",eitTable->eitHeader.serviceId);
-    printf("versionNumber            |      %d\n",eitTable->eitHeader.versionNumber);
-    printf("current_next_indicator   |      %d\n",eitTable->eitHeader.currentNextIndicator);
-	printf("section_number    		 |      %d\n",eitTable->eitHeader.sectionNumber);
-	printf("last_section_number      |      %d\n",eitTable->eitHeader.lastSectionNumber);
-	printf("transport_stream_id      |      %d\n",eitTable->eitHeader.transportStreamId);
-	printf("original_network_id      |      %d\n",eitTable->eitHeader.originalNetworkId);
-	printf("segment_last_section     |      %d\n",eitTable->eitHeader.segmentLastSectionNumber);
-	printf("last_table_id       	 |      %d\n",eitTable->eitHeader.lastTableId);
-    
-    for (i=0; i<eitTable->eventInfoCount;i++)
+    for (i = 0; i < count; i++)
     {
-        printf("-----------------------------------------\n");
-        printf("event_id                |      %d\n",eitTable->eitInfoArray[i].eventId);
-		printf("start_time              |      %llx\n",eitTable->eitInfoArray[i].startTime);
-		printf("duration                |      %d\n",eitTable->eitInfoArray[i].duration);
-		printf("running_status          |      %x\n",eitTable->eitInfoArray[i].runningStatus);
-		printf("CA_mode                 |      %ld\n",eitTable->eitInfoArray[i].CAmode);
-		printf("descriptors_loop_length |      %ld\n",eitTable->eitInfoArray[i].descriptorsLoopLength);
-		printf("event_name_length		|      %ld\n",eitTable->eitInfoArray[i].eventNameLength);
-    }
-    printf("\n********************EIT TABLE SECTION********************\n");
-    
+        copyLanguage(descriptor->teletext.items[i].language, data + 5 * i);
+        descriptor->teletext.items[i].type = data[5 * i + 3] >> 3;
+        descriptor->teletext.items[i].magazineNumber = data[5 * i + 3] & 0x07;
+        descriptor->teletext.items[i].pageNumber = data[5 * i + 4];
+    }
+    descriptor->teletext.itemCount = count;
+
     return TABLES_PARSE_OK;
 }
 
+/* ISO_639_language_code, subtitling_type, composition_page_id, ancillary_page_id per entry */
+ParseErrorCode decodeSubtitling(const DescriptorView* descriptorView, Descriptor* descriptor)
+{
+    const uint8_t* data = descriptorView->data;
+    uint8_t count = descriptorView->length / 8;
+    uint8_t i;
 
+    if (count > TABLES_MAX_DESCRIPTOR_ITEMS)
+    {
+        count = TABLES_MAX_DESCRIPTOR_ITEMS;
+    }
+    for (i = 0; i < count; i++)
+    {
+        copyLanguage(descriptor->subtitling.items[i].language, data + 8 * i);
+        descriptor->subtitling.items[i].type = data[8 * i + 3];
+        descriptor->subtitling.items[i].compositionPageId = readBe16(data + 8 * i + 4);
+        descriptor->subtitling.items[i].ancillaryPageId = readBe16(data + 8 * i + 6);
+    }
+    descriptor->subtitling.itemCount = count;
 
-
+    return TABLES_PARSE_OK;
+}
@@ -0,0 +1,145 @@
+#include "table_snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#define TABLE_SNAPSHOT_COUNT_MASK   ((1ULL << TABLE_SNAPSHOT_INDEX_SHIFT) - 1)
+
+static bool slotFree(TableSnapshot* snapshot, uint8_t slot);
+
+TableSnapshotError tableSnapshotInit(TableSnapshot* snapshot, size_t tableSize)
+{
+    uint8_t i;
+
+    if (snapshot == NULL || tableSize == 0)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TABLE_SNAPSHOT_ERROR;
+    }
+
+    memset(snapshot, 0x0, sizeof(TableSnapshot));
+    for (i = 0; i < TABLE_SNAPSHOT_SLOTS; i++)
+    {
+        snapshot->slots[i].table = calloc(1, tableSize);
+        if (snapshot->slots[i].table == NULL)
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            tableSnapshotDeinit(snapshot);
+            return TABLE_SNAPSHOT_ERROR;
+        }
+    }
+    snapshot->tableSize = tableSize;
+    pthread_mutex_init(&snapshot->writerMutex, NULL);
+
+    /* slot 0 is published */
+    snapshot->current = 0;
+
+    return TABLE_SNAPSHOT_NO_ERROR;
+}
+
+TableSnapshotError tableSnapshotDeinit(TableSnapshot* snapshot)
+{
+    uint8_t i;
+
+    if (snapshot == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TABLE_SNAPSHOT_ERROR;
+    }
+
+    for (i = 0; i < TABLE_SNAPSHOT_SLOTS; i++)
+    {
+        free(snapshot->slots[i].table);
+        snapshot->slots[i].table = NULL;
+    }
+    if (snapshot->tableSize != 0)
+    {
+        pthread_mutex_destroy(&snapshot->writerMutex);
+        snapshot->tableSize = 0;
+    }
+
+    return TABLE_SNAPSHOT_NO_ERROR;
+}
+
+const void* tableSnapshotAcquire(TableSnapshot* snapshot, uint8_t* slot)
+{
+    uint64_t current = __atomic_fetch_add(&snapshot->current, 1, __ATOMIC_ACQUIRE);
+
+    *slot = (uint8_t)(current >> TABLE_SNAPSHOT_INDEX_SHIFT);
+
+    return snapshot->slots[*slot].table;
+}
+
+void tableSnapshotRelease(TableSnapshot* snapshot, uint8_t slot)
+{
+    __atomic_fetch_add(&snapshot->slots[slot].releases, 1, __ATOMIC_RELEASE);
+}
+
+void* tableSnapshotBeginUpdate(TableSnapshot* snapshot)
+{
+    uint8_t currentSlot;
+    uint8_t slot;
+    bool waited = false;
+
+    pthread_mutex_lock(&snapshot->writerMutex);
+    currentSlot = (uint8_t)(__atomic_load_n(&snapshot->current, __ATOMIC_RELAXED) >> TABLE_SNAPSHOT_INDEX_SHIFT);
+
+    /* grace period, spare slot may still be read */
+    for (slot = (currentSlot + 1) % TABLE_SNAPSHOT_SLOTS; !slotFree(snapshot, slot); slot = (slot + 1) % TABLE_SNAPSHOT_SLOTS)
+    {
+        if (slot == currentSlot)
+        {
+            waited = true;
+            sched_yield();
+        }
+    }
+    if (waited)
+    {
+        snapshot->graceWaits++;
+    }
+
+    /* nobody reads this slot anymore, it can be reset */
+    snapshot->slots[slot].retired = false;
+    snapshot->slots[slot].acquires = 0;
+    __atomic_store_n(&snapshot->slots[slot].releases, 0, __ATOMIC_RELAXED);
+
+    /* published table is immutable, writer reads it without acquiring */
+    memcpy(snapshot->slots[slot].table, snapshot->slots[currentSlot].table, snapshot->tableSize);
+    snapshot->updateSlot = slot;
+
+    return snapshot->slots[slot].table;
+}
+
+void tableSnapshotPublish(TableSnapshot* snapshot)
+{
+    uint64_t previous;
+    uint8_t previousSlot;
+
+    previous = __atomic_exchange_n(&snapshot->current, (uint64_t)snapshot->updateSlot << TABLE_SNAPSHOT_INDEX_SHIFT, __ATOMIC_ACQ_REL);
+    previousSlot = (uint8_t)(previous >> TABLE_SNAPSHOT_INDEX_SHIFT);
+
+    /* readers of previous table are known from now on */
+    snapshot->slots[previousSlot].acquires = previous & TABLE_SNAPSHOT_COUNT_MASK;
+    snapshot->slots[previousSlot].retired = true;
+
+    pthread_mutex_unlock(&snapshot->writerMutex);
+}
+
+void tableSnapshotAbort(TableSnapshot* snapshot)
+{
+    pthread_mutex_unlock(&snapshot->writerMutex);
+}
+
+/* Slot can be written if it was never published or all its readers released it */
+bool slotFree(TableSnapshot* snapshot, uint8_t slot)
+{
+    uint8_t currentSlot = (uint8_t)(__atomic_load_n(&snapshot->current, __ATOMIC_RELAXED) >> TABLE_SNAPSHOT_INDEX_SHIFT);
+
+    if (slot == currentSlot)
+    {
+        return false;
+    }
+
+    return !snapshot->slots[slot].retired ||
+           __atomic_load_n(&snapshot->slots[slot].releases, __ATOMIC_ACQUIRE) == snapshot->slots[slot].acquires;
+}
@@ -0,0 +1,118 @@
+#ifndef __TABLE_SNAPSHOT_H__
+#define __TABLE_SNAPSHOT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define TABLE_SNAPSHOT_SLOTS        3           /* Current, previous one still read, one being built */
+#define TABLE_SNAPSHOT_INDEX_SHIFT  48          /* current = slot index << 48 | acquires since publish */
+
+/*
+ * Published tables are immutable, writer builds new version in a spare slot
+ * and publishes it with one atomic exchange.
+ *
+ * Reader acquire and release are one atomic add each and never wait. Acquire
+ * counts readers in the same word that names the current slot, release counts
+ * them on the slot itself. A retired slot is reused once its release count
+ * reaches the acquire count it had when it was replaced, so the grace period
+ * ends exactly when the last reader of the old table is done. Only writers wait,
+ * and only if readers still hold both spare slots.
+ */
+
+/**
+ * @brief Enumeration of possible table snapshot error codes
+ */
+typedef enum _TableSnapshotError
+{
+    TABLE_SNAPSHOT_NO_ERROR = 0,
+    TABLE_SNAPSHOT_ERROR
+}TableSnapshotError;
+
+/**
+ * @brief Structure that defines one table version
+ */
+typedef struct _TableSnapshotSlot
+{
+    void* table;
+    uint64_t releases;                          /* Readers that released this slot */
+    uint64_t acquires;                          /* Readers that acquired this slot, valid when retired */
+    bool retired;                               /* Slot was replaced, may still be read */
+}TableSnapshotSlot;
+
+/**
+ * @brief Structure that defines snapshot published table
+ */
+typedef struct _TableSnapshot
+{
+    uint64_t current;                           /* Slot index and acquire count of published table */
+    TableSnapshotSlot slots[TABLE_SNAPSHOT_SLOTS];
+    size_t tableSize;
+    uint8_t updateSlot;                         /* Slot being built, valid between begin and publish */
+    uint32_t graceWaits;                        /* Times writer waited for readers */
+    pthread_mutex_t writerMutex;                /* Serializes writers, readers never take it */
+}TableSnapshot;
+
+/**
+ * @brief Initializes snapshot, published table is zeroed
+ *
+ * @param [out] snapshot - table snapshot
+ * @param [in] tableSize - size of table in bytes
+ * @return table snapshot error code
+ */
+TableSnapshotError tableSnapshotInit(TableSnapshot* snapshot, size_t tableSize);
+
+/**
+ * @brief Deinitializes snapshot, no reader or writer may be active
+ *
+ * @param [in] snapshot - table snapshot
+ * @return table snapshot error code
+ */
+TableSnapshotError tableSnapshotDeinit(TableSnapshot* snapshot);
+
+/**
+ * @brief Returns published table, wait-free
+ *
+ * Table stays valid and unchanged until tableSnapshotRelease.
+ *
+ * @param [in] snapshot - table snapshot
+ * @param [out] slot - slot to pass to tableSnapshotRelease
+ * @return published table
+ */
+const void* tableSnapshotAcquire(TableSnapshot* snapshot, uint8_t* slot);
+
+/**
+ * @brief Releases table returned by tableSnapshotAcquire, wait-free
+ *
+ * @param [in] snapshot - table snapshot
+ * @param [in] slot - slot returned by tableSnapshotAcquire
+ */
+void tableSnapshotRelease(TableSnapshot* snapshot, uint8_t slot);
+
+/**
+ * @brief Starts building new table version
+ *
+ * Blocks other writers until tableSnapshotPublish or tableSnapshotAbort.
+ *
+ * @param [in] snapshot - table snapshot
+ * @return writable copy of published table
+ */
+void* tableSnapshotBeginUpdate(TableSnapshot* snapshot);
+
+/**
+ * @brief Publishes table returned by tableSnapshotBeginUpdate
+ *
+ * @param [in] snapshot - table snapshot
+ */
+void tableSnapshotPublish(TableSnapshot* snapshot);
+
+/**
+ * @brief Drops table returned by tableSnapshotBeginUpdate, published table is not changed
+ *
+ * @param [in] snapshot - table snapshot
+ */
+void tableSnapshotAbort(TableSnapshot* snapshot);
+
+#endif /* __TABLE_SNAPSHOT_H__ */
@@ -4,11 +4,13 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include "section_view.h"
 
 #define TABLES_MAX_NUMBER_OF_PIDS_IN_PAT    20 	    /* Max number of PMT pids in one PAT table */
 #define TABLES_MAX_NUMBER_OF_ELEMENTARY_PID 20      /* Max number of elementary pids in one PMT table */
-#define TABLES_MAX_NUMBER_OF_EVENTS		    20 		/* Max number of events in one EIT table */
-#define TABLES_MAX_NAME_LEN				    20 
+#define TABLES_MAX_ES_DESCRIPTORS_LEN       1024    /* ES descriptors of one PMT, never more than the section */
+#define TABLES_MAX_DESCRIPTOR_TEXT_LEN      256     /* Text of one descriptor including terminating zero */
+#define TABLES_MAX_DESCRIPTOR_ITEMS         16      /* Entries of one repeated loop descriptor, the rest is dropped */
 
 /**
  * @brief Enumeration of possible tables parser error codes
@@ -78,6 +80,7 @@ typedef struct _PmtElementaryInfo
     uint8_t streamType;
     uint16_t elementaryPid;
     uint16_t esInfoLength;
+    uint16_t esDescriptorsOffset;               /* Offset of ES descriptors in esDescriptors of table */
 }PmtElementaryInfo;
 
 /**
@@ -88,51 +91,157 @@ typedef struct _PmtTable
     PmtTableHeader pmtHeader;
     PmtElementaryInfo pmtElementaryInfoArray[TABLES_MAX_NUMBER_OF_ELEMENTARY_PID];
     uint8_t elementaryInfoCount;
+    uint8_t esDescriptors[TABLES_MAX_ES_DESCRIPTORS_LEN];  /* Undecoded ES descriptors of all elementary streams */
 }PmtTable;
 
 /**
- * @brief Structure that defines EIT table header
+ * @brief Enumeration of descriptor tags with a decoder
  */
-typedef struct _EitTableHeader
+typedef enum _DescriptorTag
 {
-    uint8_t tableId;
-    uint8_t sectionSyntaxIndicator;
-    uint16_t sectionLength;
-	uint16_t serviceId;
-    uint8_t versionNumber;
-    uint8_t currentNextIndicator;
-    uint8_t sectionNumber;
-    uint8_t lastSectionNumber;
-	uint16_t transportStreamId;
-    uint16_t originalNetworkId;
-	uint8_t segmentLastSectionNumber;
-	uint8_t lastTableId;
-}EitTableHeader;
+    DESCRIPTOR_ISO_639_LANGUAGE = 0x0A,
+    DESCRIPTOR_SHORT_EVENT = 0x4D,
+    DESCRIPTOR_EXTENDED_EVENT = 0x4E,
+    DESCRIPTOR_COMPONENT = 0x50,
+    DESCRIPTOR_STREAM_IDENTIFIER = 0x52,
+    DESCRIPTOR_CONTENT = 0x54,
+    DESCRIPTOR_PARENTAL_RATING = 0x55,
+    DESCRIPTOR_TELETEXT = 0x56,
+    DESCRIPTOR_SUBTITLING = 0x59
+}DescriptorTag;
 
 /**
- * @brief Structure that defines EIT event info
+ * @brief Structure that defines short event descriptor
  */
-typedef struct _EitEventInfo
+typedef struct _ShortEventDescriptor
 {
-    uint16_t eventId;
-    uint32_t startTime;
-    uint32_t duration;
-	uint8_t runningStatus;
-	uint8_t CAmode;
-	uint16_t descriptorsLoopLength;
-	uint8_t eventNameLength;
-	char eventName[TABLES_MAX_NAME_LEN];
-}EitEventInfo;
+    char language[4];
+    char eventName[TABLES_MAX_DESCRIPTOR_TEXT_LEN];
+    char text[TABLES_MAX_DESCRIPTOR_TEXT_LEN];
+}ShortEventDescriptor;
 
 /**
- * @brief Structure that defines EIT table
+ * @brief Structure that defines extended event descriptor, items are counted but not decoded
  */
-typedef struct _EitTable
-{    
-    EitTableHeader eitHeader;                                                     /* EIT Table Header */
-    EitEventInfo eitInfoArray[TABLES_MAX_NUMBER_OF_EVENTS];    /* Event info presented in EIT table */
-    uint8_t eventInfoCount;                                                /* Number of events info presented in EIT table */
-}EitTable;
+typedef struct _ExtendedEventDescriptor
+{
+    uint8_t descriptorNumber;
+    uint8_t lastDescriptorNumber;
+    char language[4];
+    uint8_t itemCount;
+    char text[TABLES_MAX_DESCRIPTOR_TEXT_LEN];
+}ExtendedEventDescriptor;
+
+/**
+ * @brief Structure that defines component descriptor
+ */
+typedef struct _ComponentDescriptor
+{
+    uint8_t streamContentExt;
+    uint8_t streamContent;
+    uint8_t componentType;
+    uint8_t componentTag;
+    char language[4];
+    char text[TABLES_MAX_DESCRIPTOR_TEXT_LEN];
+}ComponentDescriptor;
+
+/**
+ * @brief Structure that defines stream identifier descriptor
+ */
+typedef struct _StreamIdentifierDescriptor
+{
+    uint8_t componentTag;
+}StreamIdentifierDescriptor;
+
+/**
+ * @brief Structure that defines content descriptor
+ */
+typedef struct _ContentDescriptor
+{
+    struct
+    {
+        uint8_t level1;                         /* content_nibble_level_1, genre */
+        uint8_t level2;                         /* content_nibble_level_2 */
+        uint8_t userByte;
+    }items[TABLES_MAX_DESCRIPTOR_ITEMS];
+    uint8_t itemCount;
+}ContentDescriptor;
+
+/**
+ * @brief Structure that defines parental rating descriptor
+ */
+typedef struct _ParentalRatingDescriptor
+{
+    struct
+    {
+        char countryCode[4];
+        uint8_t rating;                         /* Minimum age is rating + 3 for 0x01-0x0F */
+    }items[TABLES_MAX_DESCRIPTOR_ITEMS];
+    uint8_t itemCount;
+}ParentalRatingDescriptor;
+
+/**
+ * @brief Structure that defines ISO 639 language descriptor
+ */
+typedef struct _Iso639LanguageDescriptor
+{
+    struct
+    {
+        char language[4];
+        uint8_t audioType;
+    }items[TABLES_MAX_DESCRIPTOR_ITEMS];
+    uint8_t itemCount;
+}Iso639LanguageDescriptor;
+
+/**
+ * @brief Structure that defines teletext descriptor
+ */
+typedef struct _TeletextDescriptor
+{
+    struct
+    {
+        char language[4];
+        uint8_t type;                           /* 0x01 initial page, 0x02 subtitle page, 0x05 subtitle page for hearing impaired */
+        uint8_t magazineNumber;
+        uint8_t pageNumber;                     /* BCD */
+    }items[TABLES_MAX_DESCRIPTOR_ITEMS];
+    uint8_t itemCount;
+}TeletextDescriptor;
+
+/**
+ * @brief Structure that defines subtitling descriptor
+ */
+typedef struct _SubtitlingDescriptor
+{
+    struct
+    {
+        char language[4];
+        uint8_t type;
+        uint16_t compositionPageId;
+        uint16_t ancillaryPageId;
+    }items[TABLES_MAX_DESCRIPTOR_ITEMS];
+    uint8_t itemCount;
+}SubtitlingDescriptor;
+
+/**
+ * @brief Structure that defines one decoded descriptor, member is selected by tag
+ */
+typedef struct _Descriptor
+{
+    uint8_t tag;
+    union
+    {
+        ShortEventDescriptor shortEvent;
+        ExtendedEventDescriptor extendedEvent;
+        ComponentDescriptor component;
+        StreamIdentifierDescriptor streamIdentifier;
+        ContentDescriptor content;
+        ParentalRatingDescriptor parentalRating;
+        Iso639LanguageDescriptor iso639Language;
+        TeletextDescriptor teletext;
+        SubtitlingDescriptor subtitling;
+    };
+}Descriptor;
 
 
 /**
@@ -206,31 +315,68 @@ ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable
 ParseErrorCode printPmtTable(PmtTable* pmtTable);
 
 /**
- * @brief Parse Eit table
+ * @brief Advances descriptor iterator to next descriptor with tag, other descriptors are skipped undecoded
  *
- * @param [in]  eitHeaderBuffer Buffer that contains EIT header
- * @param [out] eitHeader EIT table header
- * @return tables error code
+ * @param [in,out] iterator Descriptor loop iterator, see descriptorIteratorInit
+ * @param [in] tag Descriptor tag
+ * @param [out] descriptorView Found descriptor
+ * @return true if descriptor was found
  */
-ParseErrorCode parseEitHeader(const uint8_t* eitHeaderBuffer, EitTableHeader* eitHeader);
+bool findDescriptor(SectionLoopIterator* iterator, uint8_t tag, DescriptorView* descriptorView);
 
 /**
- * @brief Parse EIT event info
+ * @brief Decodes descriptor with decoder registered for its tag
  *
- * @param [in]  eitEventInfoBuffer Buffer that contains pmt elementary info
- * @param [out] EIT elementary info
- * @return tables error code
+ * @param [in] descriptorView Descriptor
+ * @param [out] descriptor Decoded descriptor
+ * @return tables error code, error if tag has no decoder or descriptor is malformed
  */
-ParseErrorCode parseEitEventInfo(const uint8_t* eitEventInfoBuffer, EitEventInfo* eitEventInfo);
+ParseErrorCode decodeDescriptor(const DescriptorView* descriptorView, Descriptor* descriptor);
 
 /**
- * @brief Parse EIT table
+ * @brief Decodes first descriptor with tag in descriptor loop
  *
- * @param [in]  eitSectionBuffer Buffer that contains eit table section
- * @param [out] eitTable EIT table
- * @return tables error code
+ * @param [in] descriptors Descriptor loop
+ * @param [in] descriptorsLength Length of descriptor loop
+ * @param [in] tag Descriptor tag
+ * @param [out] descriptor Decoded descriptor
+ * @return tables error code, error if loop has no valid descriptor with tag
  */
-ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable);
+ParseErrorCode parseDescriptor(const uint8_t* descriptors, uint16_t descriptorsLength, uint8_t tag, Descriptor* descriptor);
+
+/**
+ * @brief Starts iteration over ES descriptors of one elementary stream of PMT table
+ *
+ * @param [in] pmtTable PMT table
+ * @param [in] index Elementary stream index
+ * @param [out] iterator Descriptor loop iterator
+ */
+static inline void pmtEsDescriptorIteratorInit(const PmtTable* pmtTable, uint8_t index, SectionLoopIterator* iterator)
+{
+    descriptorIteratorInit(iterator, &pmtTable->esDescriptors[pmtTable->pmtElementaryInfoArray[index].esDescriptorsOffset],
+                           pmtTable->pmtElementaryInfoArray[index].esInfoLength);
+}
+
+/**
+ * @brief Checks whether elementary stream of PMT table is teletext, private PES carries teletext only with teletext_descriptor
+ *
+ * @param [in] pmtTable PMT table
+ * @param [in] index Elementary stream index
+ * @return true if stream is teletext
+ */
+static inline bool pmtEsIsTeletext(const PmtTable* pmtTable, uint8_t index)
+{
+    SectionLoopIterator iterator;
+    DescriptorView descriptorView;
+
+    if (pmtTable->pmtElementaryInfoArray[index].streamType != 0x06)
+    {
+        return false;
+    }
+    pmtEsDescriptorIteratorInit(pmtTable, index, &iterator);
+
+    return findDescriptor(&iterator, DESCRIPTOR_TELETEXT, &descriptorView);
+}
 
 #endif /* __TABLES_H__ */
 
@@ -0,0 +1,70 @@
+#ifndef __TDP_API_H__
+#define __TDP_API_H__
+
+/*
+ * TS file backed stand-in for the tdp_api used by this project.
+ *
+ * Only the functions and types used by the player are provided. Transport
+ * stream is read from the file given in TDP_SIM_TS_FILE environment variable,
+ * see tdp_sim.c for the other TDP_SIM_* settings.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define NO_ERROR    0
+#define ERROR       1
+
+/**
+ * @brief Enumeration of tuner lock status
+ */
+typedef enum _t_LockStatus
+{
+    STATUS_ERROR = 0,
+    STATUS_LOCKED
+}t_LockStatus;
+
+/**
+ * @brief Enumeration of tuner modules
+ */
+typedef enum _t_Module
+{
+    DVB_T = 0,
+    DVB_T2
+}t_Module;
+
+/**
+ * @brief Enumeration of player stream types
+ */
+typedef enum _tStreamType
+{
+    VIDEO_TYPE_H264 = 1,
+    VIDEO_TYPE_MPEG2,
+    AUDIO_TYPE_MPEG_AUDIO,
+    AUDIO_TYPE_DOLBY_AC3
+}tStreamType;
+
+typedef int32_t(*Tuner_Status_Callback)(t_LockStatus status);
+typedef int32_t(*Demux_Section_Filter_Callback)(uint8_t* buffer);
+
+int32_t Tuner_Init();
+int32_t Tuner_Deinit();
+int32_t Tuner_Lock_To_Frequency(uint32_t tuneFrequency, uint32_t bandwidth, t_Module module);
+int32_t Tuner_Register_Status_Callback(Tuner_Status_Callback tunerStatusCallback);
+int32_t Tuner_Unregister_Status_Callback(Tuner_Status_Callback tunerStatusCallback);
+
+int32_t Player_Init(uint32_t* playerHandle);
+int32_t Player_Deinit(uint32_t playerHandle);
+int32_t Player_Source_Open(uint32_t playerHandle, uint32_t* sourceHandle);
+int32_t Player_Source_Close(uint32_t playerHandle, uint32_t sourceHandle);
+int32_t Player_Stream_Create(uint32_t playerHandle, uint32_t sourceHandle, uint32_t PID, tStreamType streamType, uint32_t* streamHandle);
+int32_t Player_Stream_Remove(uint32_t playerHandle, uint32_t sourceHandle, uint32_t streamHandle);
+int32_t Player_Volume_Set(uint32_t playerHandle, uint32_t volume);
+int32_t Player_Volume_Get(uint32_t playerHandle, uint32_t* volume);
+
+int32_t Demux_Set_Filter(uint32_t playerHandle, uint32_t PID, uint32_t tableID, uint32_t* filterHandle);
+int32_t Demux_Free_Filter(uint32_t playerHandle, uint32_t filterHandle);
+int32_t Demux_Register_Section_Filter_Callback(Demux_Section_Filter_Callback demuxSectionFilterCallback);
+int32_t Demux_Unregister_Section_Filter_Callback(Demux_Section_Filter_Callback demuxSectionFilterCallback);
+
+#endif /* __TDP_API_H__ */
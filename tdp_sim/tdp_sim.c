@@ -0,0 +1,356 @@
+#include "tdp_api.h"
+#include "../ts_demux.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+/*
+ * Settings are read from environment when tuner locks:
+ *  TDP_SIM_TS_FILE       - transport stream file, required
+ *  TDP_SIM_SPEED         - playback speed factor, 1 is real time (default),
+ *                          0 feeds the file as fast as possible
+ *  TDP_SIM_LOOP          - 0 stops at end of file, otherwise file is replayed (default)
+ *  TDP_SIM_LOCK_DELAY_MS - delay before tuner lock is reported (default 100)
+ *  TDP_SIM_MAX_FILTERS   - number of section filters set at the same time,
+ *                          1 behaves like a demux with a single section filter,
+ *                          0 is unlimited (default)
+ */
+
+#define SIM_READ_PACKETS        64          /* Packets read from file at once */
+#define SIM_DEFAULT_LOCK_DELAY  100         /* Default tuner lock delay in ms */
+#define SIM_PCR_CLOCK           27000000ULL /* PCR clock frequency */
+#define SIM_PLAYER_HANDLE       1
+#define SIM_SOURCE_HANDLE       1
+
+static TsDemux demux;
+static pthread_mutex_t demuxMutex;
+static pthread_t feedThread;
+static bool feedRunning = false;
+static bool feedExit = false;
+
+static Tuner_Status_Callback statusCallback = NULL;
+static Demux_Section_Filter_Callback sectionCallback = NULL;
+
+static FILE* tsFile = NULL;
+static double speed = 1.0;
+static bool loop = true;
+static uint32_t lockDelay = SIM_DEFAULT_LOCK_DELAY;
+static uint32_t maxFilters = 0;
+static uint32_t filterCount = 0;
+
+static uint32_t streamCount = 0;
+static uint32_t volumeLevel = 0;
+
+static void* feedTask();
+static int32_t demuxSectionCallback(uint8_t* buffer);
+static void pacePacket(const uint8_t* packet, struct timespec* startTime, uint64_t* firstPcr);
+static void sleepUntil(const struct timespec* startTime, uint64_t offsetNs);
+
+int32_t Tuner_Init()
+{
+    pthread_mutexattr_t mutexAttr;
+
+    /* recursive, section callback is allowed to change filters */
+    pthread_mutexattr_init(&mutexAttr);
+    pthread_mutexattr_settype(&mutexAttr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&demuxMutex, &mutexAttr);
+    pthread_mutexattr_destroy(&mutexAttr);
+
+    tsDemuxInit(&demux);
+    tsDemuxRegisterSectionCallback(&demux, demuxSectionCallback);
+
+    return NO_ERROR;
+}
+
+int32_t Tuner_Deinit()
+{
+    if (feedRunning)
+    {
+        feedExit = true;
+        pthread_join(feedThread, NULL);
+        feedRunning = false;
+    }
+
+    if (tsFile != NULL)
+    {
+        fclose(tsFile);
+        tsFile = NULL;
+    }
+
+    tsDemuxDeinit(&demux);
+    pthread_mutex_destroy(&demuxMutex);
+
+    return NO_ERROR;
+}
+
+int32_t Tuner_Lock_To_Frequency(uint32_t tuneFrequency, uint32_t bandwidth, t_Module module)
+{
+    const char* fileName = getenv("TDP_SIM_TS_FILE");
+    const char* value;
+
+    if (fileName == NULL)
+    {
+        printf("\n%s : ERROR TDP_SIM_TS_FILE is not set\n", __FUNCTION__);
+        return ERROR;
+    }
+
+    if ((value = getenv("TDP_SIM_SPEED")) != NULL)
+    {
+        speed = atof(value);
+    }
+    if ((value = getenv("TDP_SIM_LOOP")) != NULL)
+    {
+        loop = atoi(value) != 0;
+    }
+    if ((value = getenv("TDP_SIM_LOCK_DELAY_MS")) != NULL)
+    {
+        lockDelay = atoi(value);
+    }
+    if ((value = getenv("TDP_SIM_MAX_FILTERS")) != NULL)
+    {
+        maxFilters = atoi(value);
+    }
+
+    tsFile = fopen(fileName, "rb");
+    if (tsFile == NULL)
+    {
+        printf("\n%s : ERROR Cannot open %s (%s)\n", __FUNCTION__, fileName, strerror(errno));
+        return ERROR;
+    }
+
+    printf("\n%s : INFO %u Hz, %u MHz, module %d is served from %s\n", __FUNCTION__, tuneFrequency, bandwidth, module, fileName);
+
+    feedExit = false;
+    if (pthread_create(&feedThread, NULL, &feedTask, NULL))
+    {
+        printf("\n%s : ERROR Cannot create feed thread\n", __FUNCTION__);
+        fclose(tsFile);
+        tsFile = NULL;
+        return ERROR;
+    }
+    feedRunning = true;
+
+    return NO_ERROR;
+}
+
+int32_t Tuner_Register_Status_Callback(Tuner_Status_Callback tunerStatusCallback)
+{
+    statusCallback = tunerStatusCallback;
+    return NO_ERROR;
+}
+
+int32_t Tuner_Unregister_Status_Callback(Tuner_Status_Callback tunerStatusCallback)
+{
+    statusCallback = NULL;
+    return NO_ERROR;
+}
+
+int32_t Player_Init(uint32_t* playerHandle)
+{
+    *playerHandle = SIM_PLAYER_HANDLE;
+    return NO_ERROR;
+}
+
+int32_t Player_Deinit(uint32_t playerHandle)
+{
+    return NO_ERROR;
+}
+
+int32_t Player_Source_Open(uint32_t playerHandle, uint32_t* sourceHandle)
+{
+    *sourceHandle = SIM_SOURCE_HANDLE;
+    return NO_ERROR;
+}
+
+int32_t Player_Source_Close(uint32_t playerHandle, uint32_t sourceHandle)
+{
+    return NO_ERROR;
+}
+
+int32_t Player_Stream_Create(uint32_t playerHandle, uint32_t sourceHandle, uint32_t PID, tStreamType streamType, uint32_t* streamHandle)
+{
+    /* there is no decoder, stream is only accounted */
+    *streamHandle = ++streamCount;
+    printf("\n%s : INFO stream %u created, PID %u, type %d\n", __FUNCTION__, *streamHandle, PID, streamType);
+    return NO_ERROR;
+}
+
+int32_t Player_Stream_Remove(uint32_t playerHandle, uint32_t sourceHandle, uint32_t streamHandle)
+{
+    return NO_ERROR;
+}
+
+int32_t Player_Volume_Set(uint32_t playerHandle, uint32_t volume)
+{
+    volumeLevel = volume;
+    return NO_ERROR;
+}
+
+int32_t Player_Volume_Get(uint32_t playerHandle, uint32_t* volume)
+{
+    *volume = volumeLevel;
+    return NO_ERROR;
+}
+
+int32_t Demux_Set_Filter(uint32_t playerHandle, uint32_t PID, uint32_t tableID, uint32_t* filterHandle)
+{
+    TsDemuxError error;
+
+    pthread_mutex_lock(&demuxMutex);
+    if (maxFilters != 0 && filterCount == maxFilters)
+    {
+        pthread_mutex_unlock(&demuxMutex);
+        return ERROR;
+    }
+    error = tsDemuxAddFilter(&demux, (uint16_t)PID, (uint8_t)tableID);
+    if (error == TS_DEMUX_NO_ERROR)
+    {
+        filterCount++;
+    }
+    pthread_mutex_unlock(&demuxMutex);
+
+    if (error != TS_DEMUX_NO_ERROR)
+    {
+        return ERROR;
+    }
+
+    /* handle keeps PID and table id, 0 is never a valid handle */
+    *filterHandle = ((PID << 8) | (tableID & 0xFF)) + 1;
+
+    return NO_ERROR;
+}
+
+int32_t Demux_Free_Filter(uint32_t playerHandle, uint32_t filterHandle)
+{
+    TsDemuxError error;
+
+    if (filterHandle == 0)
+    {
+        return ERROR;
+    }
+    filterHandle--;
+
+    pthread_mutex_lock(&demuxMutex);
+    error = tsDemuxRemoveFilter(&demux, (uint16_t)(filterHandle >> 8), (uint8_t)(filterHandle & 0xFF));
+    if (error == TS_DEMUX_NO_ERROR)
+    {
+        filterCount--;
+    }
+    pthread_mutex_unlock(&demuxMutex);
+
+    return error == TS_DEMUX_NO_ERROR ? NO_ERROR : ERROR;
+}
+
+int32_t Demux_Register_Section_Filter_Callback(Demux_Section_Filter_Callback demuxSectionFilterCallback)
+{
+    sectionCallback = demuxSectionFilterCallback;
+    return NO_ERROR;
+}
+
+int32_t Demux_Unregister_Section_Filter_Callback(Demux_Section_Filter_Callback demuxSectionFilterCallback)
+{
+    sectionCallback = NULL;
+    return NO_ERROR;
+}
+
+int32_t demuxSectionCallback(uint8_t* buffer)
+{
+    if (sectionCallback != NULL)
+    {
+        return sectionCallback(buffer);
+    }
+    return 0;
+}
+
+/* Reports tuner lock, then reads TS file and feeds it to demux paced by PCR */
+void* feedTask()
+{
+    uint8_t packets[SIM_READ_PACKETS * TS_PACKET_SIZE];
+    size_t length;
+    size_t i;
+    struct timespec startTime;
+    uint64_t firstPcr = UINT64_MAX;
+    struct timespec lockTime;
+
+    lockTime.tv_sec = lockDelay / 1000;
+    lockTime.tv_nsec = (lockDelay % 1000) * 1000000;
+    nanosleep(&lockTime, NULL);
+
+    if (statusCallback != NULL)
+    {
+        statusCallback(STATUS_LOCKED);
+    }
+
+    while (!feedExit)
+    {
+        length = fread(packets, 1, sizeof(packets), tsFile);
+        if (length == 0)
+        {
+            if (!loop)
+            {
+                break;
+            }
+            /* replay from start, pacing restarts with first PCR */
+            rewind(tsFile);
+            firstPcr = UINT64_MAX;
+            continue;
+        }
+
+        for (i = 0; i + TS_PACKET_SIZE <= length; i += TS_PACKET_SIZE)
+        {
+            if (speed > 0)
+            {
+                pacePacket(packets + i, &startTime, &firstPcr);
+            }
+
+            pthread_mutex_lock(&demuxMutex);
+            tsDemuxFeed(&demux, packets + i, TS_PACKET_SIZE);
+            pthread_mutex_unlock(&demuxMutex);
+        }
+    }
+
+    return NULL;
+}
+
+/* Sleeps until wall clock reaches PCR of packet scaled by speed */
+void pacePacket(const uint8_t* packet, struct timespec* startTime, uint64_t* firstPcr)
+{
+    uint64_t pcr;
+
+    /* adaptation field with PCR flag */
+    if (packet[0] != TS_SYNC_BYTE || !(packet[3] & 0x20) || packet[4] < 7 || !(packet[5] & 0x10))
+    {
+        return;
+    }
+
+    pcr = ((uint64_t)packet[6] << 25) | ((uint64_t)packet[7] << 17) | ((uint64_t)packet[8] << 9) | ((uint64_t)packet[9] << 1) | (packet[10] >> 7);
+    pcr = pcr * 300 + (((packet[10] & 0x01) << 8) | packet[11]);
+
+    if (*firstPcr == UINT64_MAX || pcr < *firstPcr)
+    {
+        /* first PCR or PCR wrap around */
+        *firstPcr = pcr;
+        clock_gettime(CLOCK_MONOTONIC, startTime);
+        return;
+    }
+
+    sleepUntil(startTime, (uint64_t)((pcr - *firstPcr) * (1000000000.0 / SIM_PCR_CLOCK) / speed));
+}
+
+void sleepUntil(const struct timespec* startTime, uint64_t offsetNs)
+{
+    struct timespec wakeTime;
+
+    wakeTime.tv_sec = startTime->tv_sec + offsetNs / 1000000000ULL;
+    wakeTime.tv_nsec = startTime->tv_nsec + offsetNs % 1000000000ULL;
+    if (wakeTime.tv_nsec >= 1000000000L)
+    {
+        wakeTime.tv_sec++;
+        wakeTime.tv_nsec -= 1000000000L;
+    }
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL);
+}
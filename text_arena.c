@@ -0,0 +1,210 @@
+#include "text_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t hashText(const char* text, uint32_t length);
+static uint32_t* findSlot(const TextArena* arena, const char* text, uint32_t length);
+static bool reserveTexts(TextArena* arena, uint32_t length);
+static bool growSlots(TextArena* arena);
+
+TextArenaError textArenaInit(TextArena* arena)
+{
+    if (arena == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TEXT_ARENA_ERROR;
+    }
+
+    memset(arena, 0x0, sizeof(TextArena));
+
+    return TEXT_ARENA_NO_ERROR;
+}
+
+TextArenaError textArenaDeinit(TextArena* arena)
+{
+    if (arena == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TEXT_ARENA_ERROR;
+    }
+
+    free(arena->texts);
+    free(arena->slots);
+    memset(arena, 0x0, sizeof(TextArena));
+
+    return TEXT_ARENA_NO_ERROR;
+}
+
+void textArenaReset(TextArena* arena)
+{
+    if (arena->texts == NULL)
+    {
+        return;
+    }
+
+    arena->length = 1;
+    arena->usedSlots = 0;
+    memset(arena->slots, 0x0, arena->slotCount * sizeof(uint32_t));
+}
+
+void textArenaTrim(TextArena* arena)
+{
+    char* texts;
+
+    if (arena->texts == NULL || arena->length == arena->capacity)
+    {
+        return;
+    }
+
+    texts = (char*)realloc(arena->texts, arena->length);
+    if (texts != NULL)
+    {
+        arena->texts = texts;
+        arena->capacity = arena->length;
+    }
+}
+
+TextArenaError textArenaIntern(TextArena* arena, const char* text, uint32_t length, uint32_t* offset)
+{
+    uint32_t* slot;
+
+    if (length == 0)
+    {
+        *offset = TEXT_ARENA_EMPTY;
+        return TEXT_ARENA_NO_ERROR;
+    }
+
+    /* keep load factor at most one half */
+    if ((arena->usedSlots + 1) * 2 > arena->slotCount && !growSlots(arena))
+    {
+        return TEXT_ARENA_ERROR;
+    }
+
+    slot = findSlot(arena, text, length);
+    if (*slot != TEXT_ARENA_EMPTY)
+    {
+        *offset = *slot;
+        return TEXT_ARENA_NO_ERROR;
+    }
+
+    if (!reserveTexts(arena, length + 1))
+    {
+        return TEXT_ARENA_ERROR;
+    }
+
+    memcpy(&arena->texts[arena->length], text, length);
+    arena->texts[arena->length + length] = '\0';
+    *slot = arena->length;
+    *offset = arena->length;
+    arena->length += length + 1;
+    arena->usedSlots++;
+
+    return TEXT_ARENA_NO_ERROR;
+}
+
+uint32_t textArenaMemory(const TextArena* arena)
+{
+    return arena->capacity + arena->slotCount * sizeof(uint32_t);
+}
+
+/* FNV-1a */
+uint32_t hashText(const char* text, uint32_t length)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/* Returns slot of equal stored text or free slot where text belongs, linear probing */
+uint32_t* findSlot(const TextArena* arena, const char* text, uint32_t length)
+{
+    uint32_t mask = arena->slotCount - 1;
+    uint32_t index = hashText(text, length) & mask;
+    const char* stored;
+
+    while (arena->slots[index] != TEXT_ARENA_EMPTY)
+    {
+        /* strncmp stops at the end of a shorter stored text, terminator is read only after a full match */
+        stored = &arena->texts[arena->slots[index]];
+        if (strncmp(stored, text, length) == 0 && stored[length] == '\0')
+        {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return &arena->slots[index];
+}
+
+bool reserveTexts(TextArena* arena, uint32_t length)
+{
+    uint32_t capacity = arena->capacity ? arena->capacity : TEXT_ARENA_INITIAL_SIZE;
+    char* texts;
+
+    while (arena->length + length > capacity)
+    {
+        capacity *= 2;
+    }
+    if (capacity != arena->capacity)
+    {
+        texts = (char*)realloc(arena->texts, capacity);
+        if (texts == NULL)
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            return false;
+        }
+        arena->texts = texts;
+        arena->capacity = capacity;
+    }
+
+    return true;
+}
+
+/* Doubles hash table, first call also allocates texts with the empty text */
+bool growSlots(TextArena* arena)
+{
+    uint32_t slotCount = arena->slotCount ? arena->slotCount * 2 : TEXT_ARENA_INITIAL_SLOTS;
+    uint32_t* oldSlots = arena->slots;
+    uint32_t oldCount = arena->slotCount;
+    uint32_t* slot;
+    const char* stored;
+    uint32_t i;
+
+    if (arena->texts == NULL)
+    {
+        if (!reserveTexts(arena, 1))
+        {
+            return false;
+        }
+        arena->texts[0] = '\0';
+        arena->length = 1;
+    }
+
+    arena->slots = (uint32_t*)calloc(slotCount, sizeof(uint32_t));
+    if (arena->slots == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        arena->slots = oldSlots;
+        return false;
+    }
+    arena->slotCount = slotCount;
+
+    for (i = 0; i < oldCount; i++)
+    {
+        if (oldSlots[i] != TEXT_ARENA_EMPTY)
+        {
+            stored = &arena->texts[oldSlots[i]];
+            slot = findSlot(arena, stored, strlen(stored));
+            *slot = oldSlots[i];
+        }
+    }
+    free(oldSlots);
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef __TEXT_ARENA_H__
+#define __TEXT_ARENA_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEXT_ARENA_EMPTY            0           /* Offset of empty text, valid in every arena */
+#define TEXT_ARENA_INITIAL_SIZE     1024        /* Text bytes allocated on first intern */
+#define TEXT_ARENA_INITIAL_SLOTS    64          /* Hash slots allocated on first intern */
+
+/*
+ * Append-only buffer of zero terminated texts with interning.
+ *
+ * Texts are referenced by 32 bit offsets, which stay valid when the
+ * buffer grows. Equal texts are stored once, a hash table of offsets
+ * finds the stored copy. Texts are never freed one by one, the whole
+ * arena is reset when all texts referencing it are gone.
+ */
+
+/**
+ * @brief Enumeration of possible text arena error codes
+ */
+typedef enum _TextArenaError
+{
+    TEXT_ARENA_NO_ERROR = 0,
+    TEXT_ARENA_ERROR
+}TextArenaError;
+
+/**
+ * @brief Structure that defines text arena
+ */
+typedef struct _TextArena
+{
+    char* texts;                                /* Starts with the empty text */
+    uint32_t length;
+    uint32_t capacity;
+    uint32_t* slots;                            /* Offsets of stored texts, TEXT_ARENA_EMPTY is a free slot */
+    uint32_t slotCount;                         /* Power of two */
+    uint32_t usedSlots;
+}TextArena;
+
+/**
+ * @brief Initializes empty arena, nothing is allocated until first intern
+ *
+ * @param [out] arena - text arena
+ * @return text arena error code
+ */
+TextArenaError textArenaInit(TextArena* arena);
+
+/**
+ * @brief Frees all texts of arena
+ *
+ * @param [in] arena - text arena
+ * @return text arena error code
+ */
+TextArenaError textArenaDeinit(TextArena* arena);
+
+/**
+ * @brief Drops all texts, allocated memory is kept for new texts
+ *
+ * @param [in] arena - text arena
+ */
+void textArenaReset(TextArena* arena);
+
+/**
+ * @brief Frees text bytes allocated beyond stored texts
+ *
+ * @param [in] arena - text arena
+ */
+void textArenaTrim(TextArena* arena);
+
+/**
+ * @brief Stores text unless an equal text is stored already
+ *
+ * @param [in] arena - text arena
+ * @param [in] text - text, does not need to be zero terminated
+ * @param [in] length - text length without terminating zero
+ * @param [out] offset - offset of stored text
+ * @return text arena error code
+ */
+TextArenaError textArenaIntern(TextArena* arena, const char* text, uint32_t length, uint32_t* offset);
+
+/**
+ * @brief Returns bytes allocated by arena
+ *
+ * @param [in] arena - text arena
+ * @return allocated bytes
+ */
+uint32_t textArenaMemory(const TextArena* arena);
+
+/**
+ * @brief Returns stored text, pointer is valid until next intern or reset
+ *
+ * @param [in] arena - text arena
+ * @param [in] offset - offset returned by textArenaIntern
+ * @return zero terminated text
+ */
+static inline const char* textArenaGet(const TextArena* arena, uint32_t offset)
+{
+    return offset == TEXT_ARENA_EMPTY ? "" : &arena->texts[offset];
+}
+
+#endif /* __TEXT_ARENA_H__ */
@@ -0,0 +1,433 @@
+#include "ts_demux.h"
+#include <stdlib.h>
+
+static void processPacket(TsDemux* demux, const uint8_t* packet);
+static uint16_t appendSection(TsDemux* demux, TsSectionAssembler* assembler, const uint8_t* data, uint16_t length);
+static inline bool isPidFiltered(const TsDemux* demux, uint16_t pid);
+
+TsDemuxError tsDemuxInit(TsDemux* demux)
+{
+    if (demux == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    memset(demux, 0x0, sizeof(TsDemux));
+    memset(demux->pidAssembler, TS_DEMUX_NO_ASSEMBLER, sizeof(demux->pidAssembler));
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxDeinit(TsDemux* demux)
+{
+    uint8_t i;
+
+    if (demux == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    for (i = 0; i < TS_DEMUX_MAX_PIDS; i++)
+    {
+        free(demux->assemblers[i]);
+        demux->assemblers[i] = NULL;
+    }
+    memset(demux->pidBitmap, 0x0, sizeof(demux->pidBitmap));
+    memset(demux->pidAssembler, TS_DEMUX_NO_ASSEMBLER, sizeof(demux->pidAssembler));
+    demux->callback = NULL;
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxRegisterSectionCallback(TsDemux* demux, TsDemuxSectionCallback callback)
+{
+    if (demux == NULL || callback == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    demux->callback = callback;
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxAddFilter(TsDemux* demux, uint16_t pid, uint8_t tableId)
+{
+    uint8_t i;
+    TsSectionAssembler* assembler;
+
+    if (demux == NULL || pid >= TS_MAX_PID)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    if (demux->pidAssembler[pid] == TS_DEMUX_NO_ASSEMBLER)
+    {
+        /* find free assembler slot */
+        for (i = 0; i < TS_DEMUX_MAX_PIDS; i++)
+        {
+            if (demux->assemblers[i] == NULL)
+            {
+                break;
+            }
+        }
+        if (i == TS_DEMUX_MAX_PIDS)
+        {
+            printf("\n%s : ERROR there is no free PID filter\n", __FUNCTION__);
+            return TS_DEMUX_ERROR;
+        }
+
+        assembler = (TsSectionAssembler*)malloc(sizeof(TsSectionAssembler));
+        if (assembler == NULL)
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            return TS_DEMUX_ERROR;
+        }
+        memset(assembler, 0x0, sizeof(TsSectionAssembler));
+        assembler->pid = pid;
+        assembler->continuityCounter = 0xFF;
+
+        demux->assemblers[i] = assembler;
+        demux->pidAssembler[pid] = i;
+        demux->pidBitmap[pid >> 5] |= (uint32_t)1 << (pid & 0x1F);
+    }
+
+    assembler = demux->assemblers[demux->pidAssembler[pid]];
+    assembler->tableIdBitmap[tableId >> 3] |= (uint8_t)(1 << (tableId & 0x07));
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxRemoveFilter(TsDemux* demux, uint16_t pid, uint8_t tableId)
+{
+    uint8_t i;
+    uint8_t index;
+    TsSectionAssembler* assembler;
+
+    if (demux == NULL || pid >= TS_MAX_PID || demux->pidAssembler[pid] == TS_DEMUX_NO_ASSEMBLER)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    index = demux->pidAssembler[pid];
+    assembler = demux->assemblers[index];
+    assembler->tableIdBitmap[tableId >> 3] &= (uint8_t)~(1 << (tableId & 0x07));
+
+    /* release PID when no table id is left */
+    for (i = 0; i < sizeof(assembler->tableIdBitmap); i++)
+    {
+        if (assembler->tableIdBitmap[i])
+        {
+            return TS_DEMUX_NO_ERROR;
+        }
+    }
+
+    demux->pidBitmap[pid >> 5] &= ~((uint32_t)1 << (pid & 0x1F));
+    demux->pidAssembler[pid] = TS_DEMUX_NO_ASSEMBLER;
+    demux->assemblers[index] = NULL;
+    free(assembler);
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxFeed(TsDemux* demux, const uint8_t* data, uint32_t length)
+{
+    uint32_t chunk;
+
+    if (demux == NULL || data == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    /* complete packet left from last feed, it starts with a sync byte */
+    while (demux->pendingLength > 0)
+    {
+        chunk = TS_PACKET_SIZE - demux->pendingLength;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        memcpy(demux->pending + demux->pendingLength, data, chunk);
+        demux->pendingLength += chunk;
+        data += chunk;
+        length -= chunk;
+
+        /* while resynchronizing, first byte of the next packet has to confirm it */
+        if (demux->pendingLength < TS_PACKET_SIZE || (!demux->synced && length == 0))
+        {
+            return TS_DEMUX_NO_ERROR;
+        }
+        if (demux->synced || *data == TS_SYNC_BYTE)
+        {
+            demux->synced = true;
+            processPacket(demux, demux->pending);
+            demux->pendingLength = 0;
+        }
+        else
+        {
+            /* false sync byte in payload, search goes on behind it */
+            chunk = 1;
+            while (chunk < TS_PACKET_SIZE && demux->pending[chunk] != TS_SYNC_BYTE)
+            {
+                chunk++;
+            }
+            demux->stats.syncErrors += chunk;
+            memmove(demux->pending, demux->pending + chunk, TS_PACKET_SIZE - chunk);
+            demux->pendingLength -= chunk;
+        }
+    }
+
+    while (length >= TS_PACKET_SIZE)
+    {
+        if (*data != TS_SYNC_BYTE)
+        {
+            /* resynchronize byte by byte */
+            demux->synced = false;
+            demux->stats.syncErrors++;
+            data++;
+            length--;
+            continue;
+        }
+
+        /* payload byte that equals sync byte is not taken for packet start */
+        if (!demux->synced)
+        {
+            if (length == TS_PACKET_SIZE)
+            {
+                break;
+            }
+            if (data[TS_PACKET_SIZE] != TS_SYNC_BYTE)
+            {
+                demux->stats.syncErrors++;
+                data++;
+                length--;
+                continue;
+            }
+            demux->synced = true;
+        }
+
+        processPacket(demux, data);
+        data += TS_PACKET_SIZE;
+        length -= TS_PACKET_SIZE;
+    }
+
+    /* keep partial packet for next feed, bytes before its sync byte are skipped */
+    while (length > 0 && *data != TS_SYNC_BYTE)
+    {
+        demux->synced = false;
+        demux->stats.syncErrors++;
+        data++;
+        length--;
+    }
+    if (length > 0)
+    {
+        memcpy(demux->pending, data, length);
+        demux->pendingLength = length;
+    }
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+TsDemuxError tsDemuxGetStats(TsDemux* demux, TsDemuxStats* stats)
+{
+    if (demux == NULL || stats == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_DEMUX_ERROR;
+    }
+
+    *stats = demux->stats;
+
+    return TS_DEMUX_NO_ERROR;
+}
+
+bool isPidFiltered(const TsDemux* demux, uint16_t pid)
+{
+    return (demux->pidBitmap[pid >> 5] >> (pid & 0x1F)) & 0x1;
+}
+
+/* Parses TS packet header, checks continuity and feeds payload to section assembler of the PID */
+void processPacket(TsDemux* demux, const uint8_t* packet)
+{
+    uint16_t pid;
+    uint8_t adaptationFieldControl;
+    uint8_t continuityCounter;
+    uint8_t pointerField;
+    bool payloadUnitStart;
+    const uint8_t* payload;
+    uint16_t payloadLength;
+    uint16_t consumed;
+    TsSectionAssembler* assembler;
+
+    demux->stats.packets++;
+
+    pid = (uint16_t)(((packet[1] & 0x1F) << 8) | packet[2]);
+    if (!isPidFiltered(demux, pid))
+    {
+        return;
+    }
+    demux->stats.filteredPackets++;
+
+    assembler = demux->assemblers[demux->pidAssembler[pid]];
+
+    /* transport error indicator or scrambled payload */
+    if ((packet[1] & 0x80) || (packet[3] & 0xC0))
+    {
+        assembler->collecting = false;
+        return;
+    }
+
+    payloadUnitStart = (packet[1] & 0x40) != 0;
+    adaptationFieldControl = (packet[3] >> 4) & 0x03;
+    continuityCounter = packet[3] & 0x0F;
+
+    /* packet without payload, continuity counter is not incremented */
+    if (!(adaptationFieldControl & 0x01))
+    {
+        return;
+    }
+
+    if (assembler->continuityCounter != 0xFF)
+    {
+        if (continuityCounter == assembler->continuityCounter)
+        {
+            /* duplicate packet */
+            return;
+        }
+        if (continuityCounter != ((assembler->continuityCounter + 1) & 0x0F))
+        {
+            demux->stats.continuityErrors++;
+            if (assembler->collecting)
+            {
+                assembler->collecting = false;
+                demux->stats.droppedSections++;
+            }
+        }
+    }
+    assembler->continuityCounter = continuityCounter;
+
+    payload = packet + 4;
+    payloadLength = TS_PACKET_SIZE - 4;
+    if (adaptationFieldControl & 0x02)
+    {
+        if (*payload >= payloadLength)
+        {
+            return;
+        }
+        payloadLength -= *payload + 1;
+        payload += *payload + 1;
+    }
+
+    if (!payloadUnitStart)
+    {
+        if (assembler->collecting)
+        {
+            appendSection(demux, assembler, payload, payloadLength);
+        }
+        return;
+    }
+
+    pointerField = *payload;
+    payload++;
+    payloadLength--;
+    if (pointerField > payloadLength)
+    {
+        assembler->collecting = false;
+        demux->stats.droppedSections++;
+        return;
+    }
+
+    /* bytes before pointer field end the previous section */
+    if (assembler->collecting)
+    {
+        appendSection(demux, assembler, payload, pointerField);
+        if (assembler->collecting)
+        {
+            assembler->collecting = false;
+            demux->stats.droppedSections++;
+        }
+    }
+    payload += pointerField;
+    payloadLength -= pointerField;
+
+    /* one packet can start several sections, 0xFF table id is stuffing */
+    while (payloadLength > 0 && *payload != 0xFF)
+    {
+        assembler->collecting = true;
+        assembler->length = 0;
+        assembler->expectedLength = 0;
+
+        consumed = appendSection(demux, assembler, payload, payloadLength);
+        payload += consumed;
+        payloadLength -= consumed;
+
+        if (assembler->collecting)
+        {
+            /* section continues in next packet */
+            break;
+        }
+    }
+}
+
+/* Appends section bytes, dispatches section when it is complete, returns number of consumed bytes */
+uint16_t appendSection(TsDemux* demux, TsSectionAssembler* assembler, const uint8_t* data, uint16_t length)
+{
+    uint16_t consumed = 0;
+    uint16_t chunk;
+
+    /* collect table_id and section_length first */
+    if (assembler->length < 3)
+    {
+        chunk = 3 - assembler->length;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        memcpy(assembler->buffer + assembler->length, data, chunk);
+        assembler->length += chunk;
+        consumed += chunk;
+
+        if (assembler->length < 3)
+        {
+            return consumed;
+        }
+
+        assembler->expectedLength = 3 + (((assembler->buffer[1] & 0x0F) << 8) | assembler->buffer[2]);
+        if (assembler->expectedLength > TS_MAX_SECTION_SIZE)
+        {
+            assembler->collecting = false;
+            demux->stats.droppedSections++;
+            return length;
+        }
+    }
+
+    chunk = assembler->expectedLength - assembler->length;
+    if (chunk > length - consumed)
+    {
+        chunk = length - consumed;
+    }
+    memcpy(assembler->buffer + assembler->length, data + consumed, chunk);
+    assembler->length += chunk;
+    consumed += chunk;
+
+    if (assembler->length == assembler->expectedLength)
+    {
+        assembler->collecting = false;
+        if ((assembler->tableIdBitmap[assembler->buffer[0] >> 3] >> (assembler->buffer[0] & 0x07)) & 0x1)
+        {
+            demux->stats.sections++;
+            if (demux->callback != NULL)
+            {
+                demux->callback(assembler->buffer);
+            }
+        }
+    }
+
+    return consumed;
+}
@@ -0,0 +1,138 @@
+#ifndef __TS_DEMUX_H__
+#define __TS_DEMUX_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TS_PACKET_SIZE          188         /* Size of one transport stream packet */
+#define TS_SYNC_BYTE            0x47        /* First byte of every transport stream packet */
+#define TS_MAX_PID              8192        /* Number of possible PID values */
+#define TS_MAX_SECTION_SIZE     4096        /* Max size of private section including 3 byte header */
+#define TS_DEMUX_MAX_PIDS       32          /* Max number of PIDs filtered at the same time */
+#define TS_DEMUX_NO_ASSEMBLER   0xFF        /* PID has no section assembler */
+
+/**
+ * @brief Enumeration of possible ts demux error codes
+ */
+typedef enum _TsDemuxError
+{
+    TS_DEMUX_NO_ERROR = 0,
+    TS_DEMUX_ERROR
+}TsDemuxError;
+
+/**
+ * @brief Section callback, same contract as tdp_api section filter callback
+ */
+typedef int32_t(*TsDemuxSectionCallback)(uint8_t* buffer);
+
+/**
+ * @brief Structure that defines section reassembly state of one PID
+ */
+typedef struct _TsSectionAssembler
+{
+    uint16_t pid;                                   /* PID this assembler collects sections from */
+    uint8_t tableIdBitmap[32];                      /* Table ids that are dispatched to callback */
+    uint8_t continuityCounter;                      /* Last continuity counter, 0xFF when unknown */
+    bool collecting;                                /* Section is started and not completed */
+    uint16_t length;                                /* Number of section bytes collected */
+    uint16_t expectedLength;                        /* Total section size, known after 3 bytes */
+    uint8_t buffer[TS_MAX_SECTION_SIZE];            /* Section bytes */
+}TsSectionAssembler;
+
+/**
+ * @brief Structure that defines ts demux statistics
+ */
+typedef struct _TsDemuxStats
+{
+    uint32_t packets;                               /* Packets fed to demux */
+    uint32_t filteredPackets;                       /* Packets that passed PID filter */
+    uint32_t sections;                              /* Sections dispatched to callback */
+    uint32_t syncErrors;                            /* Bytes skipped while searching for sync byte */
+    uint32_t continuityErrors;                      /* Lost packets detected by continuity counter */
+    uint32_t droppedSections;                       /* Sections dropped because of errors */
+}TsDemuxStats;
+
+/**
+ * @brief Structure that defines ts demux
+ */
+typedef struct _TsDemux
+{
+    uint32_t pidBitmap[TS_MAX_PID / 32];                    /* Filtered PIDs */
+    uint8_t pidAssembler[TS_MAX_PID];                       /* Assembler index of filtered PID */
+    TsSectionAssembler* assemblers[TS_DEMUX_MAX_PIDS];      /* Assemblers, NULL when free */
+    TsDemuxSectionCallback callback;                        /* Complete section callback */
+    uint8_t pending[TS_PACKET_SIZE];                        /* Partial packet left from last feed */
+    uint16_t pendingLength;                                 /* Number of bytes in pending */
+    bool synced;                                            /* Sync bytes a packet apart were seen, cleared on sync loss */
+    TsDemuxStats stats;
+}TsDemux;
+
+/**
+ * @brief Initializes ts demux
+ *
+ * @param [out] demux - ts demux
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxInit(TsDemux* demux);
+
+/**
+ * @brief Deinitializes ts demux and frees all filters
+ *
+ * @param [in] demux - ts demux
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxDeinit(TsDemux* demux);
+
+/**
+ * @brief Registers callback called for every complete section
+ *
+ * @param [in] demux - ts demux
+ * @param [in] callback - section callback
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxRegisterSectionCallback(TsDemux* demux, TsDemuxSectionCallback callback);
+
+/**
+ * @brief Adds section filter
+ *
+ * @param [in] demux - ts demux
+ * @param [in] pid - PID of sections
+ * @param [in] tableId - table id of sections
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxAddFilter(TsDemux* demux, uint16_t pid, uint8_t tableId);
+
+/**
+ * @brief Removes section filter, PID is released when its last table id is removed
+ *
+ * @param [in] demux - ts demux
+ * @param [in] pid - PID of sections
+ * @param [in] tableId - table id of sections
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxRemoveFilter(TsDemux* demux, uint16_t pid, uint8_t tableId);
+
+/**
+ * @brief Feeds raw transport stream to demux
+ *
+ * Data does not have to be packet aligned, partial packet is kept until next feed.
+ *
+ * @param [in] demux - ts demux
+ * @param [in] data - transport stream bytes
+ * @param [in] length - number of bytes
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxFeed(TsDemux* demux, const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Returns ts demux statistics
+ *
+ * @param [in] demux - ts demux
+ * @param [out] stats - statistics
+ * @return ts demux error code
+ */
+TsDemuxError tsDemuxGetStats(TsDemux* demux, TsDemuxStats* stats);
+
+#endif /* __TS_DEMUX_H__ */
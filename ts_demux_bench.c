@@ -0,0 +1,220 @@
+#include "ts_demux.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * TS demultiplexer throughput benchmark. Builds a multiplex in which most
+ * packets are audio/video PIDs that are not filtered and every tenth packet
+ * carries EIT sections spanning several packets, PAT is repeated on PID 0.
+ * The multiplex is fed in aligned and in unaligned chunks, the second run
+ * also exercises the partial packet path.
+ *
+ * usage: ts_demux_bench [megabytes per run]
+ */
+
+#define BENCH_DEFAULT_MB        512
+#define BENCH_PACKETS           16000       /* Packets of multiplex, continuity counters of every PID wrap at its end */
+#define BENCH_EIT_PID           0x12
+#define BENCH_AV_PID            0x100
+#define BENCH_EIT_LENGTH        600         /* Bytes of one EIT section */
+#define BENCH_PAT_LENGTH        16          /* Bytes of one PAT section */
+#define BENCH_ALIGNED_CHUNK     (7 * TS_PACKET_SIZE)
+#define BENCH_UNALIGNED_CHUNK   1000
+#define BENCH_DVBT2_MBITS       50.3        /* Max bitrate of 8 MHz DVB-T2 multiplex */
+
+/**
+ * @brief Structure that defines packetized sections of one PID
+ */
+typedef struct _BenchSectionStream
+{
+    uint8_t packets[8][TS_PACKET_SIZE];
+    uint8_t packetCount;
+    uint8_t next;                           /* Next packet to put into multiplex */
+    uint8_t continuityCounter;
+}BenchSectionStream;
+
+static volatile uint32_t benchSections;     /* Sections received by callback */
+
+static int32_t sectionCallback(uint8_t* buffer);
+static void packSection(BenchSectionStream* stream, uint16_t pid, const uint8_t* section, uint16_t length);
+static void putPacket(uint8_t* packet, BenchSectionStream* stream);
+static double benchFeed(const uint8_t* data, uint32_t length, uint32_t chunk, uint64_t totalBytes, TsDemuxStats* stats);
+
+int main(int argc, char* argv[])
+{
+    uint64_t totalBytes = (uint64_t)(argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_MB) * 1024 * 1024;
+    BenchSectionStream eit;
+    BenchSectionStream pat;
+    uint8_t section[BENCH_EIT_LENGTH];
+    uint8_t avCounter = 0;
+    uint8_t* data;
+    uint8_t* packet;
+    TsDemuxStats alignedStats;
+    TsDemuxStats unalignedStats;
+    double alignedMbits;
+    double unalignedMbits;
+    uint32_t i;
+
+    if (totalBytes == 0)
+    {
+        printf("usage: ts_demux_bench [megabytes per run]\n");
+        return 1;
+    }
+
+    data = (uint8_t*)malloc(BENCH_PACKETS * TS_PACKET_SIZE);
+    if (data == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return 1;
+    }
+
+    /* EIT section over four packets, PAT section fits into one */
+    srand(1);
+    for (i = 0; i < BENCH_EIT_LENGTH; i++)
+    {
+        section[i] = (uint8_t)rand();
+    }
+    section[0] = 0x4E;
+    section[1] = 0xF0 | ((BENCH_EIT_LENGTH - 3) >> 8);
+    section[2] = (BENCH_EIT_LENGTH - 3) & 0xFF;
+    packSection(&eit, BENCH_EIT_PID, section, BENCH_EIT_LENGTH);
+    section[0] = 0x00;
+    section[1] = 0xB0;
+    section[2] = BENCH_PAT_LENGTH - 3;
+    packSection(&pat, 0x00, section, BENCH_PAT_LENGTH);
+
+    for (i = 0; i < BENCH_PACKETS; i++)
+    {
+        packet = &data[i * TS_PACKET_SIZE];
+        if (i % 10 == 0)
+        {
+            putPacket(packet, &eit);
+        }
+        else if (i % 100 == 5)
+        {
+            putPacket(packet, &pat);
+        }
+        else
+        {
+            memset(packet, 0xAB, TS_PACKET_SIZE);
+            packet[0] = TS_SYNC_BYTE;
+            packet[1] = BENCH_AV_PID >> 8;
+            packet[2] = BENCH_AV_PID & 0xFF;
+            packet[3] = 0x10 | (avCounter++ & 0x0F);
+        }
+    }
+
+    alignedMbits = benchFeed(data, BENCH_PACKETS * TS_PACKET_SIZE, BENCH_ALIGNED_CHUNK, totalBytes, &alignedStats);
+    unalignedMbits = benchFeed(data, BENCH_PACKETS * TS_PACKET_SIZE, BENCH_UNALIGNED_CHUNK, totalBytes, &unalignedStats);
+
+    /* both runs must see every section and no error */
+    if (alignedStats.sections != unalignedStats.sections || alignedStats.sections == 0 ||
+        alignedStats.syncErrors + unalignedStats.syncErrors + alignedStats.continuityErrors + unalignedStats.continuityErrors +
+        alignedStats.droppedSections + unalignedStats.droppedSections != 0)
+    {
+        printf("\nERROR demux runs disagree, sections %u/%u\n", alignedStats.sections, unalignedStats.sections);
+        return 1;
+    }
+
+    printf("sections per pass over multiplex: %u\n", alignedStats.sections);
+    printf("chunk      | Mbit/s   | x DVB-T2 %.1f Mbit/s\n", BENCH_DVBT2_MBITS);
+    printf("%-10u | %8.0f | %8.1f\n", BENCH_ALIGNED_CHUNK, alignedMbits, alignedMbits / BENCH_DVBT2_MBITS);
+    printf("%-10u | %8.0f | %8.1f\n", BENCH_UNALIGNED_CHUNK, unalignedMbits, unalignedMbits / BENCH_DVBT2_MBITS);
+
+    free(data);
+
+    return 0;
+}
+
+int32_t sectionCallback(uint8_t* buffer)
+{
+    benchSections++;
+
+    return 0;
+}
+
+/* Splits section into packets, rest of the last packet is stuffing */
+void packSection(BenchSectionStream* stream, uint16_t pid, const uint8_t* section, uint16_t length)
+{
+    uint8_t* packet;
+    uint16_t offset = 0;
+    uint16_t chunk;
+    uint8_t header;
+
+    memset(stream, 0x0, sizeof(BenchSectionStream));
+    while (offset < length)
+    {
+        packet = stream->packets[stream->packetCount++];
+        memset(packet, 0xFF, TS_PACKET_SIZE);
+        packet[0] = TS_SYNC_BYTE;
+        packet[1] = (offset == 0 ? 0x40 : 0x00) | (pid >> 8);
+        packet[2] = pid & 0xFF;
+        header = 4;
+        if (offset == 0)
+        {
+            /* pointer field */
+            packet[header++] = 0;
+        }
+        chunk = TS_PACKET_SIZE - header;
+        if (chunk > length - offset)
+        {
+            chunk = length - offset;
+        }
+        memcpy(packet + header, section + offset, chunk);
+        offset += chunk;
+    }
+}
+
+void putPacket(uint8_t* packet, BenchSectionStream* stream)
+{
+    memcpy(packet, stream->packets[stream->next], TS_PACKET_SIZE);
+    packet[3] = 0x10 | (stream->continuityCounter++ & 0x0F);
+    stream->next = (stream->next + 1) % stream->packetCount;
+}
+
+/* Returns Mbit/s of demux fed with totalBytes of multiplex in chunks, stats are of one pass over multiplex,
+ * sections are not counted if any later pass lost one
+ */
+double benchFeed(const uint8_t* data, uint32_t length, uint32_t chunk, uint64_t totalBytes, TsDemuxStats* stats)
+{
+    static TsDemux demux;
+    struct timespec startTime;
+    struct timespec endTime;
+    uint64_t processed = 0;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t passes = 0;
+    double seconds;
+
+    tsDemuxInit(&demux);
+    tsDemuxRegisterSectionCallback(&demux, sectionCallback);
+    tsDemuxAddFilter(&demux, BENCH_EIT_PID, 0x4E);
+    tsDemuxAddFilter(&demux, 0x00, 0x00);
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    while (processed < totalBytes)
+    {
+        for (offset = 0; offset < length; offset += size)
+        {
+            size = length - offset < chunk ? length - offset : chunk;
+            tsDemuxFeed(&demux, data + offset, size);
+        }
+        processed += length;
+        if (passes++ == 0)
+        {
+            tsDemuxGetStats(&demux, stats);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+    if (demux.stats.sections != passes * stats->sections || demux.stats.continuityErrors != 0)
+    {
+        stats->sections = 0;
+    }
+
+    tsDemuxDeinit(&demux);
+    seconds = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+
+    return processed * 8 / seconds / 1e6;
+}